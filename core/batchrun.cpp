@@ -0,0 +1,780 @@
+// ep128emu-core -- libretro core version of the ep128emu emulator
+// Copyright (C) 2022 Zoltan Balogh
+// https://github.com/zoltanvb/ep128emu-core
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// Batch driver for content verification: boots each title in its own
+// LibretroCore instance (the same content autodetection and machine setup
+// as retro_load_game()), runs it for a fixed number of frames without a
+// frontend, and prints a hash of the final frame and of the complete audio
+// output. Titles are processed by a pool of worker threads, each instance
+// is independent of the others and of the globals in main.cpp.
+//
+// Files with the extension .demo are demo recordings (VirtualMachine::
+// recordDemo() format, as saved by ep128emu or by the -record option),
+// these are played back instead of being started as content. Demo playback
+// is the recommended input for traces: it does not depend on the host
+// clock, and the input sequence does not change with the startup sequence
+// of the core.
+//
+// With -trace, the hash of the palette index data of each frame
+// (LibretroDisplay::getFrameHash()) and of the audio output of each frame
+// is written to DIR/FILE.trace, -check compares the same hashes against
+// previously written (golden) traces, and fails the title at the first
+// frame that differs, or if the number of frames run and traced differ.
+//
+// Usage: ep128emu_batch [OPTIONS] FILE...
+// Output (stdout), one line per title in input order:
+//   VIDEOHASH AUDIOHASH FRAMES FILE
+// VIDEOHASH and AUDIOHASH are "--------" if the title failed to load or
+// did not match its trace.
+//
+// With -compress, the files are not run, but compressed and decompressed
+// with compressData() and decompressData() (decompm2.hpp) in both modes,
+// which fails if the data does not round-trip, and prints the compressed
+// size and the compression and decompression times.
+
+#include "ep128emu.hpp"
+#include "system.hpp"
+#include "fileio.hpp"
+#include "core.hpp"
+#include "perfcnt.hpp"
+#include "decompm2.hpp"
+
+#include <cstdarg>
+#include <cstdlib>
+#include <vector>
+
+static retro_log_level minLogLevel = RETRO_LOG_WARN;
+
+static void batchLogCallback(enum retro_log_level level, const char *fmt, ...)
+{
+  if (level < minLogLevel)
+    return;
+  va_list va;
+  va_start(va, fmt);
+  std::vfprintf(stderr, fmt, va);
+  va_end(va);
+}
+
+// there is no frontend, the only input is the startup sequence of the core
+static int16_t batchInputStateCallback(unsigned port, unsigned device,
+                                       unsigned index, unsigned id)
+{
+  (void) port;
+  (void) device;
+  (void) index;
+  (void) id;
+  return 0;
+}
+
+static bool batchEnvironmentCallback(unsigned cmd, void *data)
+{
+  (void) cmd;
+  (void) data;
+  return false;
+}
+
+namespace Ep128Emu {
+
+  struct BatchJob {
+    std::string   fileName;
+    bool          isDone;
+    bool          isFailed;
+    uint32_t      videoHash;
+    uint32_t      audioHash;
+    unsigned int  nFrames;
+    BatchJob(const std::string& fileName_)
+      : fileName(fileName_),
+        isDone(false),
+        isFailed(false),
+        videoHash(0U),
+        audioHash(0U),
+        nFrames(0U)
+    {
+    }
+  };
+
+  class BatchJobList {
+   private:
+    std::vector< BatchJob > jobs;
+    size_t        nextJob;
+    size_t        nextOutput;
+    size_t        failedCnt;
+    Mutex         mutex_;
+   public:
+    std::string   systemDirectory;
+    // directories for writing traces, reading traces to compare against,
+    // and writing demo recordings; empty if not used
+    std::string   traceDirectory;
+    std::string   checkDirectory;
+    std::string   recordDirectory;
+    unsigned int  nFrames;
+    // run without video and audio output, all hashes are constant
+    bool          headless;
+    // pass video lines to the display thread instead of using palette
+    // index output (LibretroCore::set_index_output())
+    bool          lineQueue;
+    // Z80 profiler sample interval in instructions, 0 if not used
+    unsigned int  z80ProfilerInterval;
+    // ----------------
+    BatchJobList()
+      : nextJob(0),
+        nextOutput(0),
+        failedCnt(0),
+        systemDirectory("."),
+        traceDirectory(""),
+        checkDirectory(""),
+        recordDirectory(""),
+        nFrames(50U * 60U),
+        headless(false),
+        lineQueue(false),
+        z80ProfilerInterval(0U)
+    {
+    }
+    void addJob(const std::string& fileName)
+    {
+      jobs.push_back(BatchJob(fileName));
+    }
+    size_t getJobCnt() const
+    {
+      return jobs.size();
+    }
+    size_t getFailedCnt() const
+    {
+      return failedCnt;
+    }
+    // returns false if there are no more titles to run
+    bool getNextJob(size_t& n, BatchJob& job);
+    // store the result of job 'n', and print all results that are complete
+    // and have not been printed yet, in input order
+    void jobDone(size_t n, const BatchJob& result);
+  };
+
+  bool BatchJobList::getNextJob(size_t& n, BatchJob& job)
+  {
+    bool    retval = false;
+    mutex_.lock();
+    if (nextJob < jobs.size()) {
+      n = nextJob++;
+      job = jobs[n];
+      retval = true;
+    }
+    mutex_.unlock();
+    return retval;
+  }
+
+  void BatchJobList::jobDone(size_t n, const BatchJob& result)
+  {
+    mutex_.lock();
+    jobs[n] = result;
+    jobs[n].isDone = true;
+    if (result.isFailed)
+      failedCnt++;
+    while (nextOutput < jobs.size() && jobs[nextOutput].isDone) {
+      const BatchJob& j = jobs[nextOutput];
+      if (j.isFailed) {
+        std::printf("-------- -------- %6u %s\n",
+                    j.nFrames, j.fileName.c_str());
+      }
+      else {
+        std::printf("%08X %08X %6u %s\n",
+                    (unsigned int) j.videoHash, (unsigned int) j.audioHash,
+                    j.nFrames, j.fileName.c_str());
+      }
+      nextOutput++;
+    }
+    std::fflush(stdout);
+    mutex_.unlock();
+  }
+
+  // --------------------------------------------------------------------------
+
+  static bool isDemoFile(const std::string& fileName)
+  {
+    if (fileName.length() < 5)
+      return false;
+    std::string ext(fileName.substr(fileName.length() - 5));
+    stringToLowerCase(ext);
+    return (ext == ".demo");
+  }
+
+  // returns 'dir'/'fileName' without the path of 'fileName', with 'ext'
+  static std::string getOutputFileName(const std::string& dir,
+                                       const std::string& fileName,
+                                       const char *ext)
+  {
+    std::string path;
+    std::string baseName;
+    splitPath(fileName, path, baseName);
+    path = dir;
+    if (path.length() > 0) {
+      char    c = path[path.length() - 1];
+      if (!(c == '/' || c == '\\'))
+        path += '/';
+    }
+    return (path + baseName + ext);
+  }
+
+  // finds the machine type of a demo file from its VM configuration chunk
+  class DemoMachineProbe : public File::ChunkTypeHandler {
+   private:
+    File::ChunkType chunkType;
+    int           machineDetailedType;
+    int&          result;
+   public:
+    DemoMachineProbe(File::ChunkType chunkType_, const char *vmConfigName,
+                     int& result_)
+      : File::ChunkTypeHandler(),
+        chunkType(chunkType_),
+        machineDetailedType(VM_config.at(vmConfigName)),
+        result(result_)
+    {
+    }
+    virtual ~DemoMachineProbe()
+    {
+    }
+    virtual File::ChunkType getChunkType() const
+    {
+      return chunkType;
+    }
+    virtual void processChunk(File::Buffer& buf)
+    {
+      (void) buf;
+      result = machineDetailedType;
+    }
+  };
+
+  static void detectDemo(const std::string& fileName,
+                         LibretroCore_content& content)
+  {
+    content.machineDetailedType = VM_config.at("VM_CONFIG_UNKNOWN");
+    content.locale = LOCALE_UK;
+    content.tapeContent = false;
+    content.diskContent = false;
+    content.fileContent = false;
+    content.startupSequence = "";
+    content.configFile = "";
+    content.contentExt = "demo";
+    splitPath(fileName, content.contentPath, content.contentFile);
+    File    f(fileName.c_str());
+    int&    t = content.machineDetailedType;
+    f.registerChunkType(new DemoMachineProbe(
+                            File::EP128EMU_CHUNKTYPE_VM_CONFIG,
+                            "EP128_TAPE", t));
+    f.registerChunkType(new DemoMachineProbe(
+                            File::EP128EMU_CHUNKTYPE_ZXVM_CONFIG,
+                            "ZX128_TAPE", t));
+    f.registerChunkType(new DemoMachineProbe(
+                            File::EP128EMU_CHUNKTYPE_CPCVM_CONFIG,
+                            "CPC_TAPE", t));
+    f.registerChunkType(new DemoMachineProbe(
+                            File::EP128EMU_CHUNKTYPE_TVCVM_CONFIG,
+                            "TVC64_TAPE", t));
+    f.processAllChunks();
+    if (t == VM_config.at("VM_CONFIG_UNKNOWN"))
+      throw Exception("demo file has no machine configuration");
+  }
+
+  // per-frame video and audio hashes
+  static void readTrace(std::vector< uint32_t >& trace,
+                        const std::string& fileName)
+  {
+    trace.clear();
+    std::FILE *f = fileOpen(fileName.c_str(), "rb");
+    if (!f)
+      throw Exception("error opening trace file");
+    char    lineBuf[256];
+    while (std::fgets(&(lineBuf[0]), 256, f)) {
+      unsigned int  frameNum = 0U;
+      unsigned int  videoHash = 0U;
+      unsigned int  audioHash = 0U;
+      if (lineBuf[0] == '#')
+        continue;
+      if (std::sscanf(&(lineBuf[0]), "%u %x %x",
+                      &frameNum, &videoHash, &audioHash) != 3 ||
+          size_t(frameNum) != (trace.size() >> 1)) {
+        std::fclose(f);
+        throw Exception("invalid trace file");
+      }
+      trace.push_back(uint32_t(videoHash));
+      trace.push_back(uint32_t(audioHash));
+    }
+    std::fclose(f);
+  }
+
+  static void writeTrace(const std::vector< uint32_t >& trace,
+                         const std::string& fileName)
+  {
+    std::FILE *f = fileOpen(fileName.c_str(), "wb");
+    if (!f)
+      throw Exception("error opening trace file");
+    std::fprintf(f, "# FRAME VIDEOHASH AUDIOHASH\n");
+    for (size_t i = 0; (i + 1) < trace.size(); i += 2) {
+      std::fprintf(f, "%u %08X %08X\n", (unsigned int) (i >> 1),
+                   (unsigned int) trace[i], (unsigned int) trace[i + 1]);
+    }
+    if (std::fclose(f) != 0)
+      throw Exception("error writing trace file");
+  }
+
+  // --------------------------------------------------------------------------
+
+  class BatchWorker : public Thread {
+   private:
+    BatchJobList& jobList;
+    std::string   contentFileName;
+    std::vector< int16_t >  audioBuf;
+    std::vector< uint32_t > trace;
+    std::vector< uint32_t > goldenTrace;
+    static void fileNameCallback(void *userData, std::string& fileName);
+    static void cfgErrorCallback(void *userData, const char *msg);
+    void runJob(BatchJob& job, LibretroCore& core,
+                const LibretroCore_content& content, bool isDemo);
+   protected:
+    virtual void run();
+   public:
+    BatchWorker(BatchJobList& jobList_);
+    virtual ~BatchWorker();
+  };
+
+  BatchWorker::BatchWorker(BatchJobList& jobList_)
+    : Thread(),
+      jobList(jobList_),
+      contentFileName("")
+  {
+    audioBuf.resize(size_t(EP128EMU_SAMPLE_RATE) * 2);
+  }
+
+  BatchWorker::~BatchWorker()
+  {
+  }
+
+  void BatchWorker::fileNameCallback(void *userData, std::string& fileName)
+  {
+    fileName = reinterpret_cast< BatchWorker * >(userData)->contentFileName;
+  }
+
+  void BatchWorker::cfgErrorCallback(void *userData, const char *msg)
+  {
+    (void) userData;
+    std::fprintf(stderr, "WARNING: %s\n", msg);
+  }
+
+  void BatchWorker::runJob(BatchJob& job, LibretroCore& core,
+                           const LibretroCore_content& content, bool isDemo)
+  {
+    if (jobList.checkDirectory.length() > 0) {
+      readTrace(goldenTrace,
+                getOutputFileName(jobList.checkDirectory, job.fileName,
+                                  ".trace"));
+    }
+    // same content setup as retro_load_game(), without multi-disk support
+    EmulatorConfiguration&  config = *(core.config);
+    config.setErrorCallback(&cfgErrorCallback, (void *) this);
+    if (content.diskContent) {
+      config.floppy.a.imageFile = job.fileName;
+      config.floppyAChanged = true;
+    }
+    if (content.tapeContent) {
+      config.tape.imageFile = job.fileName;
+      config.tapeFileChanged = true;
+    }
+    if (content.fileContent) {
+      config.fileio.workingDirectory = content.contentPath;
+      contentFileName = content.contentPath + content.contentFile;
+      core.vm->setFileNameCallback(&fileNameCallback, (void *) this);
+      config.fileioSettingsChanged = true;
+      config.vm.enableFileIO = true;
+      config.vmConfigurationChanged = true;
+      if (content.machineDetailedType == VM_config.at("EP128_FILE_DTF")) {
+        std::string basename(content.contentFile);
+        stringToLowerCase(basename);
+        core.startSequence += basename + "\r";
+      }
+    }
+    config.applySettings();
+    // the demo is recorded until the end of the run, or until the first
+    // tape or disk access
+    File    demoFile;
+    bool    isRecording = (!isDemo && jobList.recordDirectory.length() > 0);
+    if (isRecording)
+      core.vm->recordDemo(demoFile);
+    // ZX tape is started at the end of the startup sequence
+    if (content.tapeContent &&
+        !(core.machineType == MACHINE_ZX || config.tape.forceMotorOn)) {
+      core.vm->tapePlay();
+    }
+    core.start();
+    if (isDemo) {
+      // same as retro_unserialize(), but with the VM thread stopped
+      File    f(job.fileName.c_str());
+      core.vmThread->lock(0x7FFFFFFF);
+      try {
+        core.vm->registerChunkTypes(f);
+        f.processAllChunks();
+        config.applySettings();
+      }
+      catch (...) {
+        core.vmThread->unlock();
+        throw;
+      }
+      core.vmThread->unlock();
+      if (!core.vm->getIsPlayingDemo())
+        throw Exception("no demo data in file");
+    }
+
+    // same sequence of calls as retro_run(), at a fixed 50 Hz frame rate
+    const retro_usec_t  frameTime = 1000000 / 50;
+    const int     expectedFrames =
+        int(float(frameTime * EP128EMU_SAMPLE_RATE) / 1000000.0f + 0.5f);
+    uint32_t      audioHash = 1U;
+    trace.clear();
+    if (jobList.z80ProfilerInterval)
+      core.set_z80_profiler(jobList.z80ProfilerInterval);
+    for (job.nFrames = 0U; job.nFrames < jobList.nFrames; job.nFrames++) {
+      core.update_input(&batchInputStateCallback, &batchEnvironmentCallback,
+                        0U);
+      core.run_for(frameTime, 0.0005f, (void *) 0);
+      size_t  nSamples = 0;
+      core.audioOutput->forwardAudioData(&(audioBuf.front()), &nSamples,
+                                         expectedFrames);
+      uint32_t  frameAudioHash = 0U;
+      if (nSamples > 0) {
+        frameAudioHash = File::hash_32(
+                             reinterpret_cast< unsigned char * >(
+                                 &(audioBuf.front())),
+                             nSamples * 2 * sizeof(int16_t));
+        audioHash = (audioHash * 0x01000193U) ^ frameAudioHash;
+      }
+      core.sync_display();
+      if (jobList.traceDirectory.length() > 0 ||
+          jobList.checkDirectory.length() > 0) {
+        trace.push_back(core.w ? core.w->getFrameHash() : 0U);
+        trace.push_back(frameAudioHash);
+        if (jobList.checkDirectory.length() > 0) {
+          size_t  n = trace.size() - 2;
+          const char  *errMsg = (char *) 0;
+          if (n >= goldenTrace.size())
+            errMsg = "trace ends before frame %u";
+          else if (trace[n] != goldenTrace[n])
+            errMsg = "video differs from trace at frame %u";
+          else if (trace[n + 1] != goldenTrace[n + 1])
+            errMsg = "audio differs from trace at frame %u";
+          if (errMsg) {
+            std::fprintf(stderr, "%s: ", job.fileName.c_str());
+            std::fprintf(stderr, errMsg, job.nFrames);
+            std::fprintf(stderr, "\n");
+            job.isFailed = true;
+            break;
+          }
+        }
+      }
+    }
+    if (jobList.checkDirectory.length() > 0 && !job.isFailed &&
+        trace.size() != goldenTrace.size()) {
+      std::fprintf(stderr, "%s: ran %u frames, trace has %u frames\n",
+                   job.fileName.c_str(), (unsigned int) (trace.size() >> 1),
+                   (unsigned int) (goldenTrace.size() >> 1));
+      job.isFailed = true;
+    }
+    if (jobList.z80ProfilerInterval) {
+      std::string buf;
+      core.vmThread->lock(0x7FFFFFFF);
+      core.vm->listZ80Profile(buf, 20);
+      core.vmThread->unlock();
+      std::fprintf(stderr, "%s:\n%s\n", job.fileName.c_str(), buf.c_str());
+    }
+    if (jobList.traceDirectory.length() > 0) {
+      writeTrace(trace,
+                 getOutputFileName(jobList.traceDirectory, job.fileName,
+                                   ".trace"));
+    }
+    if (isRecording) {
+      core.vm->stopDemo();
+      demoFile.writeFile(getOutputFileName(jobList.recordDirectory,
+                                           job.fileName, ".demo").c_str());
+    }
+    job.audioHash = audioHash;
+    if (core.w) {
+      job.videoHash =
+          File::hash_32(reinterpret_cast< unsigned char * >(
+                            core.w->frame_bufActive),
+                        core.w->frameSize);
+    }
+  }
+
+  void BatchWorker::run()
+  {
+    size_t    n = 0;
+    BatchJob  job("");
+    while (jobList.getNextJob(n, job)) {
+      LibretroCore  *core = (LibretroCore *) 0;
+      try {
+        LibretroCore_content  content;
+        bool    isDemo = isDemoFile(job.fileName);
+        if (isDemo) {
+          detectDemo(job.fileName, content);
+        }
+        else if (!detect_content(job.fileName.c_str(), content,
+                                 &batchLogCallback)) {
+          throw Exception("content format not recognized");
+        }
+        core = new LibretroCore(&batchLogCallback,
+                                content.machineDetailedType, content.locale,
+                                false,
+                                jobList.systemDirectory.c_str(),
+                                jobList.systemDirectory.c_str(),
+                                content.startupSequence.c_str(),
+                                content.configFile.c_str(), false, false,
+                                jobList.headless);
+        core->set_index_output(!jobList.lineQueue);
+        runJob(job, *core, content, isDemo);
+      }
+      catch (std::exception& e) {
+        std::fprintf(stderr, "%s: %s\n", job.fileName.c_str(), e.what());
+        job.isFailed = true;
+      }
+      if (core)
+        delete core;
+      jobList.jobDone(n, job);
+    }
+  }
+
+  // --------------------------------------------------------------------------
+
+  static void readInputFile(std::vector< unsigned char >& buf,
+                            const std::string& fileName)
+  {
+    buf.clear();
+    std::FILE *f = fileOpen(fileName.c_str(), "rb");
+    if (!f)
+      throw Exception("error opening input file");
+    unsigned char tmpBuf[4096];
+    size_t  n;
+    while ((n = std::fread(&(tmpBuf[0]), 1, 4096, f)) > 0)
+      buf.insert(buf.end(), &(tmpBuf[0]), &(tmpBuf[0]) + n);
+    std::fclose(f);
+  }
+
+  // Compresses the contents of 'fileName' with compressData() in the
+  // default and in the fast mode, with one and with four threads (so that
+  // the segment queue is used even on a single CPU), and checks that the
+  // output does not depend on the number of threads, and that
+  // decompressData() returns the original data. Prints the sizes and the
+  // best of three times of each mode, and returns false on error.
+  static bool runCompressTest(const std::string& fileName)
+  {
+    std::vector< unsigned char >  inBuf;
+    std::vector< unsigned char >  outBuf;
+    std::vector< unsigned char >  tmpBuf;
+    readInputFile(inBuf, fileName);
+    if (inBuf.size() < 1)
+      throw Exception("input file is empty");
+    Timer   t;
+    for (int fastMode = 0; fastMode < 2; fastMode++) {
+      double  compressTime = 1.0e9;
+      double  decompressTime = 1.0e9;
+      for (int i = 0; i < 3; i++) {
+        t.reset();
+        compressData(outBuf, &(inBuf.front()), inBuf.size(),
+                     bool(fastMode), 1);
+        double  tt = t.getRealTime();
+        compressTime = (tt < compressTime ? tt : compressTime);
+      }
+      compressData(tmpBuf, &(inBuf.front()), inBuf.size(), bool(fastMode),
+                   4);
+      if (tmpBuf != outBuf) {
+        std::fprintf(stderr, "%s: output depends on the number of threads\n",
+                     fileName.c_str());
+        return false;
+      }
+      for (int i = 0; i < 3; i++) {
+        t.reset();
+        decompressData(tmpBuf, &(outBuf.front()), outBuf.size());
+        double  tt = t.getRealTime();
+        decompressTime = (tt < decompressTime ? tt : decompressTime);
+      }
+      if (tmpBuf != inBuf) {
+        std::fprintf(stderr, "%s: decompressed data differs from input\n",
+                     fileName.c_str());
+        return false;
+      }
+      std::printf("%-7s %9u %9u %9.2f ms %8.2f ms %s\n",
+                  (fastMode ? "fast" : "default"),
+                  (unsigned int) inBuf.size(), (unsigned int) outBuf.size(),
+                  compressTime * 1000.0, decompressTime * 1000.0,
+                  fileName.c_str());
+    }
+    return true;
+  }
+
+}       // namespace Ep128Emu
+
+// ----------------------------------------------------------------------------
+
+static void printUsage(const char *prgName)
+{
+  std::fprintf(stderr,
+               "Usage: %s [OPTIONS] FILE...\n"
+               "Options:\n"
+               "    -frames N       run each title for N frames "
+               "(default: 3000)\n"
+               "    -threads N      number of emulator instances to run "
+               "in parallel\n"
+               "                    (default: 4)\n"
+               "    -system DIR     system directory with ep128emu/roms "
+               "and\n"
+               "                    ep128emu/config (default: .)\n"
+               "    -list FILE      read titles from FILE, one per line\n"
+               "    -trace DIR      write per-frame hashes to DIR/FILE.trace\n"
+               "    -check DIR      compare per-frame hashes against "
+               "DIR/FILE.trace\n"
+               "    -record DIR     record the input of each title to\n"
+               "                    DIR/FILE.demo\n"
+               "    -headless       run without video and audio output\n"
+               "    -linequeue      use the display thread for video "
+               "output\n"
+               "    -profile N      sample the Z80 program counter every N "
+               "instructions,\n"
+               "                    and print the 20 most frequent "
+               "addresses per title\n"
+               "    -v              print core log messages\n"
+               "    -compress       compress and decompress each FILE "
+               "instead of running it,\n"
+               "                    and print the sizes and times\n",
+               prgName);
+}
+
+int main(int argc, char **argv)
+{
+  Ep128Emu::BatchJobList  jobList;
+  int     nThreads = 4;
+  bool    compressTest = false;
+  try {
+    for (int i = 1; i < argc; i++) {
+      std::string arg(argv[i]);
+      bool    haveValue = ((i + 1) < argc);
+      if (arg == "-frames" && haveValue) {
+        int     n = std::atoi(argv[++i]);
+        if (n < 1)
+          throw Ep128Emu::Exception("invalid frame count");
+        jobList.nFrames = (unsigned int) n;
+      }
+      else if (arg == "-profile" && haveValue) {
+        int     n = std::atoi(argv[++i]);
+        if (n < 1)
+          throw Ep128Emu::Exception("invalid profiler sample interval");
+        jobList.z80ProfilerInterval = (unsigned int) n;
+      }
+      else if (arg == "-threads" && haveValue) {
+        nThreads = std::atoi(argv[++i]);
+        if (nThreads < 1 || nThreads > 256)
+          throw Ep128Emu::Exception("invalid number of threads");
+      }
+      else if (arg == "-system" && haveValue) {
+        jobList.systemDirectory = argv[++i];
+      }
+      else if (arg == "-trace" && haveValue) {
+        jobList.traceDirectory = argv[++i];
+      }
+      else if (arg == "-check" && haveValue) {
+        jobList.checkDirectory = argv[++i];
+      }
+      else if (arg == "-record" && haveValue) {
+        jobList.recordDirectory = argv[++i];
+      }
+      else if (arg == "-list" && haveValue) {
+        std::FILE *f = Ep128Emu::fileOpen(argv[++i], "rb");
+        if (!f)
+          throw Ep128Emu::Exception("error opening title list");
+        char    lineBuf[1024];
+        while (std::fgets(&(lineBuf[0]), 1024, f)) {
+          std::string s(&(lineBuf[0]));
+          while (s.length() > 0 &&
+                 (s[s.length() - 1] == '\n' || s[s.length() - 1] == '\r')) {
+            s.resize(s.length() - 1);
+          }
+          if (s.length() > 0)
+            jobList.addJob(s);
+        }
+        std::fclose(f);
+      }
+      else if (arg == "-headless") {
+        jobList.headless = true;
+      }
+      else if (arg == "-linequeue") {
+        jobList.lineQueue = true;
+      }
+      else if (arg == "-compress") {
+        compressTest = true;
+      }
+      else if (arg == "-v") {
+        minLogLevel = RETRO_LOG_DEBUG;
+      }
+      else if (arg.length() > 0 && arg[0] != '-') {
+        jobList.addJob(arg);
+      }
+      else {
+        printUsage(argv[0]);
+        return -1;
+      }
+    }
+    if (jobList.getJobCnt() < 1) {
+      printUsage(argv[0]);
+      return -1;
+    }
+    if (compressTest) {
+      size_t  n = 0;
+      Ep128Emu::BatchJob  job("");
+      int     retval = 0;
+      std::printf("MODE         SIZE COMPRSIZE    COMPRTIME "
+                  "DECOMPRTIME FILE\n");
+      while (jobList.getNextJob(n, job)) {
+        if (!Ep128Emu::runCompressTest(job.fileName))
+          retval = 1;
+      }
+      return retval;
+    }
+    if (size_t(nThreads) > jobList.getJobCnt())
+      nThreads = int(jobList.getJobCnt());
+    std::vector< Ep128Emu::BatchWorker * >  workers;
+    for (int i = 0; i < nThreads; i++)
+      workers.push_back(new Ep128Emu::BatchWorker(jobList));
+    for (int i = 0; i < nThreads; i++)
+      workers[i]->start();
+    for (int i = 0; i < nThreads; i++) {
+      workers[i]->join();
+      delete workers[i];
+    }
+    if (Ep128Emu::havePerfCounters()) {
+      // totals of all titles (see perfcnt.hpp)
+      Ep128Emu::PerfCounterStats  stats[Ep128Emu::PERF_COUNTER_CNT];
+      Ep128Emu::getPerfCounterStats(stats);
+      for (int i = 0; i < int(Ep128Emu::PERF_COUNTER_CNT); i++) {
+        std::fprintf(stderr, "%-20s %12llu calls %9.1f ms\n",
+                     stats[i].name, (unsigned long long) stats[i].calls,
+                     stats[i].totalTime * 1000.0);
+      }
+    }
+  }
+  catch (std::exception& e) {
+    std::fprintf(stderr, " *** error: %s\n", e.what());
+    return -1;
+  }
+  return (jobList.getFailedCnt() > 0 ? 1 : 0);
+}
+
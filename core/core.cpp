@@ -18,18 +18,20 @@
 
 #include "core.hpp"
 #include "libretro_keys_reverse.h"
-#include "roms/roms.hpp"
+#include "builtinrom.hpp"
 namespace Ep128Emu {
 
 LibretroCore::LibretroCore(retro_log_printf_t log_cb_, int machineDetailedType_, int contentLocale, bool canSkipFrames_, const char* romDirectory_, const char* saveDirectory_,
-                           const char* startSequence_, const char* cfgFile, bool useHalfFrame_, bool enhancedRom)
+                           const char* startSequence_, const char* cfgFile, bool useHalfFrame_, bool enhancedRom, bool headless_)
   : log_cb(log_cb_),
     autofireFrame(0),
     autofireButtonId(256),
     autofireFrameCycle(1),
+    videoCaptureMode(0),
     useHalfFrame(useHalfFrame_),
     isHalfFrame(useHalfFrame_),
     canSkipFrames(canSkipFrames_),
+    headless(headless_),
     joypadConfigChanged(false),
     prevFrameCount(0),
     startSequenceIndex(0),
@@ -43,7 +45,13 @@ LibretroCore::LibretroCore(retro_log_printf_t log_cb_, int machineDetailedType_,
     machineDetailedType(machineDetailedType_),
     totalTime(0),
     vmThread(NULL),
-    config(NULL)
+    w(NULL),
+    config(NULL),
+    vm(NULL),
+    audioOutput(NULL),
+    display(NULL),
+    nullDisplay(NULL),
+    indexBuffer(NULL)
 {
   std::string romBasePath(romDirectory_);
   std::string configBaseFile(romDirectory_);
@@ -87,32 +95,45 @@ LibretroCore::LibretroCore(retro_log_printf_t log_cb_, int machineDetailedType_,
     throw Ep128Emu::Exception("Machine configuration not recognized!");
   }
 
-  audioOutput = new Ep128Emu::AudioOutput_libretro();
-  //audioOutput->setOutputFile("/tmp/core_sound.wav");
-  w = new Ep128Emu::LibretroDisplay(32, 32, EP128EMU_LIBRETRO_SCREEN_WIDTH, EP128EMU_LIBRETRO_SCREEN_HEIGHT, "", useHalfFrame);
+  if (headless)
+  {
+    audioOutput = new Ep128Emu::AudioOutput_null();
+    nullDisplay = new Ep128Emu::NullDisplay();
+    display = nullDisplay;
+    log_cb(RETRO_LOG_INFO, "Headless mode, no video and audio output\n");
+  }
+  else
+  {
+    audioOutput = new Ep128Emu::AudioOutput_libretro();
+    //audioOutput->setOutputFile("/tmp/core_sound.wav");
+    w = new Ep128Emu::LibretroDisplay(32, 32, EP128EMU_LIBRETRO_SCREEN_WIDTH, EP128EMU_LIBRETRO_SCREEN_HEIGHT, "", useHalfFrame);
+    display = w;
+    indexBuffer = (unsigned char*) calloc(EP128EMU_LIBRETRO_SCREEN_WIDTH * EP128EMU_LIBRETRO_SCREEN_HEIGHT, sizeof(unsigned char));
+    w->setIndexBuffer(indexBuffer);
+  }
   if(machineType == MACHINE_TVC)
   {
-    vm = new TVC64::TVC64VM(*(dynamic_cast<Ep128Emu::VideoDisplay *>(w)),
+    vm = new TVC64::TVC64VM(*display,
                             *audioOutput);
   }
   else if (machineType == MACHINE_CPC)
   {
-    vm = new CPC464::CPC464VM(*(dynamic_cast<Ep128Emu::VideoDisplay *>(w)),
+    vm = new CPC464::CPC464VM(*display,
                               *audioOutput);
   }
   else if (machineType == MACHINE_ZX)
   {
-    vm = new ZX128::ZX128VM(*(dynamic_cast<Ep128Emu::VideoDisplay *>(w)),
+    vm = new ZX128::ZX128VM(*display,
                             *audioOutput);
   }
   else
   {
-    vm = new Ep128::Ep128VM(*(dynamic_cast<Ep128Emu::VideoDisplay *>(w)),
+    vm = new Ep128::Ep128VM(*display,
                             *audioOutput);
   }
   log_cb(RETRO_LOG_DEBUG, "VM created\n");
   config = new Ep128Emu::EmulatorConfiguration(
-    *vm, *(dynamic_cast<Ep128Emu::VideoDisplay *>(w)), *audioOutput
+    *vm, *display, *audioOutput
 #ifdef ENABLE_MIDI_PORT
     , *midiPort
 #endif
@@ -393,7 +414,8 @@ LibretroCore::LibretroCore(retro_log_printf_t log_cb_, int machineDetailedType_,
   config->sound.sampleRate = EP128EMU_SAMPLE_RATE_FLOAT;
   config->sound.hwPeriods = 16;
   //config->sound.swPeriods = 16;
-  //config->sound.enabled = false;
+  // sound disabled: the VM does not run the audio converter at all
+  config->sound.enabled = !headless;
   config->sound.highQuality = true;
   config->soundSettingsChanged = true;
 
@@ -477,9 +499,7 @@ LibretroCore::LibretroCore(retro_log_printf_t log_cb_, int machineDetailedType_,
           log_cb(RETRO_LOG_DEBUG, "ROM file or any alternative not found: %s \n",config->memory.rom[i].file.c_str());
           replacementFullName = "_default_" + romShortName;
           config->memory.rom[i].file = replacementFullName;
-          std::map<std::string, const unsigned char*>::const_iterator  iter_builtin_rom;
-          iter_builtin_rom = Ep128Emu::builtin_rom.find(replacementFullName);
-          if (iter_builtin_rom == Ep128Emu::builtin_rom.end()) {
+          if (!Ep128Emu::isBuiltinROM(replacementFullName)) {
             throw Ep128Emu::Exception("ROM file not found!");
           }
           log_cb(RETRO_LOG_DEBUG, "Using default ROM for: %s \n",config->memory.rom[i].file.c_str());
@@ -542,8 +562,12 @@ LibretroCore::~LibretroCore()
     delete config;
   if (audioOutput)
     delete audioOutput;
+  if (nullDisplay)
+    delete nullDisplay;
+  free(indexBuffer);
 }
 
+
 void LibretroCore::initialize_keyboard_map(void)
 {
   for(int i=0; i<RETROK_LAST; i++)
@@ -944,7 +968,7 @@ void LibretroCore::update_keyboard(bool down, unsigned keycode, uint32_t charact
   if (convertedKeycode >= 0)
   {
     vmThread->setKeyboardState((uint8_t)convertedKeycode,down);
-  } else if (down && keycode == RETROK_F12) {
+  } else if (down && keycode == RETROK_F12 && w) {
     w->scanBorders = true;
   }
   // TODO: if conversion does not succeed, try to apply literal mapping instead of default positional
@@ -993,7 +1017,7 @@ void LibretroCore::update_input(retro_input_state_t input_state_cb, retro_enviro
               message.frames = EP128EMU_MESSAGE_DISPLAY_FRAMES;
               environ_cb(RETRO_ENVIRONMENT_SET_MESSAGE, &message);
             }
-            if(i == EPKEY_ZOOM)
+            if(i == EPKEY_ZOOM && w)
             {
               w->scanBorders = true;
             }
@@ -1007,10 +1031,10 @@ void LibretroCore::update_input(retro_input_state_t input_state_cb, retro_enviro
         }
         // autofire - button is pressed already
         else if (inputJoyMap[i][port] == (int)autofireButtonId && inputStateMap[i][port] && currInputState) {
-          bool shouldFire =    (w->frameCount >= autofireFrame + 2*autofireFrameCycle) ? true        : false;
-          bool shouldRelease = (w->frameCount >= autofireFrame +   autofireFrameCycle) ? !shouldFire : false;
+          bool shouldFire =    (get_frame_count() >= autofireFrame + 2*autofireFrameCycle) ? true        : false;
+          bool shouldRelease = (get_frame_count() >= autofireFrame +   autofireFrameCycle) ? !shouldFire : false;
           if(shouldFire) {
-            autofireFrame = w->frameCount;
+            autofireFrame = get_frame_count();
             vmThread->setKeyboardState(i,true);
           }
           if(shouldRelease) {
@@ -1026,7 +1050,7 @@ void LibretroCore::update_input(retro_input_state_t input_state_cb, retro_enviro
   // Send keyboard input at specific frames (down presses)
   if (startSequenceIndex < startSequence.length())
   {
-    if (w->frameCount == (bootframes + startSequenceIndex*20))
+    if (get_frame_count() == (bootframes + startSequenceIndex*20))
     {
       // Double quote " is not available on the keyboard so it gets a special mapping
       // Generic solution was not designed as this startsequence is really limited
@@ -1051,7 +1075,7 @@ void LibretroCore::update_input(retro_input_state_t input_state_cb, retro_enviro
   // Send keyboard input at specific frames (key releases)
   if (startSequenceIndex <= startSequence.length())
   {
-    if (startSequenceIndex > 0 && w->frameCount == (bootframes + (startSequenceIndex-1)*20+10))
+    if (startSequenceIndex > 0 && get_frame_count() == (bootframes + (startSequenceIndex-1)*20+10))
     {
       if((unsigned char)startSequence.at(startSequenceIndex-1) == 254)
       {
@@ -1081,6 +1105,11 @@ void LibretroCore::update_input(retro_input_state_t input_state_cb, retro_enviro
 
 void LibretroCore::render(retro_video_refresh_t video_cb, retro_environment_t environ_cb)
 {
+  if (!w)
+  {
+    video_cb(NULL, 0, 0, 0);
+    return;
+  }
   // Transition from half frame (normal video mode) to interlaced
   if (useHalfFrame && isHalfFrame && w->interlacedFrameCount > 0)
   {
@@ -1194,6 +1223,16 @@ void LibretroCore::run_for(retro_usec_t frameTime, float waitPeriod, void * fb)
   //Ep128Emu::VMThread::VMThreadStatus  vmThreadStatus(*vmThread);
   //log_cb(RETRO_LOG_DEBUG, "Running core for %d ms\n",frameTime);
   totalTime += frameTime;
+  if (!w)
+  {
+    vmThread->allowRunFor(frameTime);
+    while (!vmThread->isReady())
+    {
+      if (waitPeriod > 0)
+        Timer::wait(waitPeriod);
+    }
+    return;
+  }
   // Direct framebuffer usage
   if(fb)
   {
@@ -1226,7 +1265,143 @@ void LibretroCore::run_for(retro_usec_t frameTime, float waitPeriod, void * fb)
 
 void LibretroCore::sync_display(void)
 {
+  if (w)
+    w->wakeDisplay(true);
+}
+
+void LibretroCore::set_index_output(bool enabled)
+{
+  if (!w || enabled == (w->getIndexBuffer() != NULL))
+    return;
+  vmThread->lock(0x7FFFFFFF);
   w->wakeDisplay(true);
+  w->setIndexBuffer(enabled ? indexBuffer : NULL);
+  vmThread->unlock();
+}
+
+void LibretroCore::set_z80_profiler(uint32_t interval)
+{
+  if (interval == vm->getZ80ProfilerInterval())
+    return;
+  vmThread->lock(0x7FFFFFFF);
+  vm->setZ80ProfilerInterval(interval);
+  vmThread->unlock();
+  if (!interval)
+    log_z80_profile();
+}
+
+void LibretroCore::log_z80_profile(void)
+{
+  std::vector< std::pair< uint32_t, uint32_t > > samples;
+  std::string buf;
+  vmThread->lock(0x7FFFFFFF);
+  size_t totalSamples = vm->getZ80Profile(samples);
+  vm->listZ80Profile(buf, 32);
+  vm->clearZ80Profile();
+  vmThread->unlock();
+  if (!totalSamples)
+    return;
+  log_cb(RETRO_LOG_INFO, "Z80 profile: %u samples at %u addresses\n",
+         (unsigned int) totalSamples, (unsigned int) samples.size());
+  size_t i = 0;
+  while (i < buf.length())
+  {
+    size_t j = buf.find('\n', i);
+    if (j == std::string::npos)
+      j = buf.length();
+    log_cb(RETRO_LOG_INFO, "%s\n", buf.substr(i, j - i).c_str());
+    i = j + 1;
+  }
+}
+
+void LibretroCore::set_video_capture(int mode, const char *directory)
+{
+  if (mode == videoCaptureMode)
+    return;
+  // also on errors, so that a failed attempt is not repeated on every frame
+  videoCaptureMode = mode;
+  if (mode && machineType == MACHINE_TVC)
+  {
+    log_cb(RETRO_LOG_WARN, "Video capture is not supported on this machine\n");
+    return;
+  }
+  vmThread->lock(0x7FFFFFFF);
+  try
+  {
+    // the output file is completed before the capture object is destroyed
+    vm->closeVideoCapture();
+    if (mode == 1 || mode == 2)
+    {
+      videoCaptureDirectory = (directory ? directory : "");
+      std::string fileName;
+      videoCaptureFileNameCallback(this, fileName);
+      if (fileName.empty())
+        throw Ep128Emu::Exception("no unused output file name");
+      vm->openVideoCapture(config->videoCapture.frameRate, (mode == 2),
+                           &videoCaptureErrorCallback,
+                           &videoCaptureFileNameCallback, this);
+      vm->setVideoCaptureFile(fileName);
+      log_cb(RETRO_LOG_INFO, "Recording video to %s\n", fileName.c_str());
+    }
+  }
+  catch (std::exception& e)
+  {
+    vm->closeVideoCapture();
+    log_cb(RETRO_LOG_ERROR, "Video capture error: %s\n", e.what());
+  }
+  vmThread->unlock();
+}
+
+void LibretroCore::set_sid_configuration(int model, bool highQuality)
+{
+  if (model == config->sid.model && highQuality == config->sid.highQuality)
+    return;
+  vmThread->lock(0x7FFFFFFF);
+  config->sid.model = model;
+  config->sid.highQuality = highQuality;
+  config->sidConfigurationChanged = true;
+  config->applySettings();
+  vmThread->unlock();
+}
+
+void LibretroCore::videoCaptureErrorCallback(void *userData, const char *msg)
+{
+  LibretroCore& core = *(reinterpret_cast<LibretroCore *>(userData));
+  core.log_cb(RETRO_LOG_ERROR, "Video capture error: %s\n", msg);
+}
+
+// also called by the video capture object when the file reaches 2 GB
+void LibretroCore::videoCaptureFileNameCallback(void *userData, std::string& fileName)
+{
+  LibretroCore& core = *(reinterpret_cast<LibretroCore *>(userData));
+  for (int i = 1; i < 10000; i++)
+  {
+    char tmpBuf[24];
+    std::snprintf(tmpBuf, sizeof(tmpBuf), "ep128emu_%04d.avi", i);
+    // without a save directory, the file is created in the working directory
+    fileName = core.videoCaptureDirectory;
+    if (!fileName.empty())
+    {
+      char c = fileName[fileName.length() - 1];
+      if (c != '/' && c != '\\')
+      {
+#ifdef WIN32
+        fileName += "\\";
+#else
+        fileName += "/";
+#endif
+      }
+    }
+    fileName += tmpBuf;
+    if (!Ep128Emu::does_file_exist(fileName.c_str()))
+      return;
+  }
+  fileName.clear();
+}
+
+uint32_t LibretroCore::get_frame_count()
+{
+  return (w ? w->frameCount : nullDisplay->frameCount);
 }
 
 void LibretroCore::errorCallback(void *userData, const char *msg)
@@ -1235,4 +1410,230 @@ void LibretroCore::errorCallback(void *userData, const char *msg)
   log_cb(RETRO_LOG_ERROR, "Core error callback: %s\n", msg);
 }
 
+static bool header_match(const char* buf1, const unsigned char* buf2, size_t length)
+{
+  for (size_t i = 0; i < length; i++)
+  {
+    if ((unsigned char)buf1[i] != buf2[i])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool zx_header_match(const unsigned char* buf2)
+{
+  // as per original spec, "13 00 00 00" would fit, but it doesn't always match
+  // https://sinclair.wiki.zxnet.co.uk/wiki/TAP_format
+  // empirical boundaries are from scanning the tosec collection
+  if (buf2[0]>0xe && buf2[0]<0x22 && buf2[1] == 0x0 && (buf2[2] == 0x0 || buf2[2] == 0xff))
+    return true;
+  return false;
+}
+
+bool detect_content(const char *fileName, LibretroCore_content& content, retro_log_printf_t log_cb)
+{
+  std::string filename(fileName);
+  std::string configFileExt(".ep128cfg");
+
+  content.machineDetailedType = VM_config.at("VM_CONFIG_UNKNOWN");
+  content.locale = LOCALE_UK;
+  content.tapeContent = false;
+  content.diskContent = false;
+  content.fileContent = false;
+  content.startupSequence = "";
+  content.configFile = "";
+  content.contentExt = "";
+
+  size_t idx = filename.rfind('.');
+  if(idx != std::string::npos)
+  {
+    content.contentExt = filename.substr(idx+1);
+    content.configFile = filename.substr(0,idx);
+    content.configFile += configFileExt;
+    stringToLowerCase(content.contentExt);
+  }
+  const std::string& contentExt = content.contentExt;
+  log_cb(RETRO_LOG_DEBUG, "Content extension: %s \n",contentExt.c_str());
+  splitPath(filename,content.contentPath,content.contentFile);
+
+  for(int i=1;i<LOCALE_AMOUNT;i++) {
+    idx = filename.rfind(locale_identifiers[i]);
+    if(idx != std::string::npos) {
+      content.locale = i;
+      log_cb(RETRO_LOG_INFO, "Locale detected: %s \n",locale_identifiers[i].c_str());
+      break;
+    }
+  }
+
+  if(content.configFile != "" && does_file_exist(content.configFile.c_str()))
+  {
+    log_cb(RETRO_LOG_INFO, "Content specific configuration file: %s \n",content.configFile.c_str());
+  }
+  else
+  {
+    content.configFile = "";
+    log_cb(RETRO_LOG_DEBUG, "No content specific config file exists\n");
+  }
+
+  std::string diskExt = "img";
+  std::string tapeExt = "tap";
+  std::string tapeExtEp = "ept";
+  std::string fileExtDtf = "dtf";
+  std::string fileExtTvc = "cas";
+  std::string diskExtTvc = "dsk";
+  //std::string tapeExtSnd = "notwav";
+  //std::string tapeExtZx = "tzx";
+  std::string fileExtZx = "tap";
+  std::string tapeExtCpc = "cdt";
+  std::string tapeExtTvc = "tvcwav";
+
+  std::FILE *imageFile;
+  const size_t nBytes = 64;
+  uint8_t tmpBuf[nBytes];
+  uint8_t tmpBufOffset128[nBytes];
+  uint8_t tmpBufOffset512[nBytes];
+  static const char zeroBytes[nBytes] = "\0";
+
+  imageFile = fileOpen(fileName, "rb");
+  if (!imageFile)
+  {
+    log_cb(RETRO_LOG_ERROR, "Cannot open game content file: %s\n",fileName);
+    return false;
+  }
+  std::fseek(imageFile, 0L, SEEK_SET);
+  if(std::fread(&(tmpBuf[0]), sizeof(uint8_t), nBytes, imageFile) != nBytes)
+  {
+    std::fclose(imageFile);
+    throw Exception("error reading game content file");
+  };
+  // TODO: handle seek / read failures
+  std::fseek(imageFile, 128L, SEEK_SET);
+  if(std::fread(&(tmpBufOffset128[0]), sizeof(uint8_t), nBytes, imageFile) != nBytes)
+  {
+    log_cb(RETRO_LOG_DEBUG, "Game content file too short for full header analysis\n");
+  };
+  std::fseek(imageFile, 512L, SEEK_SET);
+  if(std::fread(&(tmpBufOffset512[0]), sizeof(uint8_t), nBytes, imageFile) != nBytes)
+  {
+    log_cb(RETRO_LOG_DEBUG, "Game content file too short for full header analysis\n");
+  };
+  std::fclose(imageFile);
+
+  static const char *cpcDskFileHeader = "MV - CPCEMU";
+  static const char *cpcExtFileHeader = "EXTENDED CPC DSK File";
+  static const char *ep128emuTapFileHeader = "\x02\x75\xcd\x72\x1c\x44\x51\x26";
+  static const char *epteFileMagic = "ENTERPRISE 128K TAPE FILE       ";
+  static const char *TAPirFileMagic = "\x00\x6A\xFF";
+  static const char *waveFileMagic = "RIFF";
+  static const char *tzxFileMagic = "ZXTape!\032\001";
+  static const char *tvcDskFileHeader = "\xeb\xfe\x90";
+  static const char *epDskFileHeader1 = "\xeb\x3c\x90";
+  static const char *epDskFileHeader2 = "\xeb\x4c\x90";
+  static const char *epComFileHeader = "\x00\x05";
+  static const char *epComFileHeader2 = "\x00\x06";
+  static const char *epBasFileHeader = "\x00\x04";
+  static const char *mp3FileHeader1 = "\x49\x44\x33";
+  static const char *mp3FileHeader2 = "\xff\xfb";
+
+  // start with longer magic strings - less chance of mis-detection
+  if(header_match(cpcDskFileHeader,tmpBuf,11) or header_match(cpcExtFileHeader,tmpBuf,21))
+  {
+    content.machineDetailedType = VM_config.at("CPC_DISK");
+    content.diskContent=true;
+    content.startupSequence ="cat\r\xff\xff\xff\xff\xff\xffrun\xfe";
+  }
+  else if(header_match(tzxFileMagic,tmpBuf,9))
+  {
+    // if tzx format is called cdt, it is for CPC
+    if (contentExt == tapeExtCpc)
+    {
+      content.machineDetailedType = VM_config.at("CPC_TAPE");
+      content.tapeContent = true;
+      content.startupSequence ="run\xfe\r\r";
+    }
+    // TODO: replace with something else?
+    else if (contentExt == tapeExtEp)
+    {
+      content.machineDetailedType = VM_config.at("EP128_TAPE");
+      content.tapeContent=true;
+      content.startupSequence =" \xff\xff\xfd";
+    }
+    else
+    {
+      content.machineDetailedType = VM_config.at("ZX128_TAPE");
+      content.tapeContent = true;
+      content.startupSequence ="\r";
+    }
+  }
+  // tvcwav extension is made up, it is to avoid clash with normal wave file and also with retroarch's own wave player
+  else if(contentExt == tapeExtTvc && header_match(waveFileMagic,tmpBuf,4))
+  {
+    content.machineDetailedType = VM_config.at("TVC64_TAPE");
+    content.tapeContent=true;
+    content.startupSequence =" \xffload\r";
+  }
+  else if (contentExt == fileExtZx && zx_header_match(tmpBuf))
+  {
+    content.machineDetailedType = VM_config.at("ZX128_FILE");
+    content.fileContent=true;
+    content.startupSequence ="\r";
+  }
+  // All .tap files will fall back to be interpreted as EP128_TAPE
+  else if(header_match(epteFileMagic,tmpBufOffset128,32) || header_match(ep128emuTapFileHeader,tmpBuf,8) ||
+          header_match(waveFileMagic,tmpBuf,4) || header_match(TAPirFileMagic,tmpBufOffset512,3) ||
+          header_match(mp3FileHeader1,tmpBuf,3) || header_match(mp3FileHeader2,tmpBufOffset512,2) ||
+          contentExt == tapeExt )
+  {
+    content.machineDetailedType = VM_config.at("EP128_TAPE");
+    content.tapeContent=true;
+    content.startupSequence =" \xff\xff\xfd";
+  }
+  else if (contentExt == fileExtTvc && header_match(zeroBytes,&(tmpBuf[5]),nBytes-6))
+  {
+    content.machineDetailedType = VM_config.at("TVC64_FILE");
+    content.fileContent=true;
+    content.startupSequence =" \xffload\r";
+  }
+  // EP and TVC disks may have similar extensions
+  else if (contentExt == diskExt || contentExt == diskExtTvc)
+  {
+    if (header_match(tvcDskFileHeader,tmpBuf,3))
+    {
+      content.machineDetailedType = VM_config.at("TVC64_DISK");
+      content.diskContent=true;
+      // ext 2 - dir - esc - load"
+      content.startupSequence =" ext 2\r dir\r \x1bload\xfe";
+    }
+    else if (header_match(epDskFileHeader1,tmpBuf,3) || header_match(epDskFileHeader2,tmpBuf,3))
+    {
+      content.machineDetailedType = VM_config.at("EP128_DISK");
+      content.diskContent=true;
+    }
+    else {
+      log_cb(RETRO_LOG_ERROR, "Content format not recognized!\n");
+      return false;
+    }
+  }
+  else if (contentExt == fileExtDtf) {
+    content.machineDetailedType = VM_config.at("EP128_FILE_DTF");
+    content.fileContent=true;
+    content.startupSequence =" \xff\xff\xff\xff\xff:dl ";
+  }
+  // last resort: EP file, first 2 bytes
+  else if (header_match(epComFileHeader,tmpBuf,2) || header_match(epComFileHeader2,tmpBuf,2) || header_match(epBasFileHeader,tmpBuf,2))
+  {
+    content.machineDetailedType = VM_config.at("EP128_FILE");
+    content.fileContent=true;
+    content.startupSequence =" \xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xfd";
+  }
+  else
+  {
+    log_cb(RETRO_LOG_ERROR, "Content format not recognized!\n");
+    return false;
+  }
+  return true;
+}
+
 }       // namespace Ep128Emu
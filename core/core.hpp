@@ -263,6 +263,34 @@ const std::multimap<std::string, std::string> multidisk_replacements = {
 {"Side A"         , "Side B"},
 };
 
+// Result of content autodetection (see detect_content)
+struct LibretroCore_content
+{
+  int machineDetailedType;
+  int locale;
+  bool tapeContent;
+  bool diskContent;
+  bool fileContent;
+  // Startup sequence may contain:
+  // - chars on the keyboard (a-z, 0-9, few symbols like :
+  // - 0xff as wait character
+  // - 0xfe as "
+  // - 0xfd as F1 (START)
+  std::string startupSequence;
+  // content specific .ep128cfg file, empty if there is none
+  std::string configFile;
+  std::string contentPath;
+  std::string contentFile;
+  // lower case extension, without the dot
+  std::string contentExt;
+};
+
+// Detect machine type and content type from the header and the extension
+// of the content file, the same way for the libretro frontend and for other
+// drivers (like the batch runner). Returns false if the format is not
+// recognized. Only reads the file, does not use any global state.
+bool detect_content(const char *fileName, LibretroCore_content& content, retro_log_printf_t log_cb);
+
 class LibretroCore
 {
 private:
@@ -272,6 +300,12 @@ private:
   unsigned int autofireFrame;
   unsigned int autofireButtonId;
   unsigned int autofireFrameCycle;
+  // 0: not recording, 1: RLE8, 2: YV12, see set_video_capture()
+  int videoCaptureMode;
+  std::string videoCaptureDirectory;
+
+  static void videoCaptureErrorCallback(void *userData, const char *msg);
+  static void videoCaptureFileNameCallback(void *userData, std::string& fileName);
 
 public:
   uint16_t audioBuffer[EP128EMU_SAMPLE_RATE*1000*2];
@@ -280,6 +314,8 @@ public:
   bool useHalfFrame;
   bool isHalfFrame;
   bool canSkipFrames;
+  // no video and audio output, see NullDisplay and AudioOutput_null
+  bool headless;
   bool joypadConfigChanged;
   uint32_t prevFrameCount;
   size_t startSequenceIndex;
@@ -301,11 +337,16 @@ public:
   Ep128Emu::EmulatorConfiguration *config      ;
   Ep128Emu::VirtualMachine        *vm          ;
   Ep128Emu::AudioOutput           *audioOutput ;
+  // display used by the VM, either w or nullDisplay (w is NULL if headless)
+  Ep128Emu::VideoDisplay          *display     ;
+  Ep128Emu::NullDisplay           *nullDisplay ;
+  // palette index buffer of w, see LibretroDisplay::setIndexBuffer()
+  unsigned char                   *indexBuffer ;
 
   // ----------------
 
   LibretroCore(retro_log_printf_t log_cb_, int machineDetailedType, int contentLocale, bool canSkipFrames_, const char* romDirectory_, const char* saveDirectory_,
-  const char* startSequence_, const char* cfgFile, bool useHalfFrame, bool enhancedRom);
+  const char* startSequence_, const char* cfgFile, bool useHalfFrame, bool enhancedRom, bool headless_ = false);
   virtual ~LibretroCore();
 
   void initialize_keyboard_map(void);
@@ -317,6 +358,19 @@ public:
   void start(void);
   void run_for(retro_usec_t frameTime, float waitPeriod, void * fb);
   void sync_display();
+  // switch between palette index output (default) and queuing lines to the display thread
+  void set_index_output(bool enabled);
+  // sample the emulated Z80 program counter every 'interval' instructions,
+  // or stop the profiler (0); the results are logged when it is stopped
+  void set_z80_profiler(uint32_t interval);
+  void log_z80_profile(void);
+  // record video and sound to a new AVI file in 'directory' (mode 1: 768x576
+  // RLE8, 2: 384x288 YV12), or stop recording (0)
+  void set_video_capture(int mode, const char *directory);
+  // configure the SID card of the Enterprise (model 0: disabled, 1: MOS 6581,
+  // 2: MOS 8580), clocked in blocks unless 'highQuality' is true
+  void set_sid_configuration(int model, bool highQuality);
+  uint32_t get_frame_count();
   char* get_current_message(void);
   void update_input(retro_input_state_t input_state_cb, retro_environment_t environ_cb, unsigned maxUsers);
   void render(retro_video_refresh_t video_cb, retro_environment_t environ_cb);
@@ -116,6 +116,20 @@ struct retro_core_option_v2_definition option_defs_us[] = {
       },
       "0"
    },
+   {
+      "ep128emu_dvid",
+      "Direct palette index video output",
+      NULL,
+      "Decode video lines directly to a frame sized palette index buffer, instead of passing them to the display thread in compressed format. Lower overhead, same output.",
+      NULL,
+      "latency",
+      {
+         { "0",  "Off" },
+         { "1",  "On" },
+         { NULL, NULL },
+      },
+      "1"
+   },
    {
       "ep128emu_useh",
       "Enable resolution changes (requires restart)",
@@ -252,6 +266,66 @@ struct retro_core_option_v2_definition option_defs_us[] = {
       },
       "2"
    },
+   {
+      "ep128emu_prof",
+      "Z80 code profiler",
+      NULL,
+      "Sample the program counter of the emulated Z80 every N instructions, and write the most frequently executed addresses with disassembly to the log when the content is unloaded or the profiler is turned off.",
+      NULL,
+      "hacks",
+      {
+         { "0",  "Off" },
+         { "16",  "16" },
+         { "64",  "64" },
+         { "256",  "256" },
+         { NULL, NULL },
+      },
+      "0"
+   },
+   {
+      "ep128emu_vrec",
+      "Video capture",
+      NULL,
+      "Record the emulated video and sound to an AVI file in the save directory, until this option is turned off or the content is unloaded. The video is compressed and written by a separate thread.",
+      NULL,
+      "hacks",
+      {
+         { "0",  "Off" },
+         { "1",  "RLE8 768x576" },
+         { "2",  "YV12 384x288" },
+         { NULL, NULL },
+      },
+      "0"
+   },
+   {
+      "ep128emu_sidm",
+      "SID card",
+      NULL,
+      "Emulate a SID sound chip at I/O ports 0Eh (address) and 0Fh (data) of the Enterprise, using reSID. The emulation only runs after the first write to a SID register.",
+      NULL,
+      "hacks",
+      {
+         { "0",  "Off" },
+         { "1",  "MOS 6581" },
+         { "2",  "MOS 8580" },
+         { NULL, NULL },
+      },
+      "0"
+   },
+   {
+      "ep128emu_sidq",
+      "SID emulation quality",
+      NULL,
+      "Fast mode clocks the SID in blocks of cycles and interpolates its output, accurate mode clocks it on every cycle at a much higher CPU cost.",
+      NULL,
+      "hacks",
+      {
+         { "0",  "Fast" },
+         { "1",  "Accurate" },
+         { NULL, NULL },
+      },
+      "0"
+   },
 
    { NULL, NULL, NULL, NULL, NULL, NULL, {{0}}, NULL },
 };
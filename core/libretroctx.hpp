@@ -0,0 +1,159 @@
+// ep128emu-core -- libretro core version of the ep128emu emulator
+// Copyright (C) 2022 Zoltan Balogh
+// https://github.com/zoltanvb/ep128emu-core
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#ifndef EP128EMU_LIBRETROCTX_HPP
+#define EP128EMU_LIBRETROCTX_HPP
+
+#include "core.hpp"
+#include "perfcnt.hpp"
+
+#include <vector>
+
+#define MAX_DISK_COUNT 10
+
+namespace Ep128Emu {
+
+// State of one libretro frontend session: the core instance, the frontend
+// callbacks, the core options and the disk control state. The retro_*
+// entry points in main.cpp only look up the current context and forward
+// to the methods of the same name; applications embedding the core can
+// create any number of contexts and call the methods directly.
+class LibretroContext
+{
+private:
+  struct retro_log_callback logging;
+
+public:
+  retro_log_printf_t log_cb;
+  retro_environment_t environ_cb;
+  retro_video_refresh_t video_cb;
+  retro_audio_sample_t audio_cb;
+  retro_audio_sample_batch_t audio_batch_cb;
+  retro_input_poll_t input_poll_cb;
+  retro_input_state_t input_state_cb;
+  retro_set_led_state_t led_state_cb;
+
+  const char *retro_save_directory;
+  const char *retro_system_directory;
+  const char *retro_content_directory;
+  char retro_system_bios_directory[512];
+  char retro_system_save_directory[512];
+  std::vector<int16_t> audioBuffer;
+
+  std::string contentFileName;
+
+  // core options
+  retro_usec_t curr_frame_time;
+  float waitPeriod;
+  bool useSwFb;
+  bool directVideo;
+  bool useHalfFrame;
+  int borderSize;
+  bool soundHq;
+  bool canSkipFrames;
+  bool enhancedRom;
+  unsigned z80ProfilerInterval;
+  int videoCaptureMode;
+  int sidModel;
+  bool sidHighQuality;
+  // not a core option: set by embedding applications before load_game()
+  // to run without video and audio output (see LibretroCore::headless)
+  bool headless;
+
+  unsigned maxUsers;
+  bool maxUsersSupported;
+
+  // disk control interface
+  unsigned diskIndex;
+  unsigned diskIndexInitial;
+  unsigned diskCount;
+  std::string diskPaths[MAX_DISK_COUNT];
+  std::string diskNames[MAX_DISK_COUNT];
+  bool diskEjected;
+
+  bool tapeContent;
+  bool diskContent;
+  bool fileContent;
+
+  unsigned int retro_led_state[2];
+
+  // performance counters (see perfcnt.hpp): state at the last report
+  // written to log_cb
+  unsigned int perfReportFrames;
+  Ep128Emu::Timer perfReportTimer;
+  Ep128Emu::PerfCounterStats perfPrvStats[Ep128Emu::PERF_COUNTER_CNT];
+
+  Ep128Emu::VMThread              *vmThread;
+  Ep128Emu::EmulatorConfiguration *config;
+  Ep128Emu::LibretroCore          *core;
+
+  // ----------------
+
+  LibretroContext();
+  virtual ~LibretroContext();
+
+  void set_environment(retro_environment_t cb);
+  void init(void);
+  void deinit(void);
+  void get_system_av_info(struct retro_system_av_info *info);
+  void reset(void);
+  void run(void);
+  bool load_game(const struct retro_game_info *info);
+  void unload_game(void);
+  size_t serialize_size(void);
+  bool serialize(void *data_, size_t size);
+  bool unserialize(const void *data_, size_t size);
+  void set_controller_port_device(unsigned port, unsigned device);
+
+  void set_frame_time(retro_usec_t usec);
+  void update_keyboard(bool down, unsigned keycode, uint32_t character, uint16_t key_modifiers);
+
+  bool set_eject_state(bool ejected);
+  bool get_eject_state(void);
+  unsigned get_image_index(void);
+  bool set_image_index(unsigned index);
+  unsigned get_num_images(void);
+  bool replace_image_index(unsigned index, const struct retro_game_info *info);
+  bool add_image_index(void);
+  bool set_initial_image(unsigned index, const char *path);
+  bool get_image_path(unsigned index, char *path, size_t len);
+  bool get_image_label(unsigned index, char *label, size_t len);
+
+private:
+  void check_variables(void);
+  void update_led_interface(void);
+  void report_perf_counters(void);
+  void update_input(void);
+  void render(void);
+  void audio_callback_batch(void);
+  bool add_new_image_auto(const char *path);
+  void scan_multidisk_files(const char *path);
+  void delete_core(void);
+  static void fileNameCallback(void *userData, std::string& fileName);
+};
+
+// Context used by the retro_* entry points. It is created on first use;
+// embedding applications may install their own instance (which they keep
+// owning) before calling the entry points, or pass NULL to revert to the
+// default one.
+LibretroContext& getCurrentLibretroContext(void);
+void setCurrentLibretroContext(LibretroContext *ctx);
+
+}       // namespace Ep128Emu
+
+#endif  // EP128EMU_LIBRETROCTX_HPP
@@ -19,6 +19,8 @@
 #include "ep128emu.hpp"
 #include "system.hpp"
 #include "libretrodisp.hpp"
+#include "fileio.hpp"
+#include "perfcnt.hpp"
 
 namespace Ep128Emu
 {
@@ -88,6 +90,7 @@ uint16_t LibretroDisplay::Colormap::pixelConvRGB565(double r, double g, double b
 void LibretroDisplay::decodeLine(unsigned char *outBuf,
                                  const unsigned char *inBuf, size_t nBytes)
 {
+  EP128EMU_PERF_SCOPE(PERF_DISPLAY_DECODE, 4);
   const unsigned char *bufp = inBuf;
   unsigned char *endp = outBuf + 768;
   do
@@ -328,7 +331,16 @@ LibretroDisplay::getDisplayParameters() const
 void LibretroDisplay::drawLine(const uint8_t *buf, size_t nBytes)
 {
 
-  if (curLine >= 0 && curLine < (EP128EMU_LIBRETRO_SCREEN_HEIGHT + 2))
+  if (indexBuffer)
+  {
+    if (curLine >= 0 && curLine < EP128EMU_LIBRETRO_SCREEN_HEIGHT)
+    {
+      decodeLine(&(indexBuffer[curLine * EP128EMU_LIBRETRO_SCREEN_WIDTH]),
+                 buf, nBytes);
+      indexLinesValid[curLine] = true;
+    }
+  }
+  else if (curLine >= 0 && curLine < (EP128EMU_LIBRETRO_SCREEN_HEIGHT + 2))
   {
     Message_LineData  *m = allocateMessage<Message_LineData>();
     m->lineNum = curLine;
@@ -350,7 +362,13 @@ void LibretroDisplay::drawLine(const uint8_t *buf, size_t nBytes)
   {
     curLine = (oddFrame ? -1 : 0);
     vsyncCnt++;
-    frameDone();
+    if (indexBuffer)
+    {
+      draw(frame_bufActive, scanBorders);
+      scanBorders = false;
+    }
+    else
+      frameDone();
     frameCount++;
   }
 }
@@ -398,6 +416,10 @@ LibretroDisplay::LibretroDisplay(int xx, int yy, int ww, int hh,
         redrawFlag(false),
         prvFrameWasOdd(false),
         lastLineNum(-2),
+        indexBuffer((unsigned char *) 0),
+        indexLinesValid((bool *) 0),
+        syncRequestCnt(0U),
+        syncDoneCnt(0U),
 #ifdef EP128EMU_USE_XRGB8888
         frame_buf1((uint32_t *) 0),
 #else
@@ -436,6 +458,9 @@ LibretroDisplay::LibretroDisplay(int xx, int yy, int ww, int hh,
       delete[] linesChanged;
     throw;
   }
+  indexLinesValid = new bool[EP128EMU_LIBRETRO_SCREEN_HEIGHT];
+  for (size_t n = 0; n < EP128EMU_LIBRETRO_SCREEN_HEIGHT; n++)
+    indexLinesValid[n] = false;
   resetViewport();
 
 #ifdef EP128EMU_USE_XRGB8888
@@ -456,13 +481,65 @@ LibretroDisplay::LibretroDisplay(int xx, int yy, int ww, int hh,
 // Enable display processing. If sync is required, do not return until all input is processed.
 void LibretroDisplay::wakeDisplay(bool syncRequired)
 {
-  threadLock1.notify();
-  if (syncRequired)
+  if (!syncRequired)
   {
+    threadLock1.notify();
+    return;
+  }
+  // Wait for a pass of the display thread that started after this request,
+  // a notification left over from an earlier pass is not sufficient.
+  messageQueueMutex.lock();
+  uint32_t  n = ++syncRequestCnt;
+  messageQueueMutex.unlock();
+  while (true)
+  {
+    threadLock1.notify();
+    messageQueueMutex.lock();
+    bool  isDone = (int32_t(syncDoneCnt - n) >= 0);
+    messageQueueMutex.unlock();
+    if (isDone || exitFlag)
+      break;
     threadLock2.wait(10);
   }
 }
 
+// Hash of the palette index data, for comparing emulation results.
+uint32_t LibretroDisplay::getFrameHash(void)
+{
+  unsigned char buf[EP128EMU_LIBRETRO_SCREEN_WIDTH];
+  uint32_t  h = 1U;
+  for (int yc = 0; yc < EP128EMU_LIBRETRO_SCREEN_HEIGHT; yc++)
+  {
+    uint32_t  lineHash = 0U;
+    if (indexBuffer)
+    {
+      if (indexLinesValid[yc])
+      {
+        lineHash = File::hash_32(
+                       &(indexBuffer[yc * EP128EMU_LIBRETRO_SCREEN_WIDTH]),
+                       EP128EMU_LIBRETRO_SCREEN_WIDTH);
+      }
+    }
+    else if (lineBuffers[yc])
+    {
+      const unsigned char *bufp = (unsigned char *) 0;
+      size_t  nBytes = 0;
+      lineBuffers[yc]->getLineData(bufp, nBytes);
+      decodeLine(&(buf[0]), bufp, nBytes);
+      lineHash = File::hash_32(&(buf[0]), EP128EMU_LIBRETRO_SCREEN_WIDTH);
+    }
+    h = (h * 0x01000193U) ^ lineHash;
+  }
+  return h;
+}
+
+void LibretroDisplay::setIndexBuffer(unsigned char *buf)
+{
+  indexBuffer = buf;
+  for (size_t n = 0; n < EP128EMU_LIBRETRO_SCREEN_HEIGHT; n++)
+    indexLinesValid[n] = false;
+}
+
 void LibretroDisplay::resetViewport()
 {
   setViewport(0,0,EP128EMU_LIBRETRO_SCREEN_WIDTH-1,EP128EMU_LIBRETRO_SCREEN_HEIGHT-1);
@@ -514,6 +591,9 @@ void LibretroDisplay::run()
     if (exitFlag) break;
     frameDone = false;
     threadLock1.wait(10);
+    messageQueueMutex.lock();
+    uint32_t  syncCnt = syncRequestCnt;
+    messageQueueMutex.unlock();
     do
     {
       frameDone = checkEvents();
@@ -524,6 +604,9 @@ void LibretroDisplay::run()
       }
     }
     while (frameDone);
+    messageQueueMutex.lock();
+    syncDoneCnt = syncCnt;
+    messageQueueMutex.unlock();
     threadLock2.notify();
   }
 }
@@ -631,6 +714,7 @@ LibretroDisplay::~LibretroDisplay()
     }
   }
   delete[] lineBuffers;
+  delete[] indexLinesValid;
 }
 
 void LibretroDisplay::limitFrameRate(bool isEnabled)
@@ -640,6 +724,7 @@ void LibretroDisplay::limitFrameRate(bool isEnabled)
 
 void LibretroDisplay::draw(void * fb, bool scanForBorder)
 {
+  EP128EMU_PERF_SCOPE(PERF_DISPLAY_DRAW, 0);
   int borderColor = 0;
   int firstNonzeroLine   = EP128EMU_LIBRETRO_SCREEN_HEIGHT;
   int firstNonzeroCol    = EP128EMU_LIBRETRO_SCREEN_WIDTH;
@@ -661,21 +746,31 @@ void LibretroDisplay::draw(void * fb, bool scanForBorder)
     if (!interlacedFrameCount && (yc & 1)) continue;
     // Skip any display if not within viewport (inclusive).
     if (yc < viewPortY1 || yc > viewPortY2) continue;
-    if (lineBuffers[yc])
+    const unsigned char *linePixels = (unsigned char *) 0;
+    if (indexBuffer)
+    {
+      if (indexLinesValid[yc])
+        linePixels = &(indexBuffer[yc * EP128EMU_LIBRETRO_SCREEN_WIDTH]);
+    }
+    else if (lineBuffers[yc])
     {
       // decode video data
       const unsigned char *bufp = (unsigned char *) 0;
       size_t  nBytes = 0;
-      bool nonzero = false;
-      bool nonborder = false;
       lineBuffers[yc]->getLineData(bufp, nBytes);
       decodeLine(lineBuf,bufp,nBytes);
+      linePixels = lineBuf;
+    }
+    if (linePixels)
+    {
+      bool nonzero = false;
+      bool nonborder = false;
 
       for(int i=0; i<EP128EMU_LIBRETRO_SCREEN_WIDTH; i++)
       {
         // Skip any display if not within viewport (inclusive).
         if (i<viewPortX1 || i>viewPortX2) continue;
-        unsigned char pixelValue = lineBuf[i];
+        unsigned char pixelValue = linePixels[i];
 
 #ifdef EP128EMU_USE_XRGB8888
         uint32_t pixelResult = colormap(pixelValue);
@@ -768,5 +863,64 @@ void LibretroDisplay::draw(void * fb, bool scanForBorder)
   }
 }
 
+// --------------------------------------------------------------------------
+
+NullDisplay::NullDisplay()
+  : VideoDisplay(),
+    vsyncCnt(0),
+    vsyncState(false),
+    displayParameters(),
+    frameCount(0)
+{
+}
+
+NullDisplay::~NullDisplay()
+{
+}
+
+void NullDisplay::setDisplayParameters(const DisplayParameters& dp)
+{
+  displayParameters = dp;
+}
+
+const VideoDisplay::DisplayParameters& NullDisplay::getDisplayParameters() const
+{
+  return displayParameters;
+}
+
+// Same frame detection as LibretroDisplay::drawLine(), so that frame counts
+// (and the startup sequence timing based on them) match.
+void NullDisplay::drawLine(const uint8_t *buf, size_t nBytes)
+{
+  (void) buf;
+  (void) nBytes;
+  if (vsyncCnt != 0)
+  {
+    if (vsyncCnt >= (EP128EMU_VSYNC_MIN_LINES + 2 - EP128EMU_VSYNC_OFFSET) &&
+        (vsyncState || vsyncCnt >= (EP128EMU_VSYNC_MAX_LINES
+                                    + 2 - EP128EMU_VSYNC_OFFSET)))
+    {
+      vsyncCnt = 2 - EP128EMU_VSYNC_OFFSET;
+    }
+    vsyncCnt++;
+  }
+  else
+  {
+    vsyncCnt++;
+    frameCount++;
+  }
+}
+
+void NullDisplay::vsyncStateChange(bool newState, unsigned int currentSlot_)
+{
+  (void) currentSlot_;
+  vsyncState = newState;
+  if (newState &&
+      vsyncCnt >= (EP128EMU_VSYNC_MIN_LINES + 2 - EP128EMU_VSYNC_OFFSET))
+  {
+    vsyncCnt = 2 - EP128EMU_VSYNC_OFFSET;
+  }
+}
+
 }       // namespace Ep128Emu
 
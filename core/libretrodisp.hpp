@@ -197,6 +197,14 @@ namespace Ep128Emu {
     bool          prvFrameWasOdd;
     int           lastLineNum;
     bool          *linesChanged;
+    // palette index output mode (see setIndexBuffer()), NULL if not used
+    unsigned char *indexBuffer;
+    // lines of indexBuffer written since it was set, for 576 lines
+    bool          *indexLinesValid;
+    // wakeDisplay(true) requests / completed passes of the display thread,
+    // protected by messageQueueMutex
+    uint32_t      syncRequestCnt;
+    uint32_t      syncDoneCnt;
    public:
 #ifdef EP128EMU_USE_XRGB8888
     uint32_t *frame_buf1;
@@ -274,13 +282,58 @@ namespace Ep128Emu {
      */
     virtual void limitFrameRate(bool isEnabled);
     virtual void draw(void* fb, bool scanForBorder);
+    /*!
+     * Wake up the display thread. If 'syncRequired' is true, do not return
+     * until all lines and frames queued so far have been processed, and
+     * the frame buffer contains the last completed frame.
+     */
     void wakeDisplay(bool syncRequired);
+    /*!
+     * Returns a hash of the decoded palette index data of all lines
+     * received so far, independently of the color format, viewport and
+     * border settings. Should only be called after wakeDisplay(true),
+     * while the emulation is not running.
+     */
+    uint32_t getFrameHash(void);
+    /*!
+     * Set a buffer of EP128EMU_LIBRETRO_SCREEN_WIDTH *
+     * EP128EMU_LIBRETRO_SCREEN_HEIGHT bytes to use palette index output
+     * mode, or NULL to revert to the default mode. In the default mode,
+     * each line is copied to a message for the display thread, which
+     * decodes it when drawing the frame. In palette index output mode,
+     * drawLine() decodes lines directly to the buffer, and the frame is
+     * converted to the frame buffer by the emulation thread at the end of
+     * the frame, without using the display thread. The buffer is owned by
+     * the caller, and should only be changed while the emulation is not
+     * running.
+     */
+    void setIndexBuffer(unsigned char *buf);
+    unsigned char *getIndexBuffer(void) const
+    {
+      return indexBuffer;
+    }
     void resetViewport(void);
     bool setViewport(int x1, int y1, int x2, int y2);
     bool isViewportDefault(void);
 
   };
 
+  // Display that only counts frames the same way as LibretroDisplay, without
+  // storing or converting any video data, and without a display thread.
+  class NullDisplay : public VideoDisplay {
+   private:
+    int           vsyncCnt;
+    bool          vsyncState;
+    DisplayParameters   displayParameters;
+   public:
+    uint32_t frameCount;
+    NullDisplay();
+    virtual ~NullDisplay();
+    virtual void setDisplayParameters(const DisplayParameters& dp);
+    virtual const DisplayParameters& getDisplayParameters() const;
+    virtual void drawLine(const uint8_t *buf, size_t nBytes);
+    virtual void vsyncStateChange(bool newState, unsigned int currentSlot_);
+  };
 
 }       // namespace Ep128Emu
 
@@ -148,5 +148,29 @@ namespace Ep128Emu {
     AudioOutput::closeDevice();
   }
 
+  // --------------------------------------------------------------------------
+
+  AudioOutput_null::AudioOutput_null()
+    : AudioOutput()
+  {
+  }
+
+  AudioOutput_null::~AudioOutput_null()
+  {
+  }
+
+  void AudioOutput_null::sendAudioData(const int16_t *buf, size_t nFrames)
+  {
+    (void) buf;
+    (void) nFrames;
+  }
+
+  void AudioOutput_null::forwardAudioData(int16_t *buf_out, size_t* nFrames, int expectedFrames)
+  {
+    (void) buf_out;
+    (void) expectedFrames;
+    *nFrames = 0;
+  }
+
 }       // namespace Ep128Emu
 
@@ -55,6 +55,17 @@ class AudioOutput_libretro : public AudioOutput {
     virtual void forwardAudioData(int16_t *buf_out, size_t* nFrames, int expectedFrames);
     virtual void closeDevice();
   };
+
+  // Audio output that discards all data, for running without a frontend.
+  // Normally used with sound disabled in the configuration, so that the
+  // VM does not convert audio at all.
+  class AudioOutput_null : public AudioOutput {
+   public:
+    AudioOutput_null();
+    virtual ~AudioOutput_null();
+    virtual void sendAudioData(const int16_t *buf, size_t nFrames);
+    virtual void forwardAudioData(int16_t *buf_out, size_t* nFrames, int expectedFrames);
+  };
 }       // namespace Ep128Emu
 
 #endif  // EP128EMU_LIBRETROSND_HPP
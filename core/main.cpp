@@ -79,61 +79,167 @@ led driver for tape loading - see comments inside
 #include "libretro-funcs.hpp"
 #include "libretrodisp.hpp"
 #include "core.hpp"
+#include "libretroctx.hpp"
 #include "libretro_core_options.h"
 #ifdef WIN32
 #include <windows.h>
 #endif // WIN32
 
-static struct retro_log_callback logging;
-static retro_log_printf_t log_cb;
-static retro_environment_t environ_cb;
-
-const char *retro_save_directory;
-const char *retro_system_directory;
-const char *retro_content_directory;
-char retro_system_data_directory[512];
-char retro_system_bios_directory[512];
-char retro_system_save_directory[512];
-char retro_content_filepath[512];
-uint16_t audioBuffer[EP128EMU_SAMPLE_RATE*1000*2];
-
-std::string contentFileName="";
-
-retro_usec_t curr_frame_time = 0;
-retro_usec_t prev_frame_time = 0;
-float waitPeriod = 0.001;
-bool useSwFb = false;
-bool useHalfFrame = false;
-int borderSize = 0;
-bool soundHq = true;
-bool canSkipFrames = false;
-bool enhancedRom = false;
-
-unsigned maxUsers;
-bool maxUsersSupported = true;
-
-unsigned diskIndex = 0;
-unsigned diskIndexInitial = 0;
-unsigned diskCount = 1;
-#define MAX_DISK_COUNT 10
-std::string diskPaths[MAX_DISK_COUNT];
-std::string diskNames[MAX_DISK_COUNT];
-bool diskEjected = false;
-
-bool tapeContent = false;
-bool diskContent = false;
-bool fileContent = false;
-
-Ep128Emu::VMThread              *vmThread    = (Ep128Emu::VMThread *) 0;
-Ep128Emu::EmulatorConfiguration *config      = (Ep128Emu::EmulatorConfiguration *) 0;
-Ep128Emu::LibretroCore          *core        = (Ep128Emu::LibretroCore *) 0;
-
-static retro_video_refresh_t video_cb;
-static retro_audio_sample_t audio_cb;
-static retro_audio_sample_batch_t audio_batch_cb;
-static retro_input_poll_t input_poll_cb;
-static retro_input_state_t input_state_cb;
-static retro_set_led_state_t led_state_cb;
+using Ep128Emu::LibretroContext;
+
+namespace Ep128Emu {
+
+static LibretroContext *defaultContext = (LibretroContext *) 0;
+static LibretroContext *currentContext = (LibretroContext *) 0;
+
+LibretroContext& getCurrentLibretroContext(void)
+{
+  if (!currentContext)
+  {
+    if (!defaultContext)
+      defaultContext = new LibretroContext();
+    currentContext = defaultContext;
+  }
+  return *currentContext;
+}
+
+void setCurrentLibretroContext(LibretroContext *ctx)
+{
+  currentContext = ctx;
+}
+
+}       // namespace Ep128Emu
+
+// Callbacks registered with the frontend carry no user data,
+// these only look up the context and forward the call.
+
+static void set_frame_time_cb(retro_usec_t usec)
+{
+  Ep128Emu::getCurrentLibretroContext().set_frame_time(usec);
+}
+
+static void update_keyboard_cb(bool down, unsigned keycode,
+                               uint32_t character, uint16_t key_modifiers)
+{
+  Ep128Emu::getCurrentLibretroContext().update_keyboard(down, keycode, character, key_modifiers);
+}
+
+static bool set_eject_state_cb(bool ejected)
+{
+  return Ep128Emu::getCurrentLibretroContext().set_eject_state(ejected);
+}
+
+static bool get_eject_state_cb(void)
+{
+  return Ep128Emu::getCurrentLibretroContext().get_eject_state();
+}
+
+static unsigned get_image_index_cb(void)
+{
+  return Ep128Emu::getCurrentLibretroContext().get_image_index();
+}
+
+static bool set_image_index_cb(unsigned index)
+{
+  return Ep128Emu::getCurrentLibretroContext().set_image_index(index);
+}
+
+static unsigned get_num_images_cb(void)
+{
+  return Ep128Emu::getCurrentLibretroContext().get_num_images();
+}
+
+static bool replace_image_index_cb(unsigned index,
+      const struct retro_game_info *info)
+{
+  return Ep128Emu::getCurrentLibretroContext().replace_image_index(index, info);
+}
+
+static bool add_image_index_cb(void)
+{
+  return Ep128Emu::getCurrentLibretroContext().add_image_index();
+}
+
+static bool set_initial_image_cb(unsigned index, const char *path)
+{
+  return Ep128Emu::getCurrentLibretroContext().set_initial_image(index, path);
+}
+
+static bool get_image_path_cb(unsigned index, char *path, size_t len)
+{
+  return Ep128Emu::getCurrentLibretroContext().get_image_path(index, path, len);
+}
+
+static bool get_image_label_cb(unsigned index, char *label, size_t len)
+{
+  return Ep128Emu::getCurrentLibretroContext().get_image_label(index, label, len);
+}
+
+LibretroContext::LibretroContext()
+  : log_cb(NULL),
+    environ_cb(NULL),
+    video_cb(NULL),
+    audio_cb(NULL),
+    audio_batch_cb(NULL),
+    input_poll_cb(NULL),
+    input_state_cb(NULL),
+    led_state_cb(NULL),
+    retro_save_directory(NULL),
+    retro_system_directory(NULL),
+    retro_content_directory(NULL),
+    contentFileName(""),
+    curr_frame_time(0),
+    waitPeriod(0.001),
+    useSwFb(false),
+    directVideo(true),
+    useHalfFrame(false),
+    borderSize(0),
+    soundHq(true),
+    canSkipFrames(false),
+    enhancedRom(false),
+    z80ProfilerInterval(0),
+    videoCaptureMode(0),
+    sidModel(0),
+    sidHighQuality(false),
+    headless(false),
+    maxUsers(0),
+    maxUsersSupported(true),
+    diskIndex(0),
+    diskIndexInitial(0),
+    diskCount(1),
+    diskEjected(false),
+    tapeContent(false),
+    diskContent(false),
+    fileContent(false),
+    perfReportFrames(0),
+    vmThread(NULL),
+    config(NULL),
+    core(NULL)
+{
+  memset(perfPrvStats, 0, sizeof(perfPrvStats));
+  retro_system_bios_directory[0] = '\0';
+  retro_system_save_directory[0] = '\0';
+  retro_led_state[0] = 0;
+  retro_led_state[1] = 0;
+  // enough for one second, more than any single frame can return
+  audioBuffer.resize(EP128EMU_SAMPLE_RATE*2);
+}
+
+LibretroContext::~LibretroContext()
+{
+  delete_core();
+}
+
+void LibretroContext::delete_core(void)
+{
+  if (core)
+  {
+    delete core;
+    core = (Ep128Emu::LibretroCore *) 0;
+    vmThread = (Ep128Emu::VMThread *) 0;
+    config = (Ep128Emu::EmulatorConfiguration *) 0;
+  }
+}
 
 static void fallback_log(enum retro_log_level level, const char *fmt, ...)
 {
@@ -150,13 +256,12 @@ static void cfgErrorFunc(void *userData, const char *msg)
   std::fprintf(stderr, "WARNING: %s\n", msg);
 }
 
-static void fileNameCallback(void *userData, std::string& fileName)
+void LibretroContext::fileNameCallback(void *userData, std::string& fileName)
 {
-  (void) userData;
-  fileName = contentFileName;
+  fileName = reinterpret_cast<LibretroContext *>(userData)->contentFileName;
 }
 
-void set_frame_time_cb(retro_usec_t usec)
+void LibretroContext::set_frame_time(retro_usec_t usec)
 {
   if (usec == 0 || usec > 2*1000000/50)
   {
@@ -166,13 +271,11 @@ void set_frame_time_cb(retro_usec_t usec)
   {
     curr_frame_time = usec;
   }
-  prev_frame_time = curr_frame_time;
 
 }
 
 /* LED interface */
-static unsigned int retro_led_state[2] = {0};
-static void update_led_interface(void)
+void LibretroContext::update_led_interface(void)
 {
 
    unsigned int led_state[2] = {0};
@@ -201,14 +304,14 @@ static void update_led_interface(void)
    }
 }
 
-static void update_keyboard_cb(bool down, unsigned keycode,
-                               uint32_t character, uint16_t key_modifiers)
+void LibretroContext::update_keyboard(bool down, unsigned keycode,
+                                      uint32_t character, uint16_t key_modifiers)
 {
   if(keycode != RETROK_UNKNOWN && core)
     core->update_keyboard(down,keycode,character,key_modifiers);
 }
 
-static void check_variables(void)
+void LibretroContext::check_variables(void)
 {
   struct retro_variable var =
   {
@@ -225,6 +328,14 @@ static void check_variables(void)
     useSwFb = std::atoi(var.value) == 1 ? true : false;
   }
 
+  var.key = "ep128emu_dvid";
+  if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+  {
+    directVideo = std::atoi(var.value) == 1 ? true : false;
+    if (core)
+      core->set_index_output(directVideo);
+  }
+
   var.key = "ep128emu_sdhq";
   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
   {
@@ -263,6 +374,34 @@ static void check_variables(void)
     else { enhancedRom = false;}
   }
 
+  var.key = "ep128emu_prof";
+  if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+  {
+    z80ProfilerInterval = std::atoi(var.value);
+    if(core)
+      core->set_z80_profiler(z80ProfilerInterval);
+  }
+
+  var.key = "ep128emu_vrec";
+  if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+  {
+    videoCaptureMode = std::atoi(var.value);
+  }
+
+  var.key = "ep128emu_sidm";
+  if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+  {
+    sidModel = std::atoi(var.value);
+  }
+
+  var.key = "ep128emu_sidq";
+  if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+  {
+    sidHighQuality = std::atoi(var.value) == 1 ? true : false;
+  }
+  if (core)
+    core->set_sid_configuration(sidModel, sidHighQuality);
+
   std::string zoomKey;
   var.key = "ep128emu_zoom";
   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
@@ -311,14 +450,14 @@ static void check_variables(void)
 
 /* If ejected is true, "ejects" the virtual disk tray.
  */
-static bool set_eject_state_cb(bool ejected) {
+bool LibretroContext::set_eject_state(bool ejected) {
   log_cb(RETRO_LOG_DEBUG, "Disk control: eject (%d)\n",ejected?1:0);
   diskEjected = ejected;
   return true;
 }
 
 /* Gets current eject state. The initial state is 'not ejected'. */
-static bool get_eject_state_cb(void) {
+bool LibretroContext::get_eject_state(void) {
 //  log_cb(RETRO_LOG_DEBUG, "Disk control: get eject status (%d)\n",diskEjected?1:0);
   return diskEjected;
 }
@@ -326,14 +465,14 @@ static bool get_eject_state_cb(void) {
 /* Gets current disk index. First disk is index 0.
  * If return value is >= get_num_images(), no disk is currently inserted.
  */
-static unsigned get_image_index_cb(void) {
+unsigned LibretroContext::get_image_index(void) {
 //  log_cb(RETRO_LOG_DEBUG, "Disk control: get image index (%d)\n",diskIndex);
   return diskIndex;
 }
 
 /* Sets image index. Can only be called when disk is ejected.
  */
-static bool set_image_index_cb(unsigned index) {
+bool LibretroContext::set_image_index(unsigned index) {
   log_cb(RETRO_LOG_DEBUG, "Disk control: change image to (%d)\n",index);
   if (index>=diskCount) {
     diskIndex = diskCount + 1;
@@ -366,12 +505,12 @@ static bool set_image_index_cb(unsigned index) {
 }
 
 /* Gets total number of images which are available to use. */
-static unsigned get_num_images_cb(void) {return diskCount;}
+unsigned LibretroContext::get_num_images(void) {return diskCount;}
 
 /* Replaces the disk image associated with index.
  * Arguments to pass in info have same requirements as retro_load_game().
  */
-static bool replace_image_index_cb(unsigned index,
+bool LibretroContext::replace_image_index(unsigned index,
       const struct retro_game_info *info) {
 
   log_cb(RETRO_LOG_DEBUG, "Disk control: replace image index (%d) to %s\n",index,info->path);
@@ -386,7 +525,7 @@ static bool replace_image_index_cb(unsigned index,
  * This will increment subsequent return values from get_num_images() by 1.
  * This image index cannot be used until a disk image has been set
  * with replace_image_index. */
-static bool add_image_index_cb(void) {
+bool LibretroContext::add_image_index(void) {
   log_cb(RETRO_LOG_DEBUG, "Disk control: add image index (current %d)\n",diskCount);
   if (diskCount >= MAX_DISK_COUNT) return false;
   diskCount++;
@@ -398,7 +537,7 @@ static bool add_image_index_cb(void) {
  * Returns 'false' if index or 'path' are invalid, or core
  * does not support this functionality
  */
-static bool set_initial_image_cb(unsigned index, const char *path) {
+bool LibretroContext::set_initial_image(unsigned index, const char *path) {
   log_cb(RETRO_LOG_DEBUG, "Disk control: set initial image index to %d\n",diskCount);
   diskIndexInitial = index;
   return true;
@@ -408,7 +547,7 @@ static bool set_initial_image_cb(unsigned index, const char *path) {
  * Returns 'false' if index is invalid (index >= get_num_images())
  * or path is otherwise unavailable.
  */
-static bool get_image_path_cb(unsigned index, char *path, size_t len) {
+bool LibretroContext::get_image_path(unsigned index, char *path, size_t len) {
   if (index >= diskCount) return false;
   if(diskPaths[index].length() > 0)
   strncpy(path, diskPaths[index].c_str(), len);
@@ -421,7 +560,7 @@ static bool get_image_path_cb(unsigned index, char *path, size_t len) {
  * Returns 'false' if index is invalid (index >= get_num_images())
  * or label is otherwise unavailable.
  */
-static bool get_image_label_cb(unsigned index, char *label, size_t len) {
+bool LibretroContext::get_image_label(unsigned index, char *label, size_t len) {
   if(index >= diskCount) return false;
   if(diskNames[index].length() > 0)
   strncpy(label, diskNames[index].c_str(), len);
@@ -429,7 +568,7 @@ static bool get_image_label_cb(unsigned index, char *label, size_t len) {
   return true;
 }
 
-static bool add_new_image_auto(const char *path) {
+bool LibretroContext::add_new_image_auto(const char *path) {
 
   unsigned index = diskCount;
   if (diskCount >= MAX_DISK_COUNT) return false;
@@ -442,7 +581,7 @@ static bool add_new_image_auto(const char *path) {
   return true;
 }
 
-static void scan_multidisk_files(const char *path) {
+void LibretroContext::scan_multidisk_files(const char *path) {
 
   std::string filename(path);
   std::string filePrefix;
@@ -472,7 +611,7 @@ static void scan_multidisk_files(const char *path) {
 
 
 
-void retro_init(void)
+void LibretroContext::init(void)
 {
   struct retro_log_callback log;
 
@@ -611,7 +750,8 @@ void retro_init(void)
   timeBeginPeriod(1U);
 #endif
   log_cb(RETRO_LOG_DEBUG, "Creating core...\n");
-  core = new Ep128Emu::LibretroCore(log_cb, Ep128Emu::VM_config.at("EP128_DISK"), Ep128Emu::LOCALE_UK, canSkipFrames, retro_system_bios_directory, retro_system_save_directory,"","",useHalfFrame, enhancedRom);
+  core = new Ep128Emu::LibretroCore(log_cb, Ep128Emu::VM_config.at("EP128_DISK"), Ep128Emu::LOCALE_UK, canSkipFrames, retro_system_bios_directory, retro_system_save_directory,"","",useHalfFrame, enhancedRom, headless);
+  core->set_index_output(directVideo);
   config = core->config;
   config->setErrorCallback(&cfgErrorFunc, (void *) 0);
   vmThread = core->vmThread;
@@ -624,7 +764,7 @@ void retro_init(void)
   else if (core->machineDetailedType == Ep128Emu::VM_config.at("EP128_FILE")) {
     fileContent = true;
     log_cb(RETRO_LOG_DEBUG, "File content override\n");
-    core->vm->setFileNameCallback(&fileNameCallback, NULL);
+    core->vm->setFileNameCallback(&fileNameCallback, (void *) this);
     config->fileioSettingsChanged = true;
     config->vm.enableFileIO=true;
     config->vmConfigurationChanged = true;
@@ -641,31 +781,12 @@ void retro_init(void)
   core->change_resolution(core->currWidth,core->currHeight,environ_cb);
 }
 
-void retro_deinit(void)
-{
-  if (core)
-  {
-    delete core;
-    core = (Ep128Emu::LibretroCore *) 0;
-    vmThread = (Ep128Emu::VMThread *) 0;
-    config = (Ep128Emu::EmulatorConfiguration *) 0;
-  }
-}
-
-void retro_get_system_info(struct retro_system_info *info)
+void LibretroContext::deinit(void)
 {
-  memset(info, 0, sizeof(*info));
-  info->library_name     = "ep128emu";
-  info->library_version  = "v1.2.10";
-  info->need_fullpath    = true;
-#ifndef EXCLUDE_SOUND_LIBS
-  info->valid_extensions = "img|dsk|tap|dtf|com|trn|128|bas|cas|cdt|tzx|wav|tvcwav|mp3|.";
-#else
-  info->valid_extensions = "img|dsk|tap|dtf|com|trn|128|bas|cas|cdt|tzx|wav|tvcwav|.";
-#endif // EXCLUDE_SOUND_LIBS
+  delete_core();
 }
 
-void retro_get_system_av_info(struct retro_system_av_info *info)
+void LibretroContext::get_system_av_info(struct retro_system_av_info *info)
 {
   float aspect = 4.0f / 3.0f;
   aspect = 4.0f / (3.0f / (float) (core->isHalfFrame ? EP128EMU_LIBRETRO_SCREEN_HEIGHT/2/(float)core->currHeight : EP128EMU_LIBRETRO_SCREEN_HEIGHT/(float)core->currHeight));
@@ -686,7 +807,7 @@ void retro_get_system_av_info(struct retro_system_av_info *info)
   };
 }
 
-void retro_set_environment(retro_environment_t cb)
+void LibretroContext::set_environment(retro_environment_t cb)
 {
   environ_cb = cb;
 
@@ -717,43 +838,18 @@ void retro_set_environment(retro_environment_t cb)
   libretro_set_core_options(environ_cb,&categories_supported);
 }
 
-void retro_set_audio_sample(retro_audio_sample_t cb)
-{
-  audio_cb = cb;
-}
-
-void retro_set_audio_sample_batch(retro_audio_sample_batch_t cb)
-{
-  audio_batch_cb = cb;
-}
-
-void retro_set_input_poll(retro_input_poll_t cb)
-{
-  input_poll_cb = cb;
-}
-
-void retro_set_input_state(retro_input_state_t cb)
-{
-  input_state_cb = cb;
-}
-
-void retro_set_video_refresh(retro_video_refresh_t cb)
-{
-  video_cb = cb;
-}
-
-void retro_reset(void)
+void LibretroContext::reset(void)
 {
   if(vmThread) vmThread->reset(true);
 }
 
-static void update_input(void)
+void LibretroContext::update_input(void)
 {
   input_poll_cb();
   core->update_input(input_state_cb, environ_cb, maxUsers);
 }
 
-static void render(void)
+void LibretroContext::render(void)
 {
   core->render(video_cb, environ_cb);
 }
@@ -764,24 +860,27 @@ static void audio_callback(void)
     audio_cb(0, 0);
 }
 */
-static void audio_callback_batch(void)
+void LibretroContext::audio_callback_batch(void)
 {
   size_t nFrames=0;
   int exp = int(float(curr_frame_time*EP128EMU_SAMPLE_RATE)/1000000.0f+0.5f);
 
-  core->audioOutput->forwardAudioData((int16_t*)audioBuffer,&nFrames,exp);
+  core->audioOutput->forwardAudioData(&(audioBuffer.front()),&nFrames,exp);
   //printf("sending frames: %d exp %d frame_time: %d\n",nFrames,exp, curr_frame_time);
   //if (nFrames != exp)
   // printf("sending diff frames: %d exp %d frame_time: %d\n",nFrames,exp, curr_frame_time);
-  audio_batch_cb((int16_t*)audioBuffer, nFrames);
+  audio_batch_cb(&(audioBuffer.front()), nFrames);
 }
 
-void retro_run(void)
+void LibretroContext::run(void)
 {
 
   bool updated = false;
   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE, &updated) && updated)
     check_variables();
+  // started here rather than in check_variables(), so that no file is
+  // created for the core that load_game() replaces before running it
+  core->set_video_capture(videoCaptureMode, retro_system_save_directory);
 
   void *buf = NULL;
   if (useSwFb)
@@ -807,31 +906,34 @@ void retro_run(void)
    /* LED interface */
    if (led_state_cb)
       update_led_interface();
+#ifdef EP128EMU_PERF_COUNTERS
+  if (++perfReportFrames >= 500)
+    report_perf_counters();
+#endif
 }
 
-bool header_match(const char* buf1, const unsigned char* buf2, size_t length)
+// Log the counts and estimated times of the instrumented functions since
+// the previous report, and the share of the elapsed real time they took.
+void LibretroContext::report_perf_counters(void)
 {
-  for (size_t i = 0; i < length; i++)
+  Ep128Emu::PerfCounterStats stats[Ep128Emu::PERF_COUNTER_CNT];
+  Ep128Emu::getPerfCounterStats(stats);
+  double elapsedTime = perfReportTimer.getRealTime();
+  perfReportTimer.reset();
+  perfReportFrames = 0;
+  log_cb(RETRO_LOG_INFO, "Performance counters (last %.1f s):\n", elapsedTime);
+  for (int i = 0; i < int(Ep128Emu::PERF_COUNTER_CNT); i++)
   {
-    if ((unsigned char)buf1[i] != buf2[i])
-    {
-      return false;
-    }
+    uint64_t calls = stats[i].calls - perfPrvStats[i].calls;
+    double t = stats[i].totalTime - perfPrvStats[i].totalTime;
+    log_cb(RETRO_LOG_INFO, "  %-20s %12llu calls %9.1f ms %5.1f%%\n",
+           stats[i].name, (unsigned long long) calls, t * 1000.0,
+           elapsedTime > 0.0 ? t * 100.0 / elapsedTime : 0.0);
+    perfPrvStats[i] = stats[i];
   }
-  return true;
 }
 
-bool zx_header_match(const unsigned char* buf2)
-{
-  // as per original spec, "13 00 00 00" would fit, but it doesn't always match
-  // https://sinclair.wiki.zxnet.co.uk/wiki/TAP_format
-  // empirical boundaries are from scanning the tosec collection
-  if (buf2[0]>0xe && buf2[0]<0x22 && buf2[1] == 0x0 && (buf2[2] == 0x0 || buf2[2] == 0xff))
-    return true;
-  return false;
-}
-
-bool retro_load_game(const struct retro_game_info *info)
+bool LibretroContext::load_game(const struct retro_game_info *info)
 {
 
 #ifdef EP128EMU_USE_XRGB8888
@@ -852,228 +954,29 @@ bool retro_load_game(const struct retro_game_info *info)
   check_variables();
   if(info != nullptr)
   {
-    if (core)
-    {
-      delete core;
-      core = (Ep128Emu::LibretroCore *) 0;
-      vmThread = (Ep128Emu::VMThread *) 0;
-      config = (Ep128Emu::EmulatorConfiguration *) 0;
-    }
+    delete_core();
     log_cb(RETRO_LOG_INFO, "Loading game: %s \n",info->path);
+    Ep128Emu::LibretroCore_content content;
+    if (!Ep128Emu::detect_content(info->path, content, log_cb))
+      return false;
     std::string filename(info->path);
-    std::string contentExt;
-    std::string contentPath;
-    std::string contentFile;
-    std::string contentBasename;
-    std::string configFile;
-    std::string configFileExt(".ep128cfg");
-
-    size_t idx = filename.rfind('.');
-    if(idx != std::string::npos)
-    {
-      contentExt = filename.substr(idx+1);
-      configFile = filename.substr(0,idx);
-      configFile += configFileExt;
-      Ep128Emu::stringToLowerCase(contentExt);
-    }
-    else
-    {
-      contentExt=""; // No extension found
-    }
-    log_cb(RETRO_LOG_DEBUG, "Content extension: %s \n",contentExt.c_str());
-    Ep128Emu::splitPath(filename,contentPath,contentFile);
-    contentBasename = contentFile;
+    std::string contentPath(content.contentPath);
+    std::string contentFile(content.contentFile);
+    std::string contentBasename(contentFile);
     diskPaths[0] = filename;
     diskNames[0] = contentBasename;
     Ep128Emu::stringToLowerCase(contentBasename);
-
-    int contentLocale = Ep128Emu::LOCALE_UK;
-    for(int i=1;i<Ep128Emu::LOCALE_AMOUNT;i++) {
-      idx = filename.rfind(Ep128Emu::locale_identifiers[i]);
-      if(idx != std::string::npos) {
-        contentLocale = i;
-        log_cb(RETRO_LOG_INFO, "Locale detected: %s \n",Ep128Emu::locale_identifiers[i].c_str());
-        break;
-      }
-    }
-
-    if(Ep128Emu::does_file_exist(configFile.c_str()))
-    {
-      log_cb(RETRO_LOG_INFO, "Content specific configuration file: %s \n",configFile.c_str());
-    }
-    else
-    {
-      configFile = "";
-      log_cb(RETRO_LOG_DEBUG, "No content specific config file exists\n");
-    }
-
-    std::string diskExt = "img";
-    std::string tapeExt = "tap";
-    std::string tapeExtEp = "ept";
-    std::string fileExtDtf = "dtf";
-    std::string fileExtTvc = "cas";
-    std::string diskExtTvc = "dsk";
-    //std::string tapeExtSnd = "notwav";
-    //std::string tapeExtZx = "tzx";
-    std::string fileExtZx = "tap";
-    std::string tapeExtCpc = "cdt";
-    std::string tapeExtTvc = "tvcwav";
-
-    std::FILE *imageFile;
-    const size_t nBytes = 64;
-    uint8_t tmpBuf[nBytes];
-    uint8_t tmpBufOffset128[nBytes];
-    uint8_t tmpBufOffset512[nBytes];
-    static const char zeroBytes[nBytes] = "\0";
-
-    imageFile = Ep128Emu::fileOpen(info->path, "rb");
-    std::fseek(imageFile, 0L, SEEK_SET);
-    if(std::fread(&(tmpBuf[0]), sizeof(uint8_t), nBytes, imageFile) != nBytes)
-    {
-      throw Ep128Emu::Exception("error reading game content file");
-    };
-    // TODO: handle seek / read failures
-    std::fseek(imageFile, 128L, SEEK_SET);
-    if(std::fread(&(tmpBufOffset128[0]), sizeof(uint8_t), nBytes, imageFile) != nBytes)
-    {
-      log_cb(RETRO_LOG_DEBUG, "Game content file too short for full header analysis\n");
-    };
-    std::fseek(imageFile, 512L, SEEK_SET);
-    if(std::fread(&(tmpBufOffset512[0]), sizeof(uint8_t), nBytes, imageFile) != nBytes)
-    {
-      log_cb(RETRO_LOG_DEBUG, "Game content file too short for full header analysis\n");
-    };
-    std::fclose(imageFile);
-
-    static const char *cpcDskFileHeader = "MV - CPCEMU";
-    static const char *cpcExtFileHeader = "EXTENDED CPC DSK File";
-    static const char *ep128emuTapFileHeader = "\x02\x75\xcd\x72\x1c\x44\x51\x26";
-    static const char *epteFileMagic = "ENTERPRISE 128K TAPE FILE       ";
-    static const char *TAPirFileMagic = "\x00\x6A\xFF";
-    static const char *waveFileMagic = "RIFF";
-    static const char *tzxFileMagic = "ZXTape!\032\001";
-    static const char *tvcDskFileHeader = "\xeb\xfe\x90";
-    static const char *epDskFileHeader1 = "\xeb\x3c\x90";
-    static const char *epDskFileHeader2 = "\xeb\x4c\x90";
-    static const char *epComFileHeader = "\x00\x05";
-    static const char *epComFileHeader2 = "\x00\x06";
-    static const char *epBasFileHeader = "\x00\x04";
-    static const char *mp3FileHeader1 = "\x49\x44\x33";
-    static const char *mp3FileHeader2 = "\xff\xfb";
-    // Startup sequence may contain:
-    // - chars on the keyboard (a-z, 0-9, few symbols like :
-    // - 0xff as wait character
-    // - 0xfe as "
-    // - 0xfd as F1 (START)
-    const char* startupSequence = "";
-    tapeContent = false;
-    diskContent = false;
-    fileContent = false;
-    int detectedMachineDetailedType = Ep128Emu::VM_config.at("VM_CONFIG_UNKNOWN");
-
-    // start with longer magic strings - less chance of mis-detection
-    if(header_match(cpcDskFileHeader,tmpBuf,11) or header_match(cpcExtFileHeader,tmpBuf,21))
-    {
-      detectedMachineDetailedType = Ep128Emu::VM_config.at("CPC_DISK");
-      diskContent=true;
-      startupSequence ="cat\r\xff\xff\xff\xff\xff\xffrun\xfe";
-    }
-    else if(header_match(tzxFileMagic,tmpBuf,9))
-    {
-      // if tzx format is called cdt, it is for CPC
-      if (contentExt == tapeExtCpc)
-      {
-        detectedMachineDetailedType = Ep128Emu::VM_config.at("CPC_TAPE");
-        tapeContent = true;
-        startupSequence ="run\xfe\r\r";
-      }
-      // TODO: replace with something else?
-      else if (contentExt == tapeExtEp)
-      {
-        detectedMachineDetailedType = Ep128Emu::VM_config.at("EP128_TAPE");
-        tapeContent=true;
-        startupSequence =" \xff\xff\xfd";
-      }
-      else
-      {
-        detectedMachineDetailedType = Ep128Emu::VM_config.at("ZX128_TAPE");
-        tapeContent = true;
-        startupSequence ="\r";
-      }
-    }
-    // tvcwav extension is made up, it is to avoid clash with normal wave file and also with retroarch's own wave player
-    else if(contentExt == tapeExtTvc && header_match(waveFileMagic,tmpBuf,4))
-    {
-      detectedMachineDetailedType = Ep128Emu::VM_config.at("TVC64_TAPE");
-      tapeContent=true;
-      startupSequence =" \xffload\r";
-    }
-    else if (contentExt == fileExtZx && zx_header_match(tmpBuf))
-    {
-      detectedMachineDetailedType = Ep128Emu::VM_config.at("ZX128_FILE");
-      fileContent=true;
-      startupSequence ="\r";
-    }
-    // All .tap files will fall back to be interpreted as EP128_TAPE
-    else if(header_match(epteFileMagic,tmpBufOffset128,32) || header_match(ep128emuTapFileHeader,tmpBuf,8) ||
-            header_match(waveFileMagic,tmpBuf,4) || header_match(TAPirFileMagic,tmpBufOffset512,3) ||
-            header_match(mp3FileHeader1,tmpBuf,3) || header_match(mp3FileHeader2,tmpBufOffset512,2) ||
-            contentExt == tapeExt )
-    {
-      detectedMachineDetailedType = Ep128Emu::VM_config.at("EP128_TAPE");
-      tapeContent=true;
-      startupSequence =" \xff\xff\xfd";
-    }
-    else if (contentExt == fileExtTvc && header_match(zeroBytes,&(tmpBuf[5]),nBytes-6))
-    {
-      detectedMachineDetailedType = Ep128Emu::VM_config.at("TVC64_FILE");
-      fileContent=true;
-      startupSequence =" \xffload\r";
-    }
-    // EP and TVC disks may have similar extensions
-    else if (contentExt == diskExt || contentExt == diskExtTvc)
-    {
-      if (header_match(tvcDskFileHeader,tmpBuf,3))
-      {
-        detectedMachineDetailedType = Ep128Emu::VM_config.at("TVC64_DISK");
-        diskContent=true;
-        // ext 2 - dir - esc - load"
-        startupSequence =" ext 2\r dir\r \x1bload\xfe";
-      }
-      else if (header_match(epDskFileHeader1,tmpBuf,3) || header_match(epDskFileHeader2,tmpBuf,3))
-      {
-        detectedMachineDetailedType = Ep128Emu::VM_config.at("EP128_DISK");
-        diskContent=true;
-      }
-      else {
-        log_cb(RETRO_LOG_ERROR, "Content format not recognized!\n");
-        return false;
-      }
-    }
-    else if (contentExt == fileExtDtf) {
-      detectedMachineDetailedType = Ep128Emu::VM_config.at("EP128_FILE_DTF");
-      fileContent=true;
-      startupSequence =" \xff\xff\xff\xff\xff:dl ";
-    }
-    // last resort: EP file, first 2 bytes
-    else if (header_match(epComFileHeader,tmpBuf,2) || header_match(epComFileHeader2,tmpBuf,2) || header_match(epBasFileHeader,tmpBuf,2))
-    {
-      detectedMachineDetailedType = Ep128Emu::VM_config.at("EP128_FILE");
-      fileContent=true;
-      startupSequence =" \xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xfd";
-    }
-    else
-    {
-      log_cb(RETRO_LOG_ERROR, "Content format not recognized!\n");
-      return false;
-    }
+    tapeContent = content.tapeContent;
+    diskContent = content.diskContent;
+    fileContent = content.fileContent;
+    int detectedMachineDetailedType = content.machineDetailedType;
     try
     {
       log_cb(RETRO_LOG_DEBUG, "Creating core\n");
       check_variables();
-      core = new Ep128Emu::LibretroCore(log_cb, detectedMachineDetailedType, contentLocale, canSkipFrames,
+      core = new Ep128Emu::LibretroCore(log_cb, detectedMachineDetailedType, content.locale, canSkipFrames,
                                         retro_system_bios_directory, retro_system_save_directory,
-                                        startupSequence,configFile.c_str(),useHalfFrame, enhancedRom);
+                                        content.startupSequence.c_str(),content.configFile.c_str(),useHalfFrame, enhancedRom, headless);
       log_cb(RETRO_LOG_DEBUG, "Core created\n");
       config = core->config;
       check_variables();
@@ -1093,13 +996,13 @@ bool retro_load_game(const struct retro_game_info *info)
       if (diskContent || tapeContent) {
         scan_multidisk_files(info->path);
         if (diskIndexInitial > 0)
-          set_image_index_cb(diskIndexInitial);
+          set_image_index(diskIndexInitial);
       }
       if (fileContent)
       {
         config->fileio.workingDirectory = contentPath;
         contentFileName=contentPath+contentFile;
-        core->vm->setFileNameCallback(&fileNameCallback, NULL);
+        core->vm->setFileNameCallback(&fileNameCallback, (void *) this);
         config->fileioSettingsChanged = true;
         config->vm.enableFileIO=true;
         config->vmConfigurationChanged = true;
@@ -1161,10 +1064,14 @@ bool retro_load_game(const struct retro_game_info *info)
   return true;
 }
 
-void retro_unload_game(void)
+void LibretroContext::unload_game(void)
 {
   try
   {
+    if (z80ProfilerInterval)
+      core->log_z80_profile();
+    if (videoCaptureMode)
+      core->set_video_capture(0, retro_system_save_directory);
     config->floppy.a.imageFile = "";
     config->floppyAChanged = true;
     config->applySettings();
@@ -1177,16 +1084,7 @@ void retro_unload_game(void)
 
 }
 
-bool retro_load_game_special(unsigned type, const struct retro_game_info *info, size_t num)
-{
-  if (type != 0x200)
-    return false;
-  if (num != 2)
-    return false;
-  return retro_load_game(NULL);
-}
-
-size_t retro_serialize_size(void)
+size_t LibretroContext::serialize_size(void)
 {
   if(core && core->config) {
     return (size_t)EP128EMU_SNAPSHOT_SIZE + (size_t)(core->config->memory.ram.size > 128 ? (core->config->memory.ram.size-128)*1024 : 0);
@@ -1194,11 +1092,12 @@ size_t retro_serialize_size(void)
     return EP128EMU_SNAPSHOT_SIZE;
 }
 
-bool retro_serialize(void *data_, size_t size)
+bool LibretroContext::serialize(void *data_, size_t size)
 {
-  if (size < retro_serialize_size())
+  if (size < serialize_size())
     return false;
 
+  EP128EMU_PERF_SCOPE(PERF_SERIALIZE, 0);
   memset( data_, 0x00,size);
 
   Ep128Emu::File  f;
@@ -1208,9 +1107,9 @@ bool retro_serialize(void *data_, size_t size)
   return true;
 }
 
-bool retro_unserialize(const void *data_, size_t size)
+bool LibretroContext::unserialize(const void *data_, size_t size)
 {
-  if (size < retro_serialize_size())
+  if (size < serialize_size())
     return false;
 
   unsigned char *buf= (unsigned char*)data_;
@@ -1236,6 +1135,137 @@ bool retro_unserialize(const void *data_, size_t size)
   return true;
 }
 
+void LibretroContext::set_controller_port_device(unsigned port, unsigned device)
+{
+  //log_cb(RETRO_LOG_INFO, "Plugging device %u into port %u.\n", device, port);
+  std::map< unsigned, std::string>::const_iterator  iter_joytype;
+  iter_joytype = Ep128Emu::joystick_type_retrodev.find(device);
+  if (port < EP128EMU_MAX_USERS && iter_joytype != Ep128Emu::joystick_type_retrodev.end())
+  {
+    int userMap[EP128EMU_MAX_USERS] = {
+      Ep128Emu::joystick_type.at("DEFAULT"), Ep128Emu::joystick_type.at("DEFAULT"),
+      Ep128Emu::joystick_type.at("DEFAULT"), Ep128Emu::joystick_type.at("DEFAULT"),
+      Ep128Emu::joystick_type.at("DEFAULT"), Ep128Emu::joystick_type.at("DEFAULT")};
+
+    unsigned mappedDev = Ep128Emu::joystick_type.at((*iter_joytype).second);
+    log_cb(RETRO_LOG_DEBUG, "Mapped device %s for user %u \n", (*iter_joytype).second.c_str(), port);
+
+    userMap[port] = mappedDev;
+    if(core)
+      core->initialize_joystick_map(std::string(""),std::string(""),std::string(""),-1,userMap[0],userMap[1],userMap[2],userMap[3],userMap[4],userMap[5]);
+  }
+}
+
+// ----------------------------------------------------------------------------
+// libretro entry points
+
+void retro_set_environment(retro_environment_t cb)
+{
+  Ep128Emu::getCurrentLibretroContext().set_environment(cb);
+}
+
+void retro_set_audio_sample(retro_audio_sample_t cb)
+{
+  Ep128Emu::getCurrentLibretroContext().audio_cb = cb;
+}
+
+void retro_set_audio_sample_batch(retro_audio_sample_batch_t cb)
+{
+  Ep128Emu::getCurrentLibretroContext().audio_batch_cb = cb;
+}
+
+void retro_set_input_poll(retro_input_poll_t cb)
+{
+  Ep128Emu::getCurrentLibretroContext().input_poll_cb = cb;
+}
+
+void retro_set_input_state(retro_input_state_t cb)
+{
+  Ep128Emu::getCurrentLibretroContext().input_state_cb = cb;
+}
+
+void retro_set_video_refresh(retro_video_refresh_t cb)
+{
+  Ep128Emu::getCurrentLibretroContext().video_cb = cb;
+}
+
+void retro_init(void)
+{
+  Ep128Emu::getCurrentLibretroContext().init();
+}
+
+void retro_deinit(void)
+{
+  Ep128Emu::getCurrentLibretroContext().deinit();
+}
+
+void retro_get_system_info(struct retro_system_info *info)
+{
+  memset(info, 0, sizeof(*info));
+  info->library_name     = "ep128emu";
+  info->library_version  = "v1.2.10";
+  info->need_fullpath    = true;
+#ifndef EXCLUDE_SOUND_LIBS
+  info->valid_extensions = "img|dsk|tap|dtf|com|trn|128|bas|cas|cdt|tzx|wav|tvcwav|mp3|.";
+#else
+  info->valid_extensions = "img|dsk|tap|dtf|com|trn|128|bas|cas|cdt|tzx|wav|tvcwav|.";
+#endif // EXCLUDE_SOUND_LIBS
+}
+
+void retro_get_system_av_info(struct retro_system_av_info *info)
+{
+  Ep128Emu::getCurrentLibretroContext().get_system_av_info(info);
+}
+
+void retro_reset(void)
+{
+  Ep128Emu::getCurrentLibretroContext().reset();
+}
+
+void retro_run(void)
+{
+  Ep128Emu::getCurrentLibretroContext().run();
+}
+
+bool retro_load_game(const struct retro_game_info *info)
+{
+  return Ep128Emu::getCurrentLibretroContext().load_game(info);
+}
+
+void retro_unload_game(void)
+{
+  Ep128Emu::getCurrentLibretroContext().unload_game();
+}
+
+bool retro_load_game_special(unsigned type, const struct retro_game_info *info, size_t num)
+{
+  if (type != 0x200)
+    return false;
+  if (num != 2)
+    return false;
+  return retro_load_game(NULL);
+}
+
+size_t retro_serialize_size(void)
+{
+  return Ep128Emu::getCurrentLibretroContext().serialize_size();
+}
+
+bool retro_serialize(void *data_, size_t size)
+{
+  return Ep128Emu::getCurrentLibretroContext().serialize(data_, size);
+}
+
+bool retro_unserialize(const void *data_, size_t size)
+{
+  return Ep128Emu::getCurrentLibretroContext().unserialize(data_, size);
+}
+
+void retro_set_controller_port_device(unsigned port, unsigned device)
+{
+  Ep128Emu::getCurrentLibretroContext().set_controller_port_device(port, device);
+}
+
 void *retro_get_memory_data(unsigned id)
 {
   (void)id;
@@ -1263,27 +1293,6 @@ unsigned retro_api_version(void)
   return RETRO_API_VERSION;
 }
 
-void retro_set_controller_port_device(unsigned port, unsigned device)
-{
-  //log_cb(RETRO_LOG_INFO, "Plugging device %u into port %u.\n", device, port);
-  std::map< unsigned, std::string>::const_iterator  iter_joytype;
-  iter_joytype = Ep128Emu::joystick_type_retrodev.find(device);
-  if (port < EP128EMU_MAX_USERS && iter_joytype != Ep128Emu::joystick_type_retrodev.end())
-  {
-    int userMap[EP128EMU_MAX_USERS] = {
-      Ep128Emu::joystick_type.at("DEFAULT"), Ep128Emu::joystick_type.at("DEFAULT"),
-      Ep128Emu::joystick_type.at("DEFAULT"), Ep128Emu::joystick_type.at("DEFAULT"),
-      Ep128Emu::joystick_type.at("DEFAULT"), Ep128Emu::joystick_type.at("DEFAULT")};
-
-    unsigned mappedDev = Ep128Emu::joystick_type.at((*iter_joytype).second);
-    log_cb(RETRO_LOG_DEBUG, "Mapped device %s for user %u \n", (*iter_joytype).second.c_str(), port);
-
-    userMap[port] = mappedDev;
-    if(core)
-      core->initialize_joystick_map(std::string(""),std::string(""),std::string(""),-1,userMap[0],userMap[1],userMap[2],userMap[3],userMap[4],userMap[5]);
-  }
-}
-
 unsigned retro_get_region(void)
 {
   return RETRO_REGION_PAL;
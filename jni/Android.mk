@@ -4,7 +4,7 @@ CORE_DIR := $(LOCAL_PATH)/..
 
 include $(CORE_DIR)/Makefile.common
 
-COREFLAGS := -D__LIBRETRO__ -DEP128EMU_LIBRETRO_CORE -DEXCLUDE_SOUND_LIBS $(INCFLAGS)
+COREFLAGS := -D__LIBRETRO__ -DEP128EMU_LIBRETRO_CORE -DEP128EMU_NO_BREAKPOINTS -DEXCLUDE_SOUND_LIBS -DENABLE_RESID $(INCFLAGS)
 
 GIT_VERSION ?= " $(shell git rev-parse --short HEAD || echo unknown)"
 ifneq ($(GIT_VERSION)," unknown")
@@ -420,6 +420,9 @@ namespace Ep128 {
       class_init = true;
     }
 
+    // no DAC bias adjustment by default (set_w0() uses it)
+    Vw_bias = 0;
+
     enable_filter(true);
     set_chip_model(MOS6581);
     set_voice_mask(0x07);
@@ -37,6 +37,7 @@ namespace Ep128 {
     bus_value = 0;
     bus_value_ttl = 0;
     write_pipeline = 0;
+    write_address = 0;
 
     databus_ttl = 0;
   }
@@ -94,6 +95,8 @@ namespace Ep128 {
 
     bus_value = 0;
     bus_value_ttl = 0;
+    write_pipeline = 0;
+    write_address = 0;
   }
 
   // --------------------------------------------------------------------------
@@ -315,7 +318,7 @@ namespace Ep128 {
   // --------------------------------------------------------------------------
   // SID clocking - 1 cycle.
   // --------------------------------------------------------------------------
-  EP128EMU_INLINE void SID::clock_fast()
+  EP128EMU_INLINE int SID::clock_cycle()
   {
     int i;
 
@@ -342,8 +345,7 @@ namespace Ep128 {
     // Clock filter.
     filter.clock(voice[0].output(), voice[1].output(), voice[2].output());
 
-    soundOutputAccumulator =
-        soundOutputAccumulator + (int32_t(filter.output()) << 3);
+    int output = filter.output();
 
     // Pipelined writes on the MOS8580.
     if (EP128EMU_UNLIKELY(write_pipeline)) {
@@ -354,6 +356,14 @@ namespace Ep128 {
     if (EP128EMU_UNLIKELY(!--bus_value_ttl)) {
       bus_value = 0;
     }
+
+    return output;
+  }
+
+  EP128EMU_INLINE void SID::clock_fast()
+  {
+    soundOutputAccumulator =
+        soundOutputAccumulator + (int32_t(clock_cycle()) << 3);
   }
 
   // --------------------------------------------------------------------------
@@ -368,6 +378,30 @@ namespace Ep128 {
   // SID clocking - delta_t cycles.
   // --------------------------------------------------------------------------
   void SID::clock(cycle_count delta_t)
+  {
+    // Pipelined writes on the MOS8580.
+    if (EP128EMU_UNLIKELY(write_pipeline) && EP128EMU_EXPECT(delta_t > 0)) {
+      // Step one cycle by a recursive call to ourselves.
+      write_pipeline = 0;
+      clock(1);
+      write();
+      delta_t -= 1;
+    }
+
+    if (EP128EMU_UNLIKELY(delta_t <= 0)) {
+      return;
+    }
+
+    clock_no_extfilt(delta_t);
+
+    // Clock external filter.
+    extfilt.clock(delta_t, filter.output());
+  }
+
+  // --------------------------------------------------------------------------
+  // SID clocking - delta_t cycles, without the external filter.
+  // --------------------------------------------------------------------------
+  void SID::clock_no_extfilt(cycle_count delta_t)
   {
     int i;
 
@@ -375,7 +409,7 @@ namespace Ep128 {
     if (EP128EMU_UNLIKELY(write_pipeline) && EP128EMU_EXPECT(delta_t > 0)) {
       // Step one cycle by a recursive call to ourselves.
       write_pipeline = 0;
-      clock(1);
+      clock_no_extfilt(1);
       write();
       delta_t -= 1;
     }
@@ -452,9 +486,26 @@ namespace Ep128 {
     // Clock filter.
     filter.clock(delta_t,
                  voice[0].output(), voice[1].output(), voice[2].output());
+  }
 
-    // Clock external filter.
-    extfilt.clock(delta_t, filter.output());
+  // --------------------------------------------------------------------------
+  // SID clocking - delta_t cycles, with output to soundOutputAccumulator.
+  // --------------------------------------------------------------------------
+  void SID::clock_fast(cycle_count delta_t)
+  {
+    clock_no_extfilt(delta_t);
+    soundOutputAccumulator =
+        soundOutputAccumulator + (int32_t(filter.output()) << 3);
+  }
+
+  // --------------------------------------------------------------------------
+  // SID clocking - delta_t cycles, per cycle output.
+  // --------------------------------------------------------------------------
+  void SID::clock_block(cycle_count delta_t, int *buf)
+  {
+    for (cycle_count n = 0; n < delta_t; n++) {
+      buf[n] = clock_cycle();
+    }
   }
 
   // --------------------------------------------------------------------------
@@ -45,6 +45,14 @@ namespace Ep128 {
     static EP128EMU_REGPARM1 void clockCallback(void *userData);
     EP128EMU_INLINE void clock();
     void clock(cycle_count delta_t);
+    // clocks delta_t cycles without the external filter, and adds the
+    // filter output at the end of the period to soundOutputAccumulator like
+    // a single call of clockCallback()
+    void clock_fast(cycle_count delta_t);
+    // clocks delta_t cycles with the same results as calling clockCallback()
+    // delta_t times, but storing the filter output of each cycle in buf
+    // instead of adding it to soundOutputAccumulator
+    void clock_block(cycle_count delta_t, int *buf);
     void reset();
 
     // Read/write registers.
@@ -63,8 +71,13 @@ namespace Ep128 {
   protected:
     void write();
     // simplified version with no external filter,
-    // adds the output to soundOutputAccumulator
+    // returns the filter output
+    EP128EMU_INLINE int clock_cycle();
+    // adds the output of clock_cycle() to soundOutputAccumulator
     EP128EMU_INLINE void clock_fast();
+    // clock(delta_t) without the external filter, which is not used by
+    // clock_fast() and clock_block()
+    void clock_no_extfilt(cycle_count delta_t);
 
     chip_model sid_model;
     Voice voice[3];
@@ -0,0 +1,101 @@
+// ep128emu -- portable Enterprise 128 emulator
+// Copyright (C) 2003-2016 Istvan Varga <istvanv@users.sourceforge.net>
+// https://github.com/istvan-v/ep128emu/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// Host tool that converts the ROM tables in roms.hpp to the compressed
+// ROM pack (rompack.cpp) that is actually built into the core.
+// Usage: mkrompack OUTFILE.cpp
+
+#include "ep128emu.hpp"
+#include "decompm2.hpp"
+
+#include <map>
+#include <vector>
+
+#include "roms/roms.hpp"
+
+int main(int argc, char **argv)
+{
+  if (argc != 2) {
+    std::fprintf(stderr, "Usage: %s OUTFILE.cpp\n", argv[0]);
+    return -1;
+  }
+  std::FILE *f = (std::FILE *) 0;
+  try {
+    std::vector< unsigned char >  packBuf;
+    std::vector< unsigned char >  tmpBuf;
+    std::vector< unsigned char >  verifyBuf;
+    std::vector< size_t >         offsets;
+    std::map< std::string, const unsigned char * >::const_iterator  i;
+    for (i = Ep128Emu::builtin_rom.begin();
+         i != Ep128Emu::builtin_rom.end();
+         i++) {
+      size_t  nBytes = Ep128Emu::builtin_rom_length.at((*i).first);
+      Ep128Emu::compressData(tmpBuf, (*i).second, nBytes);
+      Ep128Emu::decompressData(verifyBuf, &(tmpBuf.front()), tmpBuf.size());
+      if (verifyBuf.size() != nBytes ||
+          std::memcmp(&(verifyBuf.front()), (*i).second, nBytes) != 0) {
+        throw Ep128Emu::Exception("error verifying compressed ROM data");
+      }
+      std::fprintf(stderr, "%-32s %6u -> %6u bytes\n", (*i).first.c_str(),
+                   (unsigned int) nBytes, (unsigned int) tmpBuf.size());
+      offsets.push_back(packBuf.size());
+      packBuf.insert(packBuf.end(), tmpBuf.begin(), tmpBuf.end());
+    }
+    offsets.push_back(packBuf.size());
+    f = std::fopen(argv[1], "w");
+    if (!f)
+      throw Ep128Emu::Exception("error opening output file");
+    std::fprintf(f, "// Generated from roms.hpp by mkrompack, "
+                    "do not edit ('make rompack' to rebuild).\n\n"
+                    "#include \"ep128emu.hpp\"\n"
+                    "#include \"builtinrom.hpp\"\n\n"
+                    "namespace Ep128Emu {\n\n"
+                    "const unsigned char builtinROMPackData[] = {");
+    for (size_t j = 0; j < packBuf.size(); j++) {
+      std::fprintf(f, "%s0x%02x%s", ((j % 12) == 0 ? "\n  " : " "),
+                   (unsigned int) packBuf[j],
+                   ((j + 1) < packBuf.size() ? "," : ""));
+    }
+    std::fprintf(f, "\n};\n\nconst BuiltinROMPackEntry builtinROMPackIndex[] = "
+                    "{\n");
+    size_t  n = 0;
+    for (i = Ep128Emu::builtin_rom.begin();
+         i != Ep128Emu::builtin_rom.end();
+         i++, n++) {
+      std::fprintf(f, "  { \"%s\", %u, %u, %u },\n", (*i).first.c_str(),
+                   (unsigned int) offsets[n],
+                   (unsigned int) (offsets[n + 1] - offsets[n]),
+                   (unsigned int) Ep128Emu::builtin_rom_length.at((*i).first));
+    }
+    std::fprintf(f, "};\n\nconst size_t builtinROMPackIndexSize = %u;\n\n}\n",
+                 (unsigned int) n);
+    if (std::fclose(f) != 0) {
+      f = (std::FILE *) 0;
+      throw Ep128Emu::Exception("error writing output file");
+    }
+    f = (std::FILE *) 0;
+  }
+  catch (std::exception& e) {
+    if (f)
+      std::fclose(f);
+    std::fprintf(stderr, " *** error: %s\n", e.what());
+    return -1;
+  }
+  return 0;
+}
+
@@ -5,6 +5,8 @@ https://web.archive.org/web/20080510131526/http://web.ukonline.co.uk/cliff.lawso
 */
 
 // Dump ROM files with: xxd --include file.rom  >> roms.hpp, move new variables a bit further up, make it const and edit the lists at the end.
+// This file is not compiled into the core: after editing it, run 'make rompack' to regenerate
+// the compressed ROM pack in rompack.cpp (see src/builtinrom.hpp).
 namespace Ep128Emu {
 
 const unsigned char epfileio_rom[] = {
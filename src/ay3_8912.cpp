@@ -32,8 +32,31 @@ namespace ZX128 {
      3695,  5782,  7705,  9829, 12460, 15014, 18528, 21845
   };
 
+  // advance a tone generator (or the envelope generator period counter)
+  // by 'n' cycles, without calculating the output
+
+  template <typename T>
+  static EP128EMU_INLINE bool runPeriodCounter(T& cnt, T freq, uint32_t n)
+  {
+    uint32_t  c = (cnt > T(1) ? uint32_t(cnt) : 1U);
+    if (n < c) {
+      cnt = cnt - T(n);
+      return false;
+    }
+    n = n - c;
+    uint32_t  p = (freq > T(1) ? uint32_t(freq) : 1U);
+    cnt = freq - T(n % p);
+    // returns true if the number of periods completed is odd
+    return !((n / p) & 1U);
+  }
+
   void AY3_8912::resetRegisters()
   {
+    spanCycles = 0U;
+    pendingCycles = 0U;
+    spanOutputA = 0;
+    spanOutputB = 0;
+    spanOutputC = 0;
     for (int i = 0; i < 16; i++)
       registers[i] = 0x00;
     tgFreqA = 0;
@@ -100,6 +123,9 @@ namespace ZX128 {
 
   void AY3_8912::writeRegister(uint16_t addr, uint8_t value)
   {
+    if (pendingCycles)
+      runPendingCycles();
+    spanCycles = 0U;
     addr = addr & 0x0F;
     registers[addr] = value & registerMaskTable[addr];
     switch (addr) {
@@ -175,74 +201,101 @@ namespace ZX128 {
     }
   }
 
-  void AY3_8912::runOneCycle(uint16_t& outA, uint16_t& outB, uint16_t& outC)
+  void AY3_8912::runEnvelopeStep()
   {
-    outA = (((tgStateA | tgDisabledA) & (ngState | ngDisabledA)) ?
-            amplitudeA : uint16_t(0));
-    outB = (((tgStateB | tgDisabledB) & (ngState | ngDisabledB)) ?
-            amplitudeB : uint16_t(0));
-    outC = (((tgStateC | tgDisabledC) & (ngState | ngDisabledC)) ?
-            amplitudeC : uint16_t(0));
-    if (tgCntA <= 1) {
-      tgCntA = tgFreqA;
-      tgStateA = !tgStateA;
-    }
-    else {
-      tgCntA--;
+    envState += envDir;
+    if (envState < 0 || envState > 31) {
+      if (envHold || !envContinue) {
+        envState = ((envAlternate == envAttack || !envContinue) ? 0 : 31);
+        envDir = 0;
+      }
+      else if (!envAlternate) {
+        envState = envState & 31;
+      }
+      else {
+        envState -= envDir;
+        envDir = -envDir;
+      }
     }
-    if (tgCntB <= 1) {
-      tgCntB = tgFreqB;
+    if (envEnabledA)
+      amplitudeA = amplitudeTable[envState >> 1];
+    if (envEnabledB)
+      amplitudeB = amplitudeTable[envState >> 1];
+    if (envEnabledC)
+      amplitudeC = amplitudeTable[envState >> 1];
+  }
+
+  void AY3_8912::runPendingCycles()
+  {
+    uint32_t  n = pendingCycles;
+    pendingCycles = 0U;
+    if (runPeriodCounter(tgCntA, tgFreqA, n))
+      tgStateA = !tgStateA;
+    if (runPeriodCounter(tgCntB, tgFreqB, n))
       tgStateB = !tgStateB;
-    }
-    else {
-      tgCntB--;
-    }
-    if (tgCntC <= 1) {
-      tgCntC = tgFreqC;
+    if (runPeriodCounter(tgCntC, tgFreqC, n))
       tgStateC = !tgStateC;
-    }
-    else {
-      tgCntC--;
-    }
-    if (!(ngCnt & 0x7E)) {
-      ngCnt = (ngCnt ^ 0x80) | ngFreq;
+    // the noise generator period depends on the previous counter state,
+    // and the shift register is clocked on every second period
+    uint32_t  nn = n;
+    while (true) {
+      uint32_t  c = uint32_t(ngCnt & 0x7F);
+      c = (c > 1U ? c : 1U);
+      if (nn < c) {
+        ngCnt = ngCnt - int(nn);
+        break;
+      }
+      nn = nn - c;
+      ngCnt = ((ngCnt - int(c - 1U)) ^ 0x80) | ngFreq;
       if (!(ngCnt & 0x80)) {
         ngState = bool(ngShiftReg & 0x00008000U);
         ngShiftReg = ((ngShiftReg & 0x0000FFFFU) << 1)
                      | ((~((ngShiftReg >> 16) ^ (ngShiftReg >> 13))) & 1U);
       }
     }
-    else {
-      ngCnt--;
+    if (envDir == 0) {
+      (void) runPeriodCounter(envCnt, envFreq, n);
+      return;
     }
-    if (envCnt <= 1U) {
-      envCnt = envFreq;
-      if (envDir != 0) {
-        envState += envDir;
-        if (envState < 0 || envState > 31) {
-          if (envHold || !envContinue) {
-            envState = ((envAlternate == envAttack || !envContinue) ? 0 : 31);
-            envDir = 0;
-          }
-          else if (!envAlternate) {
-            envState = envState & 31;
-          }
-          else {
-            envState -= envDir;
-            envDir = -envDir;
-          }
-        }
-        if (envEnabledA)
-          amplitudeA = amplitudeTable[envState >> 1];
-        if (envEnabledB)
-          amplitudeB = amplitudeTable[envState >> 1];
-        if (envEnabledC)
-          amplitudeC = amplitudeTable[envState >> 1];
+    while (true) {
+      uint32_t  c = (envCnt > 1U ? envCnt : 1U);
+      if (n < c) {
+        envCnt = envCnt - n;
+        break;
       }
+      n = n - c;
+      envCnt = envFreq;
+      if (envDir != 0)
+        runEnvelopeStep();
     }
-    else {
-      envCnt--;
+  }
+
+  void AY3_8912::beginSpan()
+  {
+    if (pendingCycles)
+      runPendingCycles();
+    spanOutputA = (((tgStateA | tgDisabledA) & (ngState | ngDisabledA)) ?
+                   amplitudeA : uint16_t(0));
+    spanOutputB = (((tgStateB | tgDisabledB) & (ngState | ngDisabledB)) ?
+                   amplitudeB : uint16_t(0));
+    spanOutputC = (((tgStateC | tgDisabledC) & (ngState | ngDisabledC)) ?
+                   amplitudeC : uint16_t(0));
+    // find the first cycle after which the output may change
+    uint32_t  n = 4096U;
+    if (!tgDisabledA && amplitudeA)
+      n = (tgCntA > 1 ? (uint32_t(tgCntA) < n ? uint32_t(tgCntA) : n) : 1U);
+    if (!tgDisabledB && amplitudeB)
+      n = (tgCntB > 1 ? (uint32_t(tgCntB) < n ? uint32_t(tgCntB) : n) : 1U);
+    if (!tgDisabledC && amplitudeC)
+      n = (tgCntC > 1 ? (uint32_t(tgCntC) < n ? uint32_t(tgCntC) : n) : 1U);
+    if ((!ngDisabledA && amplitudeA) || (!ngDisabledB && amplitudeB) ||
+        (!ngDisabledC && amplitudeC)) {
+      uint32_t  c = uint32_t(ngCnt & 0x7F);
+      n = (c > 1U ? (c < n ? c : n) : 1U);
     }
+    if (envDir != 0)
+      n = (envCnt > 1U ? (envCnt < n ? envCnt : n) : 1U);
+    spanCycles = n;
   }
 
   // --------------------------------------------------------------------------
@@ -271,6 +324,9 @@ namespace ZX128 {
 
   void AY3_8912::saveState(Ep128Emu::File::Buffer& buf)
   {
+    if (pendingCycles)
+      runPendingCycles();
+    spanCycles = 0U;
     buf.setPosition(0);
     buf.writeUInt32(0x01000001U);       // version number
     for (int i = 0; i < 16; i++)
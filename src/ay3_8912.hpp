@@ -63,15 +63,36 @@ namespace ZX128 {
     bool      envEnabledB;              // envelope to channel B enable flag
     bool      envEnabledC;              // envelope to channel C enable flag
     uint8_t   portAInput;               // port A input byte (defaults to 0xFF)
+    // The output only changes when a generator that is audible reaches the
+    // end of its period, so it is generated in spans of constant output,
+    // and the state of the generators is only updated at the end of each
+    // span, or before a register write.
+    uint32_t  spanCycles;               // cycles left in the current span
+    uint32_t  pendingCycles;            // cycles not yet applied to the state
+    uint16_t  spanOutputA;              // channel A output in current span
+    uint16_t  spanOutputB;              // channel B output in current span
+    uint16_t  spanOutputC;              // channel C output in current span
     // --------
     void resetRegisters();
+    void runEnvelopeStep();
+    void runPendingCycles();
+    void beginSpan();
    public:
     AY3_8912();
     virtual ~AY3_8912();
     void reset();
     uint8_t readRegister(uint16_t addr) const;
     void writeRegister(uint16_t addr, uint8_t value);
-    void runOneCycle(uint16_t& outA, uint16_t& outB, uint16_t& outC);
+    inline void runOneCycle(uint16_t& outA, uint16_t& outB, uint16_t& outC)
+    {
+      if (EP128EMU_UNLIKELY(!spanCycles))
+        beginSpan();
+      spanCycles--;
+      pendingCycles++;
+      outA = spanOutputA;
+      outB = spanOutputB;
+      outC = spanOutputC;
+    }
     inline void setPortAInput(uint8_t value)
     {
       portAInput = value;
@@ -0,0 +1,84 @@
+// ep128emu -- portable Enterprise 128 emulator
+// Copyright (C) 2003-2016 Istvan Varga <istvanv@users.sourceforge.net>
+// https://github.com/istvan-v/ep128emu/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include "ep128emu.hpp"
+#include "builtinrom.hpp"
+#include "decompm2.hpp"
+#include "system.hpp"
+
+namespace Ep128Emu {
+
+  static const BuiltinROMPackEntry *findBuiltinROM(const std::string& fileName)
+  {
+    for (size_t i = 0; i < builtinROMPackIndexSize; i++) {
+      if (fileName == builtinROMPackIndex[i].name)
+        return &(builtinROMPackIndex[i]);
+    }
+    return (BuiltinROMPackEntry *) 0;
+  }
+
+  bool isBuiltinROM(const std::string& fileName)
+  {
+    return (findBuiltinROM(fileName) != (BuiltinROMPackEntry *) 0);
+  }
+
+  const std::vector< unsigned char >& getBuiltinROM(const std::string&
+                                                        fileName)
+  {
+    // decompressed images, indexed in the same order as builtinROMPackIndex
+    static Mutex  cacheMutex;
+    static std::vector< std::vector< unsigned char > * >  cache;
+    const BuiltinROMPackEntry *e = findBuiltinROM(fileName);
+    if (!e)
+      throw Exception("ROM file not found!");
+    size_t  n = size_t(e - builtinROMPackIndex);
+    const std::vector< unsigned char >  *retval =
+        (std::vector< unsigned char > *) 0;
+    cacheMutex.lock();
+    try {
+      if (cache.size() < builtinROMPackIndexSize) {
+        cache.resize(builtinROMPackIndexSize,
+                     (std::vector< unsigned char > *) 0);
+      }
+      if (!cache[n]) {
+        std::vector< unsigned char >  *buf =
+            new std::vector< unsigned char >();
+        try {
+          decompressData(*buf, &(builtinROMPackData[e->offset]),
+                         e->compressedSize);
+          if (buf->size() != e->size)
+            throw Exception("internal error: invalid built-in ROM data");
+        }
+        catch (...) {
+          delete buf;
+          throw;
+        }
+        cache[n] = buf;
+      }
+      retval = cache[n];
+    }
+    catch (...) {
+      cacheMutex.unlock();
+      throw;
+    }
+    cacheMutex.unlock();
+    return *retval;
+  }
+
+}       // namespace Ep128Emu
+
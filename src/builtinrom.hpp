@@ -0,0 +1,62 @@
+// ep128emu -- portable Enterprise 128 emulator
+// Copyright (C) 2003-2016 Istvan Varga <istvanv@users.sourceforge.net>
+// https://github.com/istvan-v/ep128emu/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#ifndef EP128EMU_BUILTINROM_HPP
+#define EP128EMU_BUILTINROM_HPP
+
+#include "ep128emu.hpp"
+
+#include <string>
+#include <vector>
+
+namespace Ep128Emu {
+
+  // The ROM images built into the core are stored in roms/rompack.cpp,
+  // each one compressed separately with compressData() (see decompm2.hpp).
+  // The pack is generated from roms/roms.hpp with 'make rompack'.
+
+  struct BuiltinROMPackEntry {
+    const char    *name;            // "_default_" file name
+    size_t        offset;           // start position in builtinROMPackData
+    size_t        compressedSize;
+    size_t        size;             // size of the decompressed image
+  };
+
+  extern const unsigned char        builtinROMPackData[];
+  extern const BuiltinROMPackEntry  builtinROMPackIndex[];
+  extern const size_t               builtinROMPackIndexSize;
+
+  /*!
+   * Returns true if 'fileName' is the name of a ROM image built into
+   * the core.
+   */
+  bool isBuiltinROM(const std::string& fileName);
+
+  /*!
+   * Returns the built-in ROM image 'fileName'. The image is decompressed
+   * the first time it is requested, and shared by all subsequent callers
+   * (including other emulator instances) until the library is unloaded.
+   * Throws Ep128Emu::Exception if there is no such built-in ROM.
+   */
+  const std::vector< unsigned char >& getBuiltinROM(const std::string&
+                                                        fileName);
+
+}       // namespace Ep128Emu
+
+#endif  // EP128EMU_BUILTINROM_HPP
+
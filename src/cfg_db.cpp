@@ -23,6 +23,7 @@
 #include "cfg_db.hpp"
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <cmath>
 #include <typeinfo>
 
@@ -440,111 +441,106 @@ namespace Ep128Emu {
   {
     std::map<std::string, ConfigurationVariable *>::iterator  i;
 
+    dbIndex.clear();
     for (i = db.begin(); i != db.end(); i++)
       delete (*i).second;
     db.clear();
   }
 
+  ConfigurationDB::ConfigurationVariable *
+      ConfigurationDB::findKey(const std::string& keyName)
+  {
+    std::unordered_map<std::string, ConfigurationVariable *>::iterator  i;
+
+    i = dbIndex.find(keyName);
+    if (i == dbIndex.end())
+      return (ConfigurationVariable *) 0;
+    return (*i).second;
+  }
+
   ConfigurationDB::ConfigurationVariable&
       ConfigurationDB::operator[](const char *keyName)
   {
-    std::map<std::string, ConfigurationVariable *>::iterator  i;
-
-    i = db.find(std::string(keyName));
-    if (i == db.end())
+    ConfigurationVariable *p = findKey(std::string(keyName));
+    if (!p)
       throw Exception("configuration variable is not found");
-    return *((*i).second);
+    return *p;
   }
 
   ConfigurationDB::ConfigurationVariable&
       ConfigurationDB::operator[](const std::string& keyName)
   {
-    std::map<std::string, ConfigurationVariable *>::iterator  i;
-
-    i = db.find(keyName);
-    if (i == db.end())
+    ConfigurationVariable *p = findKey(keyName);
+    if (!p)
       throw Exception("configuration variable is not found");
-    return *((*i).second);
+    return *p;
   }
 
-  void ConfigurationDB::createKey(const std::string& name, bool& ref)
+  ConfigurationDB::ConfigurationVariable&
+      ConfigurationDB::insertKey(const std::string& name,
+                                 ConfigurationVariable *p)
   {
-    if (db.find(name) != db.end())
-      throw Exception("cannot create configuration variable: "
-                      "the key name is already in use");
-    ConfigurationVariable_Boolean   *p;
-    p = new ConfigurationVariable_Boolean(name, ref);
     try {
-      db.insert(std::pair<std::string, ConfigurationVariable *>(name, p));
+      dbIndex.insert(std::pair<std::string, ConfigurationVariable *>(name, p));
+      try {
+        db.insert(std::pair<std::string, ConfigurationVariable *>(name, p));
+      }
+      catch (...) {
+        dbIndex.erase(name);
+        throw;
+      }
     }
     catch (...) {
       delete p;
       throw;
     }
+    return *p;
   }
 
-  void ConfigurationDB::createKey(const std::string& name, int& ref)
+  ConfigurationDB::ConfigurationVariable&
+      ConfigurationDB::createKey(const std::string& name, bool& ref)
   {
-    if (db.find(name) != db.end())
+    if (dbIndex.find(name) != dbIndex.end())
       throw Exception("cannot create configuration variable: "
                       "the key name is already in use");
-    ConfigurationVariable_Integer   *p;
-    p = new ConfigurationVariable_Integer(name, ref);
-    try {
-      db.insert(std::pair<std::string, ConfigurationVariable *>(name, p));
-    }
-    catch (...) {
-      delete p;
-      throw;
-    }
+    return insertKey(name, new ConfigurationVariable_Boolean(name, ref));
   }
 
-  void ConfigurationDB::createKey(const std::string& name, unsigned int& ref)
+  ConfigurationDB::ConfigurationVariable&
+      ConfigurationDB::createKey(const std::string& name, int& ref)
   {
-    if (db.find(name) != db.end())
+    if (dbIndex.find(name) != dbIndex.end())
       throw Exception("cannot create configuration variable: "
                       "the key name is already in use");
-    ConfigurationVariable_UnsignedInteger   *p;
-    p = new ConfigurationVariable_UnsignedInteger(name, ref);
-    try {
-      db.insert(std::pair<std::string, ConfigurationVariable *>(name, p));
-    }
-    catch (...) {
-      delete p;
-      throw;
-    }
+    return insertKey(name, new ConfigurationVariable_Integer(name, ref));
   }
 
-  void ConfigurationDB::createKey(const std::string& name, double& ref)
+  ConfigurationDB::ConfigurationVariable&
+      ConfigurationDB::createKey(const std::string& name, unsigned int& ref)
   {
-    if (db.find(name) != db.end())
+    if (dbIndex.find(name) != dbIndex.end())
       throw Exception("cannot create configuration variable: "
                       "the key name is already in use");
-    ConfigurationVariable_Float     *p;
-    p = new ConfigurationVariable_Float(name, ref);
-    try {
-      db.insert(std::pair<std::string, ConfigurationVariable *>(name, p));
-    }
-    catch (...) {
-      delete p;
-      throw;
-    }
+    return insertKey(name,
+                     new ConfigurationVariable_UnsignedInteger(name, ref));
   }
 
-  void ConfigurationDB::createKey(const std::string& name, std::string& ref)
+  ConfigurationDB::ConfigurationVariable&
+      ConfigurationDB::createKey(const std::string& name, double& ref)
   {
-    if (db.find(name) != db.end())
+    if (dbIndex.find(name) != dbIndex.end())
       throw Exception("cannot create configuration variable: "
                       "the key name is already in use");
-    ConfigurationVariable_String    *p;
-    p = new ConfigurationVariable_String(name, ref);
-    try {
-      db.insert(std::pair<std::string, ConfigurationVariable *>(name, p));
-    }
-    catch (...) {
-      delete p;
-      throw;
-    }
+    return insertKey(name, new ConfigurationVariable_Float(name, ref));
+  }
+
+  ConfigurationDB::ConfigurationVariable&
+      ConfigurationDB::createKey(const std::string& name, std::string& ref)
+  {
+    if (dbIndex.find(name) != dbIndex.end())
+      throw Exception("cannot create configuration variable: "
+                      "the key name is already in use");
+    return insertKey(name, new ConfigurationVariable_String(name, ref));
   }
 
   // --------------------------------------------------------------------------
@@ -619,18 +615,13 @@ namespace Ep128Emu {
     while (buf.getPosition() < buf.getDataSize()) {
       int           type;
       std::string   name;
-      std::map<std::string, ConfigurationVariable *>::iterator  i;
       ConfigurationVariable   *cv;
 
       type = int(buf.readUInt32());
       if (type < 1 || type > 5)
         throw Exception("unknown configuration variable type");
       name = buf.readString();
-      i = db.find(name);
-      if (i != db.end())
-        cv = (*i).second;
-      else
-        cv = (ConfigurationVariable *) 0;
+      cv = findKey(name);
       switch (type) {
       case 0x00000001:
         {
@@ -23,6 +23,7 @@
 #include "ep128emu.hpp"
 #include "fileio.hpp"
 #include <map>
+#include <unordered_map>
 
 namespace Ep128Emu {
 
@@ -81,7 +82,12 @@ namespace Ep128Emu {
       virtual void checkValue();
     };
    private:
+    // ordered by name, used when saving the database
     std::map<std::string, ConfigurationVariable *>  db;
+    // hashed index of the same variables, used for lookups by name
+    std::unordered_map<std::string, ConfigurationVariable *>  dbIndex;
+    ConfigurationVariable& insertKey(const std::string& name,
+                                     ConfigurationVariable *p);
    public:
     ConfigurationDB()
     {
@@ -89,11 +95,18 @@ namespace Ep128Emu {
     virtual ~ConfigurationDB();
     ConfigurationVariable& operator[](const char *);
     ConfigurationVariable& operator[](const std::string&);
-    void createKey(const std::string& name, bool& ref);
-    void createKey(const std::string& name, int& ref);
-    void createKey(const std::string& name, unsigned int& ref);
-    void createKey(const std::string& name, double& ref);
-    void createKey(const std::string& name, std::string& ref);
+    // Returns a pointer to the variable named 'keyName', or NULL if there is
+    // no such key. The pointer remains valid for the lifetime of the
+    // database, and can be cached to avoid repeated lookups by name.
+    ConfigurationVariable *findKey(const std::string& keyName);
+    // The createKey() functions return a reference to the new variable.
+    ConfigurationVariable& createKey(const std::string& name, bool& ref);
+    ConfigurationVariable& createKey(const std::string& name, int& ref);
+    ConfigurationVariable& createKey(const std::string& name,
+                                     unsigned int& ref);
+    ConfigurationVariable& createKey(const std::string& name, double& ref);
+    ConfigurationVariable& createKey(const std::string& name,
+                                     std::string& ref);
     void saveState(File::Buffer& buf);
     void saveState(File& f);
     void saveState(const char *fileName,
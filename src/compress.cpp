@@ -22,8 +22,14 @@
 #include "comprlib.hpp"
 #include "decompm2.hpp"
 
-#define COMPRESS_MAX_THREADS    4
+#define COMPRESS_MAX_THREADS    64
 #define COMPRESS_BLOCK_SIZE     65536
+// hash table size, hash chain buffer size (must be a power of two greater
+// than the maximum match distance), and maximum number of hash chain entries
+// checked per position by the greedy parser
+#define COMPRESS_HASH_BITS      15
+#define COMPRESS_HASH_CHAIN_LEN 262144
+#define COMPRESS_MAX_CHAIN_LEN  32
 
 namespace Ep128Emu {
 
@@ -83,6 +89,14 @@ namespace Ep128Emu {
     size_t      offs3NumSlots;
     size_t      offs3PrefixSize;
     Ep128Compress::LZSearchTable  *searchTable;
+    // hash chains for parseMatchesGreedy(), with buffer positions + 1
+    // (0: none); the chain table is indexed by position modulo its size.
+    // These are kept if the next block continues in the same buffer
+    std::vector< unsigned int > hashHeadTable;
+    std::vector< unsigned int > hashChainTable;
+    const unsigned char *hashInBuf;
+    size_t      hashPos;        // next position to be added to the chains
+    size_t      hashBlockEnd;   // end of the last block parsed
     // --------
     void writeRepeatCode(std::vector< unsigned int >& buf, size_t d, size_t n);
     inline size_t getRepeatCodeLength(size_t d, size_t n) const;
@@ -94,16 +108,32 @@ namespace Ep128Emu {
     void optimizeMatches(LZMatchParameters *matchTable,
                          size_t *bitCountTable, unsigned int *offsSumTable,
                          size_t offs, size_t nBytes);
+    inline void addHashPosition(const unsigned char *inBuf, size_t pos);
+    inline size_t findMatchGreedy(unsigned int& d, const unsigned char *inBuf,
+                                  size_t pos, size_t endPos);
+    // fast alternative to optimizeMatches(): greedy parse with one step
+    // lazy matching, using only matches of at least 3 bytes found with hash
+    // chains; 'inBuf' is not rebased to the search table start
+    void parseMatchesGreedy(LZMatchParameters *matchTable,
+                            const unsigned char *inBuf,
+                            size_t offs, size_t nBytes);
+    // if 'parsedMatchTable' is not NULL, it is used instead of searching
+    // for the optimal matches, and it is modified if data is written
     size_t compressData(std::vector< unsigned int >& outBuf,
                         const unsigned char *inBuf, size_t offs, size_t nBytes,
-                        bool firstPass, bool fastMode = false);
+                        bool firstPass, bool fastMode = false,
+                        LZMatchParameters *parsedMatchTable =
+                            (LZMatchParameters *) 0);
    public:
     Compressor_M2();
     virtual ~Compressor_M2();
+    // if 'greedyParse' is true, parseMatchesGreedy() is used, and
+    // the encode tables are generated in a single pass
     void compressDataBlock(std::vector< unsigned int >& outBuf,
                            const unsigned char *inBuf, size_t offs,
                            size_t nBytes, size_t bufSize,
-                           bool isLastBlock, bool fastMode = false);
+                           bool isLastBlock, bool fastMode = false,
+                           bool greedyParse = false);
   };
 
   // --------------------------------------------------------------------------
@@ -407,36 +437,144 @@ namespace Ep128Emu {
     }
   }
 
+  // hash of the 3 bytes at 'p', for parseMatchesGreedy()
+  static EP128EMU_INLINE unsigned int getHashValue(const unsigned char *p)
+  {
+    unsigned int  h = ((unsigned int) p[0] << 16) | ((unsigned int) p[1] << 8)
+                      | (unsigned int) p[2];
+    return ((h * 0x9E3779B1U) >> (32 - COMPRESS_HASH_BITS));
+  }
+
+  inline void Compressor_M2::addHashPosition(const unsigned char *inBuf,
+                                             size_t pos)
+  {
+    unsigned int  h = getHashValue(inBuf + pos);
+    hashChainTable[pos & (COMPRESS_HASH_CHAIN_LEN - 1)] = hashHeadTable[h];
+    hashHeadTable[h] = (unsigned int) pos + 1U;
+  }
+
+  inline size_t Compressor_M2::findMatchGreedy(unsigned int& d,
+                                                const unsigned char *inBuf,
+                                                size_t pos, size_t endPos)
+  {
+    size_t  maxLen = endPos - pos;
+    if (maxLen > size_t(lengthMaxValue))
+      maxLen = lengthMaxValue;
+    if (maxLen < 3)
+      return 0;
+    size_t  bestLen = 2;
+    unsigned int  n = hashHeadTable[getHashValue(inBuf + pos)];
+    const unsigned char *p = inBuf + pos;
+    for (size_t i = 0; n > 0U && i < COMPRESS_MAX_CHAIN_LEN; i++) {
+      size_t  matchPos = size_t(n - 1U);
+      if ((pos - matchPos) > maxRepeatDist)
+        break;
+      const unsigned char *q = inBuf + matchPos;
+      if (q[bestLen] == p[bestLen] && q[0] == p[0] && q[1] == p[1]) {
+        size_t  len = 2;
+        while (len < maxLen && q[len] == p[len])
+          len++;
+        if (len > bestLen) {
+          bestLen = len;
+          d = (unsigned int) (pos - matchPos);
+          if (len >= maxRepeatLen || len >= maxLen)
+            break;
+        }
+      }
+      n = hashChainTable[matchPos & (COMPRESS_HASH_CHAIN_LEN - 1)];
+    }
+    return (bestLen >= 3 ? bestLen : 0);
+  }
+
+  void Compressor_M2::parseMatchesGreedy(LZMatchParameters *matchTable,
+                                         const unsigned char *inBuf,
+                                         size_t offs, size_t nBytes)
+  {
+    size_t  endPos = offs + nBytes;
+    if (inBuf != hashInBuf || offs != hashBlockEnd) {
+      // not continuing the previous block: start with the data up to
+      // maxRepeatDist bytes before 'offs'
+      hashHeadTable.clear();
+      hashHeadTable.resize(size_t(1) << COMPRESS_HASH_BITS, 0U);
+      hashChainTable.resize(COMPRESS_HASH_CHAIN_LEN);
+      hashInBuf = inBuf;
+      hashPos = (offs > maxRepeatDist ? (offs - maxRepeatDist) : 0);
+    }
+    hashBlockEnd = endPos;
+    size_t  hashEndPos = (endPos >= 2 ? (endPos - 2) : 0);
+    size_t  literalCnt = 0;
+    for (size_t i = offs; i < endPos; ) {
+      // add positions up to 'i' to the hash chains
+      for ( ; hashPos < i && hashPos < hashEndPos; hashPos++)
+        addHashPosition(inBuf, hashPos);
+      unsigned int  d = 0U;
+      size_t  len = findMatchGreedy(d, inBuf, i, endPos);
+      if (len > 0 && len < 32 && (i + 1) < hashEndPos) {
+        // lazy matching: emit a literal byte instead if the match at the
+        // next position is longer
+        addHashPosition(inBuf, i);
+        hashPos = i + 1;
+        unsigned int  d2 = 0U;
+        if (findMatchGreedy(d2, inBuf, i + 1, endPos) > len)
+          len = 0;
+      }
+      if (len > 0) {
+        if (literalCnt > 0) {
+          matchTable[(i - literalCnt) - offs].d = 0U;
+          matchTable[(i - literalCnt) - offs].len = (unsigned int) literalCnt;
+          literalCnt = 0;
+        }
+        matchTable[i - offs].d = d;
+        matchTable[i - offs].len = (unsigned int) len;
+        i += len;
+      }
+      else {
+        literalCnt++;
+        i++;
+      }
+    }
+    if (literalCnt > 0) {
+      matchTable[(endPos - literalCnt) - offs].d = 0U;
+      matchTable[(endPos - literalCnt) - offs].len = (unsigned int) literalCnt;
+    }
+  }
+
   size_t Compressor_M2::compressData(std::vector< unsigned int >& tmpOutBuf,
                                      const unsigned char *inBuf,
                                      size_t offs, size_t nBytes,
-                                     bool firstPass, bool fastMode)
+                                     bool firstPass, bool fastMode,
+                                     LZMatchParameters *parsedMatchTable)
   {
     size_t  endPos = offs + nBytes;
     size_t  nSymbols = 0;
+    // the fast table optimization is used for all tables with a fixed parse
+    bool    fastTables = bool(parsedMatchTable);
     tmpOutBuf.clear();
     if (!firstPass) {
       // generate optimal encode tables for offset values
-      offs1EncodeTable.updateTables(false);
-      offs2EncodeTable.updateTables(false);
-      offs3EncodeTable.updateTables(fastMode);
+      offs1EncodeTable.updateTables(fastTables);
+      offs2EncodeTable.updateTables(fastTables);
+      offs3EncodeTable.updateTables(fastMode || fastTables);
       offs3NumSlots = offs3EncodeTable.getSlotCnt();
       offs3PrefixSize = offs3EncodeTable.getSlotPrefixSize(0);
     }
     // compress data by searching for repeated byte sequences,
     // and replacing them with length/distance codes
-    std::vector< LZMatchParameters >  matchTable(nBytes);
-    {
+    std::vector< LZMatchParameters >  matchTable_;
+    LZMatchParameters *matchTable = parsedMatchTable;
+    if (!matchTable) {
+      matchTable_.resize(nBytes);
+      matchTable = &(matchTable_.front());
       std::vector< size_t > bitCountTable(nBytes + 1, 0);
       if (!firstPass) {
         std::vector< unsigned int > offsSumTable(nBytes + 1, 0U);
         lengthEncodeTable.setUnencodedSymbolSize(lengthNumSlots + 15);
-        optimizeMatches(&(matchTable.front()), &(bitCountTable.front()),
+        optimizeMatches(matchTable, &(bitCountTable.front()),
                         &(offsSumTable.front()), offs, nBytes);
       }
       else {
         // first pass: no symbol size information is available yet
-        optimizeMatches_noStats(&(matchTable.front()), &(bitCountTable.front()),
+        optimizeMatches_noStats(matchTable, &(bitCountTable.front()),
                                 offs, nBytes);
       }
     }
@@ -454,7 +592,7 @@ namespace Ep128Emu {
       }
       i += size_t(tmp.len);
     }
-    lengthEncodeTable.updateTables(false);
+    lengthEncodeTable.updateTables(fastTables);
     // update LZ77 offset statistics for calculating encode tables later
     for (size_t i = offs; i < endPos; ) {
       LZMatchParameters&  tmp = matchTable[i - offs];
@@ -568,7 +706,10 @@ namespace Ep128Emu {
                        2, 5, &(offs3SlotCntTable[0])),
       offs3NumSlots(4),
       offs3PrefixSize(2),
-      searchTable((Ep128Compress::LZSearchTable *) 0)
+      searchTable((Ep128Compress::LZSearchTable *) 0),
+      hashInBuf((unsigned char *) 0),
+      hashPos(0),
+      hashBlockEnd(0)
   {
   }
 
@@ -581,16 +722,22 @@ namespace Ep128Emu {
   void Compressor_M2::compressDataBlock(std::vector< unsigned int >& outBuf,
                                         const unsigned char *inBuf, size_t offs,
                                         size_t nBytes, size_t bufSize,
-                                        bool isLastBlock, bool fastMode)
+                                        bool isLastBlock, bool fastMode,
+                                        bool greedyParse)
   {
     outBuf.clear();
     if ((offs + nBytes) > bufSize)
       nBytes = bufSize - offs;
     if (!inBuf || nBytes < 1)
       return;
-    // FIXME: this assumes that the data is compressed in fixed size blocks
-    // that maxRepeatDist is an integer multiple of
-    {
+    std::vector< LZMatchParameters >  greedyMatchTable;
+    if (greedyParse) {
+      greedyMatchTable.resize(nBytes);
+      parseMatchesGreedy(&(greedyMatchTable.front()), inBuf, offs, nBytes);
+    }
+    else {
+      // FIXME: this assumes that the data is compressed in fixed size blocks
+      // that maxRepeatDist is an integer multiple of
       size_t  searchTableStart = (offs / maxRepeatDist) * maxRepeatDist;
       bool    searchTableNeeded = (offs == searchTableStart);
       if (searchTableNeeded) {
@@ -618,12 +765,17 @@ namespace Ep128Emu {
     size_t  bestSize = 0x7FFFFFFF;
     size_t  nSymbols = 0;
     bool    doneFlag = false;
-    for (size_t i = 0; i < 40; i++) {
+    // with a fixed parse, the second pass already uses encode tables that
+    // are optimal for the matches
+    size_t  nPasses = (greedyParse ? 2 : 40);
+    for (size_t i = 0; i < nPasses; i++) {
       if (doneFlag)     // if the compression cannot be optimized further,
         continue;       // quit the loop earlier
       tmpBuf.clear();
       size_t  tmp =
-          compressData(tmpBuf, inBuf, offs, nBytes, (i == 0), fastMode);
+          compressData(tmpBuf, inBuf, offs, nBytes, (i == 0), fastMode,
+                       (greedyParse ? &(greedyMatchTable.front())
+                                    : (LZMatchParameters *) 0));
       if (i == 0)       // the first optimization pass writes no data
         continue;
       // calculate compressed size and hash value
@@ -674,28 +826,92 @@ namespace Ep128Emu {
 
   // ==========================================================================
 
-  class CompressorThread : public Thread {
-   private:
-    Compressor_M2 compressor;
-   public:
-    std::vector< unsigned int > outBuf;
+  // Compression jobs shared by all threads: the input data is split into
+  // segments of maxRepeatDist bytes, and each thread takes the next segment
+  // from the queue when it is done with the previous one. Each segment is
+  // compressed in blocks of 'blockSize' bytes by the same compressor, since
+  // the search table of the optimal parser is built for the whole segment.
+
+  struct CompressorJobs {
     const unsigned char *inBuf;
     size_t  inBufSize;
-    size_t  startPos;
     size_t  blockSize;
+    bool    greedyParse;
     bool    errorFlag;
+    Mutex   mutex;
+    size_t  nextSegment;
+    // compressed data of each segment
+    std::vector< std::vector< unsigned int > >  outBufs;
     // --------
-    CompressorThread();
+    CompressorJobs(const unsigned char *inBuf_, size_t inBufSize_,
+                   bool greedyParse_)
+      : inBuf(inBuf_),
+        inBufSize(inBufSize_),
+        blockSize(COMPRESS_BLOCK_SIZE),
+        greedyParse(greedyParse_),
+        errorFlag(false),
+        nextSegment(0),
+        outBufs((inBufSize_ + (Compressor_M2::maxRepeatDist - 1))
+                / Compressor_M2::maxRepeatDist)
+    {
+    }
+    void run(Compressor_M2& compressor);
+  };
+
+  void CompressorJobs::run(Compressor_M2& compressor)
+  {
+    try {
+      std::vector< unsigned int > tmpBuf;
+      while (true) {
+        mutex.lock();
+        size_t  n = nextSegment;
+        if (errorFlag)
+          n = outBufs.size();
+        else if (n < outBufs.size())
+          nextSegment++;
+        mutex.unlock();
+        if (n >= outBufs.size())
+          break;
+        std::vector< unsigned int >&  outBuf = outBufs[n];
+        size_t  startPos = n * Compressor_M2::maxRepeatDist;
+        size_t  endPos = startPos + Compressor_M2::maxRepeatDist;
+        if (endPos > inBufSize)
+          endPos = inBufSize;
+        for ( ; startPos < endPos; startPos = startPos + blockSize) {
+          size_t  nBytes = blockSize;
+          if ((startPos + nBytes) > inBufSize)
+            nBytes = inBufSize - startPos;
+          compressor.compressDataBlock(tmpBuf, inBuf, startPos, nBytes,
+                                       inBufSize,
+                                       ((startPos + nBytes) >= inBufSize),
+                                       true, greedyParse);
+          // append compressed data to output buffer
+          size_t  prvSize = outBuf.size();
+          outBuf.resize(prvSize + tmpBuf.size());
+          std::memcpy(&(outBuf.front()) + prvSize, &(tmpBuf.front()),
+                      tmpBuf.size() * sizeof(unsigned int));
+        }
+      }
+    }
+    catch (const std::exception&) {
+      mutex.lock();
+      errorFlag = true;
+      mutex.unlock();
+    }
+  }
+
+  class CompressorThread : public Thread {
+   private:
+    Compressor_M2   compressor;
+    CompressorJobs& jobs;
+   public:
+    CompressorThread(CompressorJobs& jobs_);
     virtual ~CompressorThread();
     virtual void run();
   };
 
-  CompressorThread::CompressorThread()
-    : inBuf((unsigned char *) 0),
-      inBufSize(0),
-      startPos(0),
-      blockSize(Compressor_M2::maxRepeatDist),
-      errorFlag(false)
+  CompressorThread::CompressorThread(CompressorJobs& jobs_)
+    : jobs(jobs_)
   {
   }
 
@@ -705,122 +921,64 @@ namespace Ep128Emu {
 
   void CompressorThread::run()
   {
-    try {
-      if (!inBuf)
-        return;
-      std::vector< unsigned int > tmpBuf;
-      size_t  dataSizePos = 0;
-      while (startPos < inBufSize) {
-        size_t  nBytes = blockSize;
-        if ((startPos + nBytes) > inBufSize)
-          nBytes = inBufSize - startPos;
-        compressor.compressDataBlock(tmpBuf, inBuf, startPos, nBytes, inBufSize,
-                                     ((startPos + nBytes) >= inBufSize), true);
-        // append compressed data to output buffer
-        size_t  prvSize = outBuf.size();
-        if ((startPos % Compressor_M2::maxRepeatDist) == 0) {
-          dataSizePos = prvSize;
-          outBuf.resize(prvSize + tmpBuf.size() + 1);
-          outBuf[dataSizePos] = (unsigned int) tmpBuf.size();
-          prvSize++;
-        }
-        else {
-          outBuf.resize(prvSize + tmpBuf.size());
-          outBuf[dataSizePos] =
-              outBuf[dataSizePos] + (unsigned int) tmpBuf.size();
-        }
-        std::memcpy(&(outBuf.front()) + prvSize, &(tmpBuf.front()),
-                    tmpBuf.size() * sizeof(unsigned int));
-        startPos = startPos + blockSize;
-        if ((startPos % Compressor_M2::maxRepeatDist) == 0) {
-          startPos = startPos + (Compressor_M2::maxRepeatDist
-                                 * (COMPRESS_MAX_THREADS - 1));
-        }
-      }
-    }
-    catch (std::exception) {
-      errorFlag = true;
-    }
+    jobs.run(compressor);
   }
 
   // --------------------------------------------------------------------------
 
   void compressData(std::vector< unsigned char >& outBuf,
-                    const unsigned char *inBuf, size_t inBufSize)
+                    const unsigned char *inBuf, size_t inBufSize,
+                    bool fastMode, int maxThreads)
   {
     outBuf.clear();
     if (inBufSize < 1 || !inBuf)
       return;
-    CompressorThread  *compressorThreads[COMPRESS_MAX_THREADS];
-    for (int i = 0; i < COMPRESS_MAX_THREADS; i++)
-      compressorThreads[i] = (CompressorThread *) 0;
-    try {
-      size_t  startPos = 0;
-      int     nThreads = 0;
-      while (nThreads < COMPRESS_MAX_THREADS && startPos < inBufSize) {
-        compressorThreads[nThreads] = new CompressorThread();
-        compressorThreads[nThreads]->inBuf = inBuf;
-        compressorThreads[nThreads]->inBufSize = inBufSize;
-        compressorThreads[nThreads]->startPos = startPos;
-        compressorThreads[nThreads]->blockSize = COMPRESS_BLOCK_SIZE;
-        startPos = startPos + Compressor_M2::maxRepeatDist;
-        nThreads++;
-      }
-      for (int i = 0; i < nThreads; i++)
+    CompressorJobs  jobs(inBuf, inBufSize, fastMode);
+    if (maxThreads < 1)
+      maxThreads = getProcessorCount();
+    size_t  nThreads = size_t(maxThreads > 1 ? maxThreads : 1);
+    if (nThreads > COMPRESS_MAX_THREADS)
+      nThreads = COMPRESS_MAX_THREADS;
+    if (nThreads > jobs.outBufs.size())
+      nThreads = jobs.outBufs.size();
+    if (nThreads < 2) {
+      // no need for worker threads, compress all segments in this thread
+      Compressor_M2   compressor;
+      jobs.run(compressor);
+    }
+    else {
+      CompressorThread  *compressorThreads[COMPRESS_MAX_THREADS];
+      for (size_t i = 0; i < nThreads; i++)
+        compressorThreads[i] = (CompressorThread *) 0;
+      try {
+        for (size_t i = 0; i < nThreads; i++)
+          compressorThreads[i] = new CompressorThread(jobs);
+      }
+      catch (...) {
+        // if not all threads could be created, all segments are compressed
+        // by the ones that already exist
+        if (!compressorThreads[0])
+          throw;
+      }
+      for (size_t i = 0; i < nThreads && compressorThreads[i]; i++)
         compressorThreads[i]->start();
-      for (int i = 0; i < nThreads; i++) {
+      for (size_t i = 0; i < nThreads && compressorThreads[i]; i++) {
+        // the thread must be joined before the derived class is destroyed
         compressorThreads[i]->join();
-        // startPos is now the read position of the output buffer of the thread
-        compressorThreads[i]->startPos = 0;
+        delete compressorThreads[i];
       }
+    }
+    if (jobs.errorFlag)
+      throw Exception("error compressing data");
+    try {
       size_t        savedBufPos = 0x7FFFFFFF;
       unsigned char shiftReg = 0x01;
-      for (int i = 0; true; i++) {
-        if (i >= nThreads)
-          i = 0;
-        if (!compressorThreads[i]) {
-          // end of compressed data for all threads
-          if (shiftReg != 0x01) {
-            while (!(shiftReg & 0x80))
-              shiftReg = shiftReg << 1;
-            shiftReg = (shiftReg & 0x7F) << 1;
-            if (savedBufPos >= outBuf.size()) {
-              outBuf.push_back(shiftReg);
-            }
-            else {
-              // store at saved position if any literal bytes were inserted
-              outBuf[savedBufPos] = shiftReg;
-              savedBufPos = 0x7FFFFFFF;
-            }
-            shiftReg = 0x01;
-          }
-          // calculate checksum
-          unsigned char crcVal = 0xFF;
-          for (size_t j = outBuf.size() - 1; j > 0; j--) {
-            unsigned char tmp = crcVal ^ outBuf[j];
-            crcVal = (((tmp << 1) | ((tmp >> 7) & 0x01)) + 0xAC) & 0xFF;
-          }
-          crcVal = (unsigned char) ((0x0180 - 0xAC) >> 1) ^ crcVal;
-          outBuf[0] = crcVal;
-          break;
-        }
-        if (compressorThreads[i]->errorFlag)
-          throw Exception("error compressing data");
-        if (compressorThreads[i]->startPos
-            >= compressorThreads[i]->outBuf.size()) {
-          // end of compressed data for this thread
-          delete compressorThreads[i];
-          compressorThreads[i] = (CompressorThread *) 0;
-          continue;
-        }
+      outBuf.push_back(0x00);           // reserve space for checksum byte
+      for (size_t i = 0; i < jobs.outBufs.size(); i++) {
         // pack output data
-        if (outBuf.size() < 1)
-          outBuf.push_back(0x00);       // reserve space for checksum byte
-        startPos = compressorThreads[i]->startPos + 1;
-        compressorThreads[i]->startPos =
-            startPos + size_t(compressorThreads[i]->outBuf[startPos - 1]);
-        for (size_t j = startPos; j < compressorThreads[i]->startPos; j++) {
-          unsigned int  c = compressorThreads[i]->outBuf[j];
+        std::vector< unsigned int >&  segmentBuf = jobs.outBufs[i];
+        for (size_t j = 0; j < segmentBuf.size(); j++) {
+          unsigned int  c = segmentBuf[j];
           if (c >= 0x80000000U) {
             // special case for literal bytes, which are stored byte-aligned
             if (shiftReg != 0x01 && savedBufPos >= outBuf.size()) {
@@ -857,13 +1015,34 @@ namespace Ep128Emu {
             }
           }
         }
+        // the segment is no longer needed
+        std::vector< unsigned int >().swap(segmentBuf);
+      }
+      // end of compressed data for all segments
+      if (shiftReg != 0x01) {
+        while (!(shiftReg & 0x80))
+          shiftReg = shiftReg << 1;
+        shiftReg = (shiftReg & 0x7F) << 1;
+        if (savedBufPos >= outBuf.size()) {
+          outBuf.push_back(shiftReg);
+        }
+        else {
+          // store at saved position if any literal bytes were inserted
+          outBuf[savedBufPos] = shiftReg;
+          savedBufPos = 0x7FFFFFFF;
+        }
+        shiftReg = 0x01;
       }
+      // calculate checksum
+      unsigned char crcVal = 0xFF;
+      for (size_t j = outBuf.size() - 1; j > 0; j--) {
+        unsigned char tmp = crcVal ^ outBuf[j];
+        crcVal = (((tmp << 1) | ((tmp >> 7) & 0x01)) + 0xAC) & 0xFF;
+      }
+      crcVal = (unsigned char) ((0x0180 - 0xAC) >> 1) ^ crcVal;
+      outBuf[0] = crcVal;
     }
     catch (...) {
-      for (int i = 0; i < COMPRESS_MAX_THREADS; i++) {
-        if (compressorThreads[i])
-          delete compressorThreads[i];
-      }
       outBuf.clear();
       throw;
     }
@@ -894,9 +894,11 @@ namespace Ep128Compress {
         if (baseSymbol > nSymbols)
           baseSymbol = nSymbols;
         size_t  symbolSize = slotPrefixSizeTable[i] + slotBitsTable[i];
-        for (unsigned int j = prvBaseSymbol; j < baseSymbol; j++) {
-          symbolSlotNumTable[j] = (unsigned char) i;
-          symbolSizeTable[j] = (unsigned char) symbolSize;
+        if (baseSymbol > prvBaseSymbol) {
+          std::memset(&(symbolSlotNumTable[prvBaseSymbol]), int(i),
+                      baseSymbol - prvBaseSymbol);
+          std::memset(&(symbolSizeTable[prvBaseSymbol]), int(symbolSize),
+                      baseSymbol - prvBaseSymbol);
         }
       }
       for (size_t i = 0; i <= nSymbolsUsed; i++) {
@@ -919,13 +921,14 @@ namespace Ep128Compress {
       slotBitsTable[i] = 0;
       slotBaseSymbolTable[i] = 0U;
     }
-    for (size_t i = 0; true; i++) {
-      symbolCntTable[i] = 0U;
-      unencodedSymbolCostTable[i] = 0U;
-      if (i >= nSymbolsUsed && i >= nSymbolsEncoded)
-        break;
-      symbolSlotNumTable[i] = 0;
-      symbolSizeTable[i] = 1;
+    size_t  n = (nSymbolsUsed > nSymbolsEncoded ?
+                 nSymbolsUsed : nSymbolsEncoded);
+    std::memset(&(symbolCntTable.front()), 0, (n + 1) * sizeof(unsigned int));
+    std::memset(&(unencodedSymbolCostTable.front()), 0,
+                (n + 1) * sizeof(unsigned int));
+    if (n > 0) {
+      std::memset(&(symbolSlotNumTable.front()), 0, n);
+      std::memset(&(symbolSizeTable.front()), 1, n);
     }
     nSymbolsUsed = 0;
     nSymbolsEncoded = 0;
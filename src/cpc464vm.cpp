@@ -32,7 +32,7 @@
 #include "videorec.hpp"
 #include "fdc765.hpp"
 #include "cpcdisk.hpp"
-#include "roms/roms.hpp"
+#include "builtinrom.hpp"
 
 #include <vector>
 
@@ -178,13 +178,15 @@ namespace CPC464 {
   {
     uint16_t  addr = uint16_t(R.PC.W.l);
     vm.memoryWaitM1();
-    if (!vm.singleStepMode) {
-      uint8_t   retval = vm.memory.readOpcode(addr);
+#ifndef EP128EMU_NO_BREAKPOINTS
+    if (vm.singleStepMode) {
+      // single step mode
+      uint8_t   retval = vm.checkSingleStepModeBreak();
       vm.updateCPUHalfCycles(4);
       return retval;
     }
-    // single step mode
-    uint8_t   retval = vm.checkSingleStepModeBreak();
+#endif
+    uint8_t   retval = vm.memory.readOpcode(addr);
     vm.updateCPUHalfCycles(4);
     return retval;
   }
@@ -1113,6 +1115,7 @@ namespace CPC464 {
     crtcCyclesRemainingH = int32_t(crtcCyclesRemaining >> 32);
     while (EP128EMU_EXPECT(crtcCyclesRemainingH > 0)) {
       z80.executeInstruction();
+      z80ProfilerUpdate();
       while (EP128EMU_UNLIKELY(z80OpcodeHalfCycles >= 8))
         runOneCycle();
     }
@@ -1168,10 +1171,11 @@ namespace CPC464 {
     }
     // load file into memory
     std::vector<uint8_t>  buf;
-    std::map<std::string, const unsigned char*>::const_iterator  iter_builtin_rom;
-    iter_builtin_rom = Ep128Emu::builtin_rom.find(fileName);
-    if (iter_builtin_rom != Ep128Emu::builtin_rom.end()) {
-      buf.insert(buf.begin(), (*iter_builtin_rom).second+offs, (*iter_builtin_rom).second + offs + 0x4000);
+    if (Ep128Emu::isBuiltinROM(fileName)) {
+      const std::vector<uint8_t>& romData = Ep128Emu::getBuiltinROM(fileName);
+      if (romData.size() < offs + 0x4000)
+        throw Ep128Emu::Exception("ROM file is shorter than expected");
+      buf.insert(buf.begin(), romData.begin() + offs, romData.begin() + offs + 0x4000);
     } else {
       buf.resize(0x4000);
       std::FILE   *f = Ep128Emu::fileOpen(fileName, "rb");
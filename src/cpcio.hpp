@@ -60,23 +60,27 @@ namespace CPC464 {
   inline uint8_t IOPorts::read(uint16_t addr)
   {
     uint8_t value = readCallback(callbackUserData, addr);
+#ifndef EP128EMU_NO_BREAKPOINTS
     if (breakPointTable) {
       uint8_t offs = uint8_t(addr >> 8);
       if (breakPointTable[offs] >= breakPointPriorityThreshold &&
           (breakPointTable[offs] & 1) != 0)
         breakPointCallback(false, addr, value);
     }
+#endif
     return value;
   }
 
   inline void IOPorts::write(uint16_t addr, uint8_t value)
   {
+#ifndef EP128EMU_NO_BREAKPOINTS
     if (breakPointTable) {
       uint8_t offs = uint8_t(addr >> 8);
       if (breakPointTable[offs] >= breakPointPriorityThreshold &&
           (breakPointTable[offs] & 2) != 0)
         breakPointCallback(true, addr, value);
     }
+#endif
     writeCallback(callbackUserData, addr, value);
   }
 
@@ -98,8 +98,10 @@ namespace CPC464 {
   {
     uint8_t page = uint8_t(addr >> 14);
     uint8_t value = pageAddressTableR[page][addr];
+#ifndef EP128EMU_NO_BREAKPOINTS
     if (haveBreakPoints)
       checkReadBreakPoint(addr, page, value);
+#endif
     return value;
   }
 
@@ -107,8 +109,10 @@ namespace CPC464 {
   {
     uint8_t page = uint8_t(addr >> 14);
     uint8_t value = pageAddressTableR[page][addr];
+#ifndef EP128EMU_NO_BREAKPOINTS
     if (haveBreakPoints)
       checkExecuteBreakPoint(addr, page, value);
+#endif
     return value;
   }
 
@@ -132,8 +136,10 @@ namespace CPC464 {
   inline void Memory::write(uint16_t addr, uint8_t value)
   {
     uint8_t page = uint8_t(addr >> 14);
+#ifndef EP128EMU_NO_BREAKPOINTS
     if (haveBreakPoints)
       checkWriteBreakPoint(addr, page, value);
+#endif
     pageAddressTableW[page][addr] = value;
   }
 
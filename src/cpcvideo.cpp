@@ -78,6 +78,7 @@ namespace CPC464 {
   CPCVideo::CPCVideo(const CRTC6845& crtc_, const uint8_t *videoMemory_)
     : crtc(crtc_),
       lineBufPtr((uint8_t *) 0),
+      lineDataCnt(0),
       hSyncCnt(1),
       crtcHSyncCnt(0),
       crtcHSyncState(0),
@@ -115,10 +116,12 @@ namespace CPC464 {
 
   void CPCVideo::setColor(uint8_t penNum, uint8_t c)
   {
-    if (penNum & 0x10)
-      borderColor = c & 0x3F;
-    else
-      palette[penNum & 0x0F] = c & 0x3F;
+    uint8_t&  color = ((penNum & 0x10) ? borderColor : palette[penNum & 0x0F]);
+    if ((c & 0x3F) != color) {
+      if (lineDataCnt)
+        renderLineData();
+      color = c & 0x3F;
+    }
   }
 
   uint8_t CPCVideo::getColor(uint8_t penNum) const
@@ -128,77 +131,84 @@ namespace CPC464 {
     return palette[penNum & 0x0F];
   }
 
-  EP128EMU_REGPARM1 void CPCVideo::runOneCycle()
+  EP128EMU_REGPARM1 void CPCVideo::renderLineData()
   {
-    if (EP128EMU_EXPECT((unsigned int) hSyncCnt < 97U)) {
-      if (EP128EMU_UNLIKELY((reinterpret_cast<unsigned char *>(
-                                 &(videoDelayBuf[0])))[0] != 0)) {
-        lineBufPtr[0] = 0x01;           // sync
-        lineBufPtr[1] = 0x14;
-        lineBufPtr = lineBufPtr + 2;
+    // encode the buffered video data using the current palette and mode;
+    // this is done once per line, or before any change to the palette,
+    // border color or latched video mode
+    const uint32_t  *p = &(lineDataBuf[0]);
+    const uint32_t  *endp = p + lineDataCnt;
+    uint8_t *bufp = lineBufPtr;
+    lineDataCnt = 0;
+    for ( ; p < endp; p++) {
+      const uint8_t *d = reinterpret_cast<const uint8_t *>(p);
+      if (EP128EMU_UNLIKELY(d[0] != 0)) {
+        bufp[0] = 0x01;                 // sync
+        bufp[1] = 0x14;
+        bufp = bufp + 2;
+        continue;
       }
-      else if ((reinterpret_cast<unsigned char *>(&(videoDelayBuf[0])))[1]) {
-        uint8_t videoByte0 =
-            (reinterpret_cast<unsigned char *>(&(videoDelayBuf[0])))[2];
-        uint8_t videoByte1 =
-            (reinterpret_cast<unsigned char *>(&(videoDelayBuf[0])))[3];
-        switch (videoModeLatched) {
-        case 0:                         // 16 color mode
-          {
-            lineBufPtr[0] = 0x04;
-            lineBufPtr[1] = palette[pixelConvTable_16[videoByte0 & 0xAA]];
-            lineBufPtr[2] = palette[pixelConvTable_16[videoByte0 & 0x55]];
-            lineBufPtr[3] = palette[pixelConvTable_16[videoByte1 & 0xAA]];
-            lineBufPtr[4] = palette[pixelConvTable_16[videoByte1 & 0x55]];
-            lineBufPtr = lineBufPtr + 5;
-          }
-          break;
-        case 1:                         // 4 color mode
-          {
-            lineBufPtr[0] = 0x08;
-            lineBufPtr[1] = palette[pixelConvTable_4[videoByte0 & 0x88]];
-            lineBufPtr[2] = palette[pixelConvTable_4[videoByte0 & 0x44]];
-            lineBufPtr[3] = palette[pixelConvTable_4[videoByte0 & 0x22]];
-            lineBufPtr[4] = palette[pixelConvTable_4[videoByte0 & 0x11]];
-            lineBufPtr[5] = palette[pixelConvTable_4[videoByte1 & 0x88]];
-            lineBufPtr[6] = palette[pixelConvTable_4[videoByte1 & 0x44]];
-            lineBufPtr[7] = palette[pixelConvTable_4[videoByte1 & 0x22]];
-            lineBufPtr[8] = palette[pixelConvTable_4[videoByte1 & 0x11]];
-            lineBufPtr = lineBufPtr + 9;
-          }
-          break;
-        case 2:                         // 2 color mode
-          lineBufPtr[0] = 0x06;
-          lineBufPtr[1] = palette[0];
-          lineBufPtr[2] = palette[1];
-          lineBufPtr[3] = videoByte0;
-          lineBufPtr[4] = palette[0];
-          lineBufPtr[5] = palette[1];
-          lineBufPtr[6] = videoByte1;
-          lineBufPtr = lineBufPtr + 7;
-          break;
-        case 3:                         // 4 color mode (half resolution)
-          {
-            lineBufPtr[0] = 0x04;
-            lineBufPtr[1] = palette[pixelConvTable_16[videoByte0 & 0xAA] & 3];
-            lineBufPtr[2] = palette[pixelConvTable_16[videoByte0 & 0x55] & 3];
-            lineBufPtr[3] = palette[pixelConvTable_16[videoByte1 & 0xAA] & 3];
-            lineBufPtr[4] = palette[pixelConvTable_16[videoByte1 & 0x55] & 3];
-            lineBufPtr = lineBufPtr + 5;
-          }
-          break;
-        }
+      if (!d[1]) {
+        bufp[0] = 0x01;                 // border
+        bufp[1] = borderColor;
+        bufp = bufp + 2;
+        continue;
       }
-      else {
-        lineBufPtr[0] = 0x01;           // border
-        lineBufPtr[1] = borderColor;
-        lineBufPtr = lineBufPtr + 2;
+      uint8_t videoByte0 = d[2];
+      uint8_t videoByte1 = d[3];
+      switch (videoModeLatched) {
+      case 0:                           // 16 color mode
+        bufp[0] = 0x04;
+        bufp[1] = palette[pixelConvTable_16[videoByte0 & 0xAA]];
+        bufp[2] = palette[pixelConvTable_16[videoByte0 & 0x55]];
+        bufp[3] = palette[pixelConvTable_16[videoByte1 & 0xAA]];
+        bufp[4] = palette[pixelConvTable_16[videoByte1 & 0x55]];
+        bufp = bufp + 5;
+        break;
+      case 1:                           // 4 color mode
+        bufp[0] = 0x08;
+        bufp[1] = palette[pixelConvTable_4[videoByte0 & 0x88]];
+        bufp[2] = palette[pixelConvTable_4[videoByte0 & 0x44]];
+        bufp[3] = palette[pixelConvTable_4[videoByte0 & 0x22]];
+        bufp[4] = palette[pixelConvTable_4[videoByte0 & 0x11]];
+        bufp[5] = palette[pixelConvTable_4[videoByte1 & 0x88]];
+        bufp[6] = palette[pixelConvTable_4[videoByte1 & 0x44]];
+        bufp[7] = palette[pixelConvTable_4[videoByte1 & 0x22]];
+        bufp[8] = palette[pixelConvTable_4[videoByte1 & 0x11]];
+        bufp = bufp + 9;
+        break;
+      case 2:                           // 2 color mode
+        bufp[0] = 0x06;
+        bufp[1] = palette[0];
+        bufp[2] = palette[1];
+        bufp[3] = videoByte0;
+        bufp[4] = palette[0];
+        bufp[5] = palette[1];
+        bufp[6] = videoByte1;
+        bufp = bufp + 7;
+        break;
+      case 3:                           // 4 color mode (half resolution)
+        bufp[0] = 0x04;
+        bufp[1] = palette[pixelConvTable_16[videoByte0 & 0xAA] & 3];
+        bufp[2] = palette[pixelConvTable_16[videoByte0 & 0x55] & 3];
+        bufp[3] = palette[pixelConvTable_16[videoByte1 & 0xAA] & 3];
+        bufp[4] = palette[pixelConvTable_16[videoByte1 & 0x55] & 3];
+        bufp = bufp + 5;
+        break;
       }
     }
+    lineBufPtr = bufp;
+  }
+
+  EP128EMU_REGPARM1 void CPCVideo::runOneCycle()
+  {
+    if (EP128EMU_EXPECT((unsigned int) hSyncCnt < 97U))
+      lineDataBuf[lineDataCnt++] = videoDelayBuf[0];
     hSyncCnt += 2;
     if (EP128EMU_UNLIKELY(crtcHSyncCnt)) {      // horizontal sync
       if (crtcHSyncCnt == 3) {
         if (hSyncCnt >= (int(hSyncMax) - 8)) {
+          renderLineData();
           if (EP128EMU_EXPECT(hSyncCnt & 1))
             drawLine(lineBuf, size_t(lineBufPtr - lineBuf));
           else
@@ -209,7 +219,7 @@ namespace CPC464 {
         }
       }
       else if (crtcHSyncCnt == 7) {
-        videoModeLatched = videoMode;
+        latchVideoMode();
         hSyncLen = 4;
         if (vSyncCnt) {
           if (--vSyncCnt == 21)         // VSync start (delayed by 5 lines)
@@ -223,6 +233,7 @@ namespace CPC464 {
     }
     if ((unsigned int) (hSyncCnt + 4) >= 101U) {
       if (EP128EMU_UNLIKELY(hSyncCnt >= int(hSyncMax))) {
+        renderLineData();
         if (EP128EMU_EXPECT(hSyncCnt & 1))
           drawLine(lineBuf, size_t(lineBufPtr - lineBuf));
         else
@@ -490,6 +501,8 @@ namespace CPC464 {
 
   void CPCVideo::reset()
   {
+    if (lineDataCnt)
+      renderLineData();
     videoModeLatched = 0;
     videoDelayBuf[0] = 0U;
     videoDelayBuf[1] = 0U;
@@ -29,6 +29,10 @@ namespace CPC464 {
    protected:
     const CRTC6845& crtc;
     uint8_t   *lineBufPtr;
+    // video data (videoDelayBuf[0]) of the characters displayed in the
+    // current line that have not been written to lineBuf yet
+    uint32_t  lineDataBuf[64];
+    size_t    lineDataCnt;
     int       hSyncCnt;
     uint8_t   crtcHSyncCnt;
     uint8_t   crtcHSyncState;
@@ -89,7 +93,16 @@ namespace CPC464 {
     uint8_t getColor(uint8_t penNum) const;
     EP128EMU_REGPARM1 void runOneCycle();
    private:
+    EP128EMU_REGPARM1 void renderLineData();
     EP128EMU_REGPARM1 void shiftLineBuffer();
+    EP128EMU_INLINE void latchVideoMode()
+    {
+      if (videoMode != videoModeLatched) {
+        if (lineDataCnt)
+          renderLineData();
+        videoModeLatched = videoMode;
+      }
+    }
    public:
     EP128EMU_INLINE void crtcHSyncStateChange(bool newState)
     {
@@ -97,7 +110,7 @@ namespace CPC464 {
         if (EP128EMU_UNLIKELY(crtcHSyncCnt)) {
           if (crtcHSyncCnt >= 4)
             hSyncLen = crtcHSyncCnt - 3;
-          videoModeLatched = videoMode;
+          latchVideoMode();
           if (vSyncCnt) {
             if (--vSyncCnt == 21)       // VSync start (delayed by 5 lines)
               vsyncStateChange(true, (crtc.getVSyncInterlace() ? 34U : 6U));
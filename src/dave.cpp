@@ -19,6 +19,7 @@
 
 #include "ep128emu.hpp"
 #include "dave.hpp"
+#include "perfcnt.hpp"
 #include <cmath>
 
 // Generate polynomial counter of log2(m0) + 1 bits length, and store
@@ -98,6 +99,7 @@ namespace Ep128 {
 
   uint32_t Dave::runOneCycle_()
   {
+    EP128EMU_PERF_SCOPE(PERF_DAVE_CYCLE, 8);
     // update polynomial counters
     if (--polycnt4_phase < 0)                   // 4-bit
       polycnt4_phase = 14;
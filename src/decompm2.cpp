@@ -22,22 +22,50 @@
 
 namespace Ep128Emu {
 
-  unsigned int Decompressor::readBits(size_t nBits)
+  const unsigned char Decompressor::leadingOnesTable[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,     // 0x00
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,     // 0x80
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,     // 0xC0
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,     // 0xE0
+    4, 4, 4, 4, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 7, 8      // 0xF0
+  };
+
+  // NOTE: the bit stream cannot be buffered ahead of the current byte,
+  // because literal bytes are stored between the bytes of the bit stream,
+  // at the position where they are read; but all bits that are available
+  // in the current byte are extracted at once
+
+  EP128EMU_INLINE unsigned int Decompressor::readBits(size_t nBits)
   {
-    unsigned int  retval = 0U;
-    for (size_t i = 0; i < nBits; i++) {
-      if (EP128EMU_UNLIKELY(!(shiftRegister & 0x7F))) {
-        if (inputBufferPosition >= inputBufferSize)
-          throw Exception("unexpected end of compressed data");
-        shiftRegister = inputBuffer[inputBufferPosition++];
-        retval = (retval << 1) | ((shiftRegister >> 7) & 0x01);
-        shiftRegister = (shiftRegister << 1) | 0x01;
-        continue;
+    unsigned int  n = (unsigned int) nBits;
+    if (EP128EMU_EXPECT(n <= shiftRegisterBits)) {
+      shiftRegisterBits -= n;
+      return ((shiftRegister >> shiftRegisterBits) & ((1U << n) - 1U));
+    }
+    unsigned int  retval = shiftRegister & ((1U << shiftRegisterBits) - 1U);
+    n -= shiftRegisterBits;
+    while (true) {
+      if (inputBufferPosition >= inputBufferSize)
+        throw Exception("unexpected end of compressed data");
+      shiftRegister = inputBuffer[inputBufferPosition++];
+      if (n <= 8U) {
+        shiftRegisterBits = 8U - n;
+        return ((retval << n) | (shiftRegister >> shiftRegisterBits));
       }
-      retval = (retval << 1) | ((shiftRegister >> 7) & 0x01);
-      shiftRegister = shiftRegister << 1;
+      retval = (retval << 8) | shiftRegister;
+      n -= 8U;
     }
-    return retval;
   }
 
   unsigned char Decompressor::readLiteralByte()
@@ -47,23 +75,43 @@ namespace Ep128Emu {
     return inputBuffer[inputBufferPosition++];
   }
 
-  unsigned int Decompressor::readMatchLength()
+  EP128EMU_INLINE unsigned int Decompressor::readLZMatchParameter(
+      unsigned int slotNum, const unsigned int *decodeTable)
   {
-    if (!readBits(1))
-      return 0x80000001U;                       // literal byte
-    unsigned char slotNum = 0;
-    while (readBits(1) != 0U) {
-      if (++slotNum >= 8)
-        return (readBits(8) + 0x80000011U);     // literal sequence
-    }
-    return readLZMatchParameter(slotNum, &(lengthDecodeTable[0]));
+    return (decodeTable[slotNum * 2U]
+            + readBits(size_t(decodeTable[slotNum * 2U + 1U])));
   }
 
-  unsigned int Decompressor::readLZMatchParameter(
-      unsigned char slotNum, const unsigned int *decodeTable)
+  unsigned int Decompressor::readMatchLength()
   {
-    return (decodeTable[int(slotNum) * 2]
-            + readBits(size_t(decodeTable[int(slotNum) * 2 + 1])));
+    // the length is encoded as a flag bit (0: literal byte), and a slot
+    // number in unary code (8 or more: literal sequence); the 1 bits are
+    // counted in up to 8 bits at a time
+    unsigned int  nOnes = 0U;
+    while (true) {
+      if (EP128EMU_UNLIKELY(!shiftRegisterBits)) {
+        if (inputBufferPosition >= inputBufferSize)
+          throw Exception("unexpected end of compressed data");
+        shiftRegister = inputBuffer[inputBufferPosition++];
+        shiftRegisterBits = 8U;
+      }
+      unsigned int  n = leadingOnesTable[(shiftRegister
+                                          << (8U - shiftRegisterBits))
+                                         & 0xFFU];
+      if ((nOnes + n) >= 9U) {
+        shiftRegisterBits -= (9U - nOnes);
+        return (readBits(8) + 0x80000011U);     // literal sequence
+      }
+      nOnes += n;
+      shiftRegisterBits -= n;
+      if (shiftRegisterBits) {
+        shiftRegisterBits--;                    // skip terminating 0 bit
+        break;
+      }
+    }
+    if (!nOnes)
+      return 0x80000001U;                       // literal byte
+    return readLZMatchParameter(nOnes - 1U, &(lengthDecodeTable[0]));
   }
 
   void Decompressor::readDecodeTables()
@@ -123,24 +171,24 @@ namespace Ep128Emu {
           // get match offset:
           unsigned int  offs = 0U;
           if (matchLength == 1U) {
-            offs = readLZMatchParameter((unsigned char) readBits(2),
-                                        &(offs1DecodeTable[0]));
+            offs = readLZMatchParameter(readBits(2), &(offs1DecodeTable[0]));
           }
           else if (matchLength == 2U) {
-            offs = readLZMatchParameter((unsigned char) readBits(3),
-                                        &(offs2DecodeTable[0]));
+            offs = readLZMatchParameter(readBits(3), &(offs2DecodeTable[0]));
           }
           else {
-            offs = readLZMatchParameter(
-                       (unsigned char) readBits(offs3PrefixSize),
-                       &(offs3DecodeTable[0]));
+            offs = readLZMatchParameter(readBits(offs3PrefixSize),
+                                        &(offs3DecodeTable[0]));
           }
           if (offs > buf.size())
             throw Exception("error in compressed data");
-          size_t  lzMatchReadPos = buf.size() - offs;
+          // copy match (the source and destination may overlap)
+          size_t  lzMatchWritePos = buf.size();
+          buf.resize(lzMatchWritePos + matchLength);
+          unsigned char *p = &(buf.front()) + lzMatchWritePos;
+          const unsigned char *q = p - offs;
           do {
-            buf.push_back(buf[lzMatchReadPos]);
-            lzMatchReadPos++;
+            *(p++) = *(q++);
           } while (--matchLength);
         }
       } while (--nSymbols);
@@ -152,7 +200,8 @@ namespace Ep128Emu {
 
   Decompressor::Decompressor()
     : offs3PrefixSize(2),
-      shiftRegister(0x80),
+      shiftRegister(0U),
+      shiftRegisterBits(0U),
       inputBuffer((unsigned char *) 0),
       inputBufferSize(0),
       inputBufferPosition(0)
@@ -183,12 +232,13 @@ namespace Ep128Emu {
     inputBuffer = inBuf;
     inputBufferSize = inBufSize;
     inputBufferPosition = 1;
-    shiftRegister = 0x80;
+    shiftRegister = 0U;
+    shiftRegisterBits = 0U;
     while (!decompressDataBlock(outBuf))
       ;
     // on successful decompression, all input data must be consumed
     if (!(inputBufferPosition >= inputBufferSize &&
-          !(shiftRegister & (shiftRegister - 1)))) {
+          !(shiftRegister & ((1U << shiftRegisterBits) - 1U)))) {
       throw Exception("error in compressed data");
     }
   }
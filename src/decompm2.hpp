@@ -32,18 +32,28 @@ namespace Ep128Emu {
     unsigned int  offs2DecodeTable[8 * 2];
     unsigned int  offs3DecodeTable[32 * 2];
     size_t        offs3PrefixSize;
-    unsigned char shiftRegister;
+    // bits of the last byte read from the bit stream that are not used yet,
+    // in the lower 'shiftRegisterBits' bits (MSB first)
+    unsigned int  shiftRegister;
+    unsigned int  shiftRegisterBits;
     const unsigned char *inputBuffer;
     size_t        inputBufferSize;
     size_t        inputBufferPosition;
+    // the number of leading 1 bits in each byte value
+    static const unsigned char leadingOnesTable[256];
     // --------
-    unsigned int readBits(size_t nBits);
+    inline unsigned int readBits(size_t nBits);
     unsigned char readLiteralByte();
     // returns LZ match length (1..65535),
     // or length + 0x80000000 for literal sequence
     unsigned int readMatchLength();
-    unsigned int readLZMatchParameter(unsigned char slotNum,
-                                      const unsigned int *decodeTable);
+    // returns the base value of slot 'slotNum' in 'decodeTable', plus the
+    // extra bits of the slot; the slot number is a fixed size field for
+    // offsets, so unlike for the unary length prefix, no table is needed to
+    // decode it, and readBits() already extracts all bits of the slot
+    // number and of the value that are in the current byte at once
+    inline unsigned int readLZMatchParameter(unsigned int slotNum,
+                                             const unsigned int *decodeTable);
     void readDecodeTables();
     bool decompressDataBlock(std::vector< unsigned char >& buf);
    public:
@@ -58,8 +68,15 @@ namespace Ep128Emu {
 
   // --------------------------------------------------------------------------
 
+  // Compresses 'inBufSize' bytes in the format expected by decompressData().
+  // If 'fastMode' is true, a greedy parse with lazy matching is used instead
+  // of the much slower near-optimal one, at the cost of a lower compression
+  // ratio. The data is split into 128 KiB segments that are compressed by
+  // up to 'maxThreads' threads (<= 0: the number of CPUs); the output does
+  // not depend on the number of threads.
   extern void compressData(std::vector< unsigned char >& outBuf,
-                           const unsigned char *inBuf, size_t inBufSize);
+                           const unsigned char *inBuf, size_t inBufSize,
+                           bool fastMode = false, int maxThreads = 0);
 
 }       // namespace Ep128Emu
 
@@ -21,6 +21,7 @@
 #include "cfg_db.hpp"
 #include "emucfg.hpp"
 #include "system.hpp"
+#include "perfcnt.hpp"
 #include "ep128vm.hpp"
 #include "zx128vm.hpp"
 #include "cpc464vm.hpp"
@@ -44,9 +45,10 @@ static void defineConfigurationVariable(
 {
   value = defaultValue;
   changeFlag = true;
-  db.createKey(name, value);
-  db[name].setRange(minVal, maxVal, step);
-  db[name].setCallback(&(configChangeCallback<T>), &changeFlag, true);
+  Ep128Emu::ConfigurationDB::ConfigurationVariable&  cv =
+      db.createKey(name, value);
+  cv.setRange(minVal, maxVal, step);
+  cv.setCallback(&(configChangeCallback<T>), &changeFlag, true);
 }
 
 static void defineConfigurationVariable(
@@ -55,8 +57,8 @@ static void defineConfigurationVariable(
 {
   value = defaultValue;
   changeFlag = true;
-  db.createKey(name, value);
-  db[name].setCallback(&(configChangeCallback<bool>), &changeFlag, true);
+  db.createKey(name, value).setCallback(&(configChangeCallback<bool>),
+                                        &changeFlag, true);
 }
 
 static void defineConfigurationVariable(
@@ -65,10 +67,11 @@ static void defineConfigurationVariable(
 {
   value = defaultValue;
   changeFlag = true;
-  db.createKey(name, value);
-  db[name].setStripString(true);
-  db[name].setCallback(&(configChangeCallback<const std::string&>),
-                       &changeFlag, true);
+  Ep128Emu::ConfigurationDB::ConfigurationVariable&  cv =
+      db.createKey(name, value);
+  cv.setStripString(true);
+  cv.setCallback(&(configChangeCallback<const std::string&>),
+                 &changeFlag, true);
 }
 
 static void defaultErrorCallback(void *userData, const char *msg)
@@ -132,6 +135,7 @@ namespace Ep128Emu {
                                 memory.ram.size, 128,
                                 memoryConfigurationChanged, 64.0, 3712.0, 16.0);
     for (size_t i = 0; i < 68; i++) {
+      romSegmentChanged[i] = false;
       if (i >= 8 && (i & 15) >= 4)
         continue;
       char  tmpBuf[24];
@@ -139,11 +143,11 @@ namespace Ep128Emu {
       std::sprintf(s, "memory.rom.%02X.file", (unsigned int) i);
       defineConfigurationVariable(*this, std::string(s),
                                   memory.rom[i].file, std::string(""),
-                                  memoryConfigurationChanged);
+                                  romSegmentChanged[i]);
       std::sprintf(s, "memory.rom.%02X.offset", (unsigned int) i);
       defineConfigurationVariable(*this, std::string(s),
                                   memory.rom[i].offset, int(0),
-                                  memoryConfigurationChanged, 0.0, 16760832.0);
+                                  romSegmentChanged[i], 0.0, 16760832.0);
     }
     defineConfigurationVariable(*this, "memory.configFile",
                                 memory.configFile, std::string(""),
@@ -248,25 +252,25 @@ namespace Ep128Emu {
                                 soundSettingsChanged);
     defineConfigurationVariable(*this, "sound.volume",
                                 sound.volume, 0.7071,
-                                soundSettingsChanged, 0.01, 1.0);
+                                soundFilterSettingsChanged, 0.01, 1.0);
     defineConfigurationVariable(*this, "sound.dcBlockFilter1Freq",
                                 sound.dcBlockFilter1Freq, 10.0,
-                                soundSettingsChanged, 1.0, 1000.0);
+                                soundFilterSettingsChanged, 1.0, 1000.0);
     defineConfigurationVariable(*this, "sound.dcBlockFilter2Freq",
                                 sound.dcBlockFilter2Freq, 10.0,
-                                soundSettingsChanged, 1.0, 1000.0);
+                                soundFilterSettingsChanged, 1.0, 1000.0);
     defineConfigurationVariable(*this, "sound.equalizer.mode",
                                 sound.equalizer.mode, int(-1),
-                                soundSettingsChanged, -1.0, 2.0);
+                                soundFilterSettingsChanged, -1.0, 2.0);
     defineConfigurationVariable(*this, "sound.equalizer.frequency",
                                 sound.equalizer.frequency, 1000.0,
-                                soundSettingsChanged, 1.0, 100000.0);
+                                soundFilterSettingsChanged, 1.0, 100000.0);
     defineConfigurationVariable(*this, "sound.equalizer.level",
                                 sound.equalizer.level, 1.0,
-                                soundSettingsChanged, 0.0001, 100.0);
+                                soundFilterSettingsChanged, 0.0001, 100.0);
     defineConfigurationVariable(*this, "sound.equalizer.q",
                                 sound.equalizer.q, 0.7071,
-                                soundSettingsChanged, 0.001, 100.0);
+                                soundFilterSettingsChanged, 0.001, 100.0);
 #ifdef ENABLE_MIDI_PORT
     defineConfigurationVariable(*this, "sound.midiDevice",
                                 sound.midiDevice, int(-1),
@@ -451,10 +455,14 @@ namespace Ep128Emu {
       defineConfigurationVariable(*this, "sid.3.volumeR",
                                   sid.volumeR, 1.0,
                                   sidConfigurationChanged, 0.0, 2.0);
+      defineConfigurationVariable(*this, "sid.3.highQuality",
+                                  sid.highQuality, false,
+                                  sidConfigurationChanged);
 #else
       sid.model = 0;
       sid.volumeL = 1.0;
       sid.volumeR = 1.0;
+      sid.highQuality = false;
 #endif
     // set machine specific defaults
     if (typeid(vm_) != typeid(Ep128::Ep128VM)) {
@@ -500,6 +508,7 @@ namespace Ep128Emu {
   void EmulatorConfiguration::applySettings()
   {
     if (vmConfigurationChanged) {
+      EP128EMU_PERF_SCOPE(PERF_CONFIG_VM, 0);
       if (typeid(vm_) != typeid(Ep128::Ep128VM)) {
         if (typeid(vm_) == typeid(ZX128::ZX128VM)) {            // Spectrum
           vm.soundClockFrequency = (vm.videoClockFrequency + 2U) >> 2;
@@ -536,7 +545,25 @@ namespace Ep128Emu {
       }
       vmProcessPriorityChanged = false;
     }
+    if (!memoryConfigurationChanged) {
+      // on the Enterprise, a ROM segment loaded over RAM relocates the RAM
+      // segment (see Ep128VM::loadROMSegment()), and the new location
+      // depends on the order of loading; if any ROM is or was at a RAM
+      // segment, the whole memory map is rebuilt instead of reloading only
+      // the changed segments
+      bool    romChanged = false;
+      bool    romInRAM = false;
+      for (size_t i = 0; i < 68; i++) {
+        romChanged = romChanged || romSegmentChanged[i];
+        if (isROMSegmentInRAM_(i) &&
+            (romSegmentChanged[i] || memory.rom[i].file.length() > 0)) {
+          romInRAM = true;
+        }
+      }
+      memoryConfigurationChanged = (romChanged && romInRAM);
+    }
     if (memoryConfigurationChanged) {
+      EP128EMU_PERF_SCOPE(PERF_CONFIG_MEMORY, 0);
       if (typeid(vm_) != typeid(Ep128::Ep128VM)) {
         memory.configFile.clear();
         if (typeid(vm_) == typeid(ZX128::ZX128VM)) {            // Spectrum
@@ -559,6 +586,8 @@ namespace Ep128Emu {
         try {
           vm_.loadMemoryConfiguration(memory.configFile);
           memoryConfigurationChanged = false;
+          for (size_t i = 0; i < 68; i++)
+            romSegmentChanged[i] = false;
         }
         catch (Exception& e) {
           errorCallback(errorCallbackUserData, e.what());
@@ -567,45 +596,8 @@ namespace Ep128Emu {
       else {
         vm_.resetMemoryConfiguration(memory.ram.size);
         for (size_t i = 0; i < 68; i++) {
-          uint8_t segNum = uint8_t(i);
-          if (typeid(vm_) == typeid(Ep128::Ep128VM)) {
-            if (i >= 8 && (i & 15) >= 4) {
-              memory.rom[i].file.clear();
-              memory.rom[i].offset = 0;
-              continue;
-            }
-          }
-          else if (typeid(vm_) == typeid(ZX128::ZX128VM)) {
-            if (i >= 2) {
-              memory.rom[i].file.clear();
-              memory.rom[i].offset = 0;
-              continue;
-            }
-            segNum = segNum | 0x80;
-          }
-          else if (typeid(vm_) == typeid(CPC464::CPC464VM)) {
-            if (i >= 8 && i != 16) {
-              memory.rom[i].file.clear();
-              memory.rom[i].offset = 0;
-              continue;
-            }
-            segNum = segNum + uint8_t(i < 8 ? 0xC0 : 0x70);
-          }
-          else if (i > 4) {                     // TVC
-            memory.rom[i].file.clear();
-            memory.rom[i].offset = 0;
-            continue;
-          }
-          try {
-            vm_.loadROMSegment(segNum, memory.rom[i].file.c_str(),
-                               size_t(memory.rom[i].offset));
-          }
-          catch (Exception& e) {
-            memory.rom[i].file.clear();
-            memory.rom[i].offset = 0;
-            vm_.loadROMSegment(segNum, "", 0);
-            errorCallback(errorCallbackUserData, e.what());
-          }
+          loadROMSegment_(i);
+          romSegmentChanged[i] = false;
         }
         memoryConfigurationChanged = false;
       }
@@ -620,7 +612,27 @@ namespace Ep128Emu {
       }
 #endif
     }
+    else {
+      // only some ROM segments have changed: reload those, and reinitialize
+      // RAM and hard reset the machine as a full reconfiguration would do
+      bool    romChanged = false;
+      for (size_t i = 0; i < 68; i++) {
+        if (romSegmentChanged[i]) {
+          EP128EMU_PERF_SCOPE(PERF_CONFIG_MEMORY, 0);
+          romSegmentChanged[i] = false;
+          if (memory.configFile.length() < 1) {
+            loadROMSegment_(i);
+            romChanged = true;
+          }
+        }
+      }
+      if (romChanged) {
+        vm_.clearRAM();
+        vm_.reset(true);
+      }
+    }
     if (displaySettingsChanged) {
+      EP128EMU_PERF_SCOPE(PERF_CONFIG_DISPLAY, 0);
       // assume that changing the display settings will not fail
       vm_.setEnableDisplay(display.enabled);
       VideoDisplay::DisplayParameters dp(videoDisplay.getDisplayParameters());
@@ -649,6 +661,7 @@ namespace Ep128Emu {
       displaySettingsChanged = false;
     }
     if (soundSettingsChanged) {
+      EP128EMU_PERF_SCOPE(PERF_CONFIG_SOUND, 0);
       bool    soundEnableFlag = (sound.enabled && vm.speedPercentage == 100U);
       videoDisplay.limitFrameRate(vm.speedPercentage == 0U);
       vm_.setEnableAudioOutput(soundEnableFlag);
@@ -667,15 +680,8 @@ namespace Ep128Emu {
           errorCallback(errorCallbackUserData, e.what());
         }
       }
-      vm_.setAudioOutputHighQuality(sound.highQuality);
       vm_.setAudioOutputMono(sound.mono);
-      vm_.setAudioOutputVolume(float(sound.volume));
-      vm_.setAudioOutputFilters(float(sound.dcBlockFilter1Freq),
-                                float(sound.dcBlockFilter2Freq));
-      vm_.setAudioOutputEqualizer(sound.equalizer.mode,
-                                  float(sound.equalizer.frequency),
-                                  float(sound.equalizer.level),
-                                  float(sound.equalizer.q));
+      vm_.setAudioOutputHighQuality(sound.highQuality);
       try {
         audioOutput.setOutputFile(sound.file);
       }
@@ -685,6 +691,19 @@ namespace Ep128Emu {
         errorCallback(errorCallbackUserData, e.what());
       }
       soundSettingsChanged = false;
+      soundFilterSettingsChanged = true;
+    }
+    if (soundFilterSettingsChanged) {
+      EP128EMU_PERF_SCOPE(PERF_CONFIG_SOUND, 0);
+      // these only update the parameters of the existing audio converter
+      vm_.setAudioOutputVolume(float(sound.volume));
+      vm_.setAudioOutputFilters(float(sound.dcBlockFilter1Freq),
+                                float(sound.dcBlockFilter2Freq));
+      vm_.setAudioOutputEqualizer(sound.equalizer.mode,
+                                  float(sound.equalizer.frequency),
+                                  float(sound.equalizer.level),
+                                  float(sound.equalizer.q));
+      soundFilterSettingsChanged = false;
     }
 #ifdef ENABLE_MIDI_PORT
     if (midiSettingsChanged) {
@@ -719,6 +738,7 @@ namespace Ep128Emu {
                            (i == 1 ? floppyBChanged :
                             (i == 2 ? floppyCChanged : floppyDChanged)));
       if (isChanged) {
+        EP128EMU_PERF_SCOPE(PERF_CONFIG_MEDIA, 0);
         try {
           vm_.setDiskImageFile(i, cfg.imageFile,
                                cfg.tracks, cfg.sides, cfg.sectorsPerTrack);
@@ -740,6 +760,7 @@ namespace Ep128Emu {
                            (i == 1 ? ideDisk1Changed :
                             (i == 2 ? ideDisk2Changed : ideDisk3Changed)));
       if (isChanged) {
+        EP128EMU_PERF_SCOPE(PERF_CONFIG_MEDIA, 0);
         try {
           vm_.setDiskImageFile(i + 4, imageFile, -1, -1, -1);
         }
@@ -753,6 +774,7 @@ namespace Ep128Emu {
     }
 #ifdef ENABLE_SDEXT
     if (sdCardImageChanged) {
+      EP128EMU_PERF_SCOPE(PERF_CONFIG_MEDIA, 0);
       try {
         vm_.setDiskImageFile(8, sdext.imageFile, -1, -1, -1);
       }
@@ -770,6 +792,7 @@ namespace Ep128Emu {
       tapeSettingsChanged = false;
     }
     if (tapeFileChanged) {
+      EP128EMU_PERF_SCOPE(PERF_CONFIG_MEDIA, 0);
       try {
         vm_.setTapeFileName(tape.imageFile);
       }
@@ -812,11 +835,66 @@ namespace Ep128Emu {
 #ifdef ENABLE_RESID
     if (sidConfigurationChanged) {
       sidConfigurationChanged = false;
-      vm_.setSIDConfiguration(3, sid.model, sid.volumeL, sid.volumeR);
+      vm_.setSIDConfiguration(3, sid.model, sid.volumeL, sid.volumeR,
+                              sid.highQuality);
     }
 #endif
   }
 
+  void EmulatorConfiguration::loadROMSegment_(size_t n)
+  {
+    uint8_t segNum = uint8_t(n);
+    if (typeid(vm_) == typeid(Ep128::Ep128VM)) {
+      if (n >= 8 && (n & 15) >= 4) {
+        memory.rom[n].file.clear();
+        memory.rom[n].offset = 0;
+        return;
+      }
+    }
+    else if (typeid(vm_) == typeid(ZX128::ZX128VM)) {
+      if (n >= 2) {
+        memory.rom[n].file.clear();
+        memory.rom[n].offset = 0;
+        return;
+      }
+      segNum = segNum | 0x80;
+    }
+    else if (typeid(vm_) == typeid(CPC464::CPC464VM)) {
+      if (n >= 8 && n != 16) {
+        memory.rom[n].file.clear();
+        memory.rom[n].offset = 0;
+        return;
+      }
+      segNum = segNum + uint8_t(n < 8 ? 0xC0 : 0x70);
+    }
+    else if (n > 4) {                   // TVC
+      memory.rom[n].file.clear();
+      memory.rom[n].offset = 0;
+      return;
+    }
+    try {
+      vm_.loadROMSegment(segNum, memory.rom[n].file.c_str(),
+                         size_t(memory.rom[n].offset));
+    }
+    catch (Exception& e) {
+      memory.rom[n].file.clear();
+      memory.rom[n].offset = 0;
+      vm_.loadROMSegment(segNum, "", 0);
+      errorCallback(errorCallbackUserData, e.what());
+    }
+  }
+
+  bool EmulatorConfiguration::isROMSegmentInRAM_(size_t n) const
+  {
+    if (typeid(vm_) != typeid(Ep128::Ep128VM) || memory.configFile.length() > 0)
+      return false;
+    // RAM is at the top segments, as allocated by
+    // Ep128VM::resetMemoryConfiguration()
+    size_t  nSegments = (size_t(memory.ram.size) + 15) >> 4;
+    nSegments = (nSegments > 4 ? (nSegments < 232 ? nSegments : 232) : 4);
+    return (n >= (256 - nSegments));
+  }
+
   int EmulatorConfiguration::convertKeyCode(int keyCode)
   {
     std::map< int, int >::iterator  i;
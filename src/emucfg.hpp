@@ -44,6 +44,10 @@ namespace Ep128Emu {
     std::map< int, int >  keyboardMap;
     void            (*errorCallback)(void *, const char *);
     void            *errorCallbackUserData;
+    void loadROMSegment_(size_t n);
+    // returns true if ROM slot 'n' is at a segment that would be RAM
+    // without any ROM loaded
+    bool isROMSegmentInRAM_(size_t n) const;
    public:
     struct {
       unsigned int  cpuClockFrequency;
@@ -79,7 +83,12 @@ namespace Ep128Emu {
       std::string       configFile;
     };
     MemoryConfiguration_  memory;
+    // a change of the RAM size or the configuration file requires reloading
+    // all segments and a hard reset
     bool          memoryConfigurationChanged;
+    // set if memory.rom[n] is changed, only segment n is reloaded, unless
+    // it is shared with RAM; cleared when the change has been applied
+    bool          romSegmentChanged[68];
     // --------
     struct {
       bool        enabled;
@@ -139,6 +148,8 @@ namespace Ep128Emu {
     };
     SoundConfiguration_   sound;
     bool          soundSettingsChanged;
+    // volume, DC block filters and equalizer: these are updated in place
+    bool          soundFilterSettingsChanged;
 #ifdef ENABLE_MIDI_PORT
     bool          midiSettingsChanged;
 #endif
@@ -243,6 +254,7 @@ namespace Ep128Emu {
       int         model;
       double      volumeL;
       double      volumeR;
+      bool        highQuality;
     } sid;
     bool          sidConfigurationChanged;
     // ----------------
@@ -148,10 +148,13 @@ namespace Ep128 {
     else {
       vm.cpuCyclesRemaining -= (int64_t(4) << 32);
     }
-    if (!vm.singleStepMode)
-      return vm.memory.readOpcode(addr);
-    // single step mode
-    return vm.checkSingleStepModeBreak();
+#ifndef EP128EMU_NO_BREAKPOINTS
+    if (vm.singleStepMode) {
+      // single step mode
+      return vm.checkSingleStepModeBreak();
+    }
+#endif
+    return vm.memory.readOpcode(addr);
   }
 
   EP128EMU_REGPARM2 uint8_t Ep128VM::Z80_::readOpcodeSecondByte(
@@ -1212,6 +1215,10 @@ namespace Ep128 {
         vm.setCallback(&Ep128VM::sidCallback, &vm, true);
         vm.sidEnabled = true;
       }
+      else if (!vm.sidHighQuality) {
+        // run the SID up to the time of the write
+        vm.sidClockPendingCycles();
+      }
       vm.sid->write(vm.sidAddressRegister, value);
     }
   }
@@ -1315,6 +1322,25 @@ namespace Ep128 {
 
 #ifdef ENABLE_RESID
 
+  // number of DAVE cycles (two SID cycles each) clocked at once in fast mode
+  static const int32_t  sidBlockSize = 8;
+
+  static EP128EMU_INLINE uint32_t sidOutputToDAC(int32_t sidOutput,
+                                                 int32_t volumeL,
+                                                 int32_t volumeR)
+  {
+    // FIXME: this is the maximum safe range with all 4 DAVE channels
+    // active, but it can overflow with tape feedback (unlikely in
+    // practice)
+    const int32_t sidOutputMax = (65535 - (63 * 4 * 128)) << 15;
+    const int32_t sidOutputOffs = (65535 - (63 * 4 * 128) + 1) << 14;
+    int32_t outL = sidOutput * volumeL + sidOutputOffs;
+    int32_t outR = sidOutput * volumeR + sidOutputOffs;
+    outL = (outL >= 0 ? (outL < sidOutputMax ? outL : sidOutputMax) : 0);
+    outR = (outR >= 0 ? (outR < sidOutputMax ? outR : sidOutputMax) : 0);
+    return uint32_t((outL >> 15) | ((outR >> 15) << 16));
+  }
+
   void Ep128VM::sidCallback(void *userData)
   {
     Ep128VM&  vm = *(reinterpret_cast<Ep128VM *>(userData));
@@ -1322,23 +1348,41 @@ namespace Ep128 {
     if (tmp >= 0L) {
       do {
         tmp -= (int64_t(1) << 32);
-        vm.sidOutputAccumulator = 0;
-        SID::clockCallback(vm.sid);
-        SID::clockCallback(vm.sid);
-        // FIXME: this is the maximum safe range with all 4 DAVE channels
-        // active, but it can overflow with tape feedback (unlikely in
-        // practice)
-        const int32_t sidOutputMax = (65535 - (63 * 4 * 128)) << 15;
-        const int32_t sidOutputOffs = (65535 - (63 * 4 * 128) + 1) << 14;
-        int32_t outL = vm.sidOutputAccumulator * vm.sidVolumeL + sidOutputOffs;
-        int32_t outR = vm.sidOutputAccumulator * vm.sidVolumeR + sidOutputOffs;
-        outL = (outL >= 0 ? (outL < sidOutputMax ? outL : sidOutputMax) : 0);
-        outR = (outR >= 0 ? (outR < sidOutputMax ? outR : sidOutputMax) : 0);
-        vm.externalDACOutput = uint32_t((outL >> 15) | ((outR >> 15) << 16));
+        if (vm.sidHighQuality) {
+          int     buf[2];
+          vm.sid->clock_block(2, buf);
+          vm.sidOutput = (int32_t(buf[0]) << 3) + (int32_t(buf[1]) << 3);
+        }
+        else {
+          if (++vm.sidCyclesPending >= sidBlockSize)
+            vm.sidClockPendingCycles();
+          if (vm.sidOutputStepsLeft > 0) {
+            if (--vm.sidOutputStepsLeft > 0)
+              vm.sidOutput += vm.sidOutputStep;
+            else
+              vm.sidOutput = vm.sidOutputTarget;
+          }
+        }
+        vm.externalDACOutput =
+            sidOutputToDAC(vm.sidOutput, vm.sidVolumeL, vm.sidVolumeR);
       } while (EP128EMU_UNLIKELY(tmp >= 0L));
     }
   }
 
+  void Ep128VM::sidClockPendingCycles()
+  {
+    if (sidCyclesPending < 1)
+      return;
+    // clock the SID using the faster multi-cycle functions of reSID, and
+    // interpolate from the current output to the new one over one block
+    sidOutputAccumulator = 0;
+    sid->clock_fast(cycle_count(sidCyclesPending) << 1);
+    sidCyclesPending = 0;
+    sidOutputTarget = sidOutputAccumulator * 2;
+    sidOutputStep = (sidOutputTarget - sidOutput) / sidBlockSize;
+    sidOutputStepsLeft = sidBlockSize;
+  }
+
 #endif
 
   uint8_t Ep128VM::checkSingleStepModeBreak()
@@ -1612,7 +1656,13 @@ namespace Ep128 {
       sidAddressRegister(0x00),
       sidOutputAccumulator(0),
       sidVolumeL(1039),
-      sidVolumeR(1039)
+      sidVolumeR(1039),
+      sidHighQuality(false),
+      sidCyclesPending(0),
+      sidOutput(0),
+      sidOutputTarget(0),
+      sidOutputStep(0),
+      sidOutputStepsLeft(0)
 #endif
 #ifdef ENABLE_MIDI_PORT
       , midiBufferReadPos(0),
@@ -1770,8 +1820,10 @@ namespace Ep128 {
         } while (EP128EMU_UNLIKELY(daveCyclesRemaining >= 0L));
       }
       cpuCyclesRemaining += cpuCyclesPerNickCycle;
-      while (cpuCyclesRemaining >= 0L)
+      while (cpuCyclesRemaining >= 0L) {
         z80.executeInstruction();
+        z80ProfilerUpdate();
+      }
       nick.runOneSlot();
     } while (EP128EMU_EXPECT(--nickCyclesRemainingH > 0));
   }
@@ -1828,6 +1880,10 @@ namespace Ep128 {
       }
       sid->reset();
     }
+    sidCyclesPending = 0;
+    sidOutput = 0;
+    sidOutputTarget = 0;
+    sidOutputStepsLeft = 0;
 #endif
 #ifdef ENABLE_MIDI_PORT
     midiBufferMutex.lock();
@@ -1841,10 +1897,18 @@ namespace Ep128 {
 #ifdef ENABLE_RESID
 
   void Ep128VM::setSIDConfiguration(int n, int model,
-                                    double volumeL, double volumeR)
+                                    double volumeL, double volumeR,
+                                    bool highQuality)
   {
     if (n != 3)
       return;
+    if (highQuality != sidHighQuality) {
+      if (sidEnabled && !sidHighQuality)
+        sidClockPendingCycles();
+      sidHighQuality = highQuality;
+      sidCyclesPending = 0;
+      sidOutputStepsLeft = 0;
+    }
     if (model <= 0 || model > 2) {
       if (sidEnabled) {
         setCallback(&sidCallback, this, false);
@@ -232,6 +232,14 @@ namespace Ep128 {
     int32_t   sidOutputAccumulator;
     int32_t   sidVolumeL;
     int32_t   sidVolumeR;
+    bool      sidHighQuality;           // clock the SID on every cycle
+    // fast mode: DAVE cycles elapsed since the SID was last clocked, and
+    // the output interpolated towards the value at the end of the last block
+    int32_t   sidCyclesPending;
+    int32_t   sidOutput;
+    int32_t   sidOutputTarget;
+    int32_t   sidOutputStep;
+    int32_t   sidOutputStepsLeft;
 #endif
 #ifdef ENABLE_MIDI_PORT
     Ep128Emu::Mutex midiBufferMutex;
@@ -295,6 +303,7 @@ namespace Ep128 {
     static void videoCaptureCallback(void *userData);
 #ifdef ENABLE_RESID
     static void sidCallback(void *userData);
+    void sidClockPendingCycles();
 #endif
     void stopDemoPlayback();
     void stopDemoRecording(bool writeFile_);
@@ -327,6 +336,11 @@ namespace Ep128 {
      * Load ROM segment 'n' from the specified file, skipping 'offs' bytes.
      */
     virtual void loadROMSegment(uint8_t n, const char *fileName, size_t offs);
+    /*!
+     * Set the contents of all RAM segments to the same initial state as
+     * resetMemoryConfiguration() does, without changing the memory layout.
+     */
+    virtual void clearRAM();
     /*!
      * Load epmemcfg format memory configuration file.
      */
@@ -343,9 +357,12 @@ namespace Ep128 {
     /*!
      * Configure SID 'n' (0 to 3, currently only 3 is supported),
      * 'model' can be 0 to disable the emulation, 1 for MOS 6581 or 2 for 8580.
+     * If 'highQuality' is false, the SID is clocked in blocks of several
+     * cycles, and its output is interpolated between the blocks.
      */
     virtual void setSIDConfiguration(int n, int model,
-                                     double volumeL, double volumeR);
+                                     double volumeL, double volumeR,
+                                     bool highQuality);
 #endif
     /*!
      * Set CPU clock frequency (in Hz); defaults to 4000000 Hz.
@@ -19,7 +19,7 @@
 
 #include "ep128emu.hpp"
 #include "ep128vm.hpp"
-#include "roms/roms.hpp"
+#include "builtinrom.hpp"
 #ifdef ENABLE_SDEXT
 #  include "sdext.hpp"
 #endif
@@ -73,10 +73,11 @@ namespace Ep128 {
     }
     // load file into memory
     std::vector<uint8_t>  buf;
-    std::map<std::string, const unsigned char*>::const_iterator  iter_builtin_rom;
-    iter_builtin_rom = Ep128Emu::builtin_rom.find(fileName);
-    if (iter_builtin_rom != Ep128Emu::builtin_rom.end()) {
-      buf.insert(buf.begin(), (*iter_builtin_rom).second+offs, (*iter_builtin_rom).second + offs + 0x4000);
+    if (Ep128Emu::isBuiltinROM(fileName)) {
+      const std::vector<uint8_t>& romData = Ep128Emu::getBuiltinROM(fileName);
+      if (romData.size() < offs + 0x4000)
+        throw Ep128Emu::Exception("ROM file is shorter than expected");
+      buf.insert(buf.begin(), romData.begin() + offs, romData.begin() + offs + 0x4000);
     } else {
       buf.resize(0x4000, 0xFF);
       std::FILE   *f = Ep128Emu::fileOpen(fileName, "rb");
@@ -110,6 +111,15 @@ namespace Ep128 {
     }
   }
 
+  void Ep128VM::clearRAM()
+  {
+    stopDemo();
+    for (int i = 0; i < 256; i++) {
+      if (memory.isSegmentRAM(uint8_t(i)))
+        memory.loadSegment(uint8_t(i), false, (uint8_t *) 0, 0);
+    }
+  }
+
   // --------------------------------------------------------------------------
 
   void Ep128VM::loadMemoryConfiguration(const std::string& fileName_)
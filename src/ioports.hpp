@@ -83,11 +83,13 @@ namespace Ep128 {
     ReadCallback& cb = readCallbacks[offs];
 
     value = cb.func(cb.userData_, cb.addr_);
+#ifndef EP128EMU_NO_BREAKPOINTS
     if (breakPointTable) {
       if (breakPointTable[offs] >= breakPointPriorityThreshold &&
           (breakPointTable[offs] & 1) != 0)
         breakPointCallback(false, addr, value);
     }
+#endif
     return value;
   }
 
@@ -96,11 +98,13 @@ namespace Ep128 {
     uint8_t         offs = uint8_t(addr & 0xFF);
     WriteCallback&  cb = writeCallbacks[offs];
 
+#ifndef EP128EMU_NO_BREAKPOINTS
     if (breakPointTable) {
       if (breakPointTable[offs] >= breakPointPriorityThreshold &&
           (breakPointTable[offs] & 2) != 0)
         breakPointCallback(true, addr, value);
     }
+#endif
     portValues[offs] = value;
     cb.func(cb.userData_, cb.addr_, value);
   }
@@ -105,8 +105,10 @@ namespace Ep128 {
     if (EP128EMU_UNLIKELY(sdext->isSDExtSegment(pageTable[page])))
       value = sdext->readCartP3(addr);
 #endif
+#ifndef EP128EMU_NO_BREAKPOINTS
     if (haveBreakPoints)
       checkReadBreakPoint(addr, page, value);
+#endif
     return value;
   }
 
@@ -118,8 +120,10 @@ namespace Ep128 {
     if (EP128EMU_UNLIKELY(sdext->isSDExtSegment(pageTable[page])))
       value = sdext->readCartP3(addr);
 #endif
+#ifndef EP128EMU_NO_BREAKPOINTS
     if (haveBreakPoints)
       checkExecuteBreakPoint(addr, page, value);
+#endif
     return value;
   }
 
@@ -151,8 +155,10 @@ namespace Ep128 {
   inline void Memory::write(uint16_t addr, uint8_t value)
   {
     uint8_t page = uint8_t(addr >> 14);
+#ifndef EP128EMU_NO_BREAKPOINTS
     if (haveBreakPoints)
       checkWriteBreakPoint(addr, page, value);
+#endif
 #ifdef ENABLE_SDEXT
     if (EP128EMU_UNLIKELY(sdext->isSDExtSegment(pageTable[page]))) {
       sdext->writeCartP3(addr, value);
@@ -20,6 +20,7 @@
 #include "ep128emu.hpp"
 #include "memory.hpp"
 #include "nick.hpp"
+#include "perfcnt.hpp"
 #include "system.hpp"
 
 namespace Ep128 {
@@ -857,6 +858,7 @@ namespace Ep128 {
 
   EP128EMU_REGPARM1 void Nick::runOneSlot()
   {
+    EP128EMU_PERF_SCOPE(PERF_NICK_SLOT, 8);
     if (EP128EMU_UNLIKELY(currentSlot == lpb.rightMargin)) {
       displayEnabled = false;
       setRenderer();
@@ -0,0 +1,100 @@
+// ep128emu -- portable Enterprise 128 emulator
+// Copyright (C) 2003-2016 Istvan Varga <istvanv@users.sourceforge.net>
+// https://github.com/istvan-v/ep128emu/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include "ep128emu.hpp"
+#include "perfcnt.hpp"
+
+namespace Ep128Emu {
+
+  PerfCounter perfCounters[PERF_COUNTER_CNT];
+
+  static const char *perfCounterNames[PERF_COUNTER_CNT] = {
+    "Z80",
+    "NICK",
+    "DAVE",
+    "audio conversion",
+    "display draw",
+    "display decodeLine",
+    "VM thread wait",
+    "serialize",
+    "config: vm",
+    "config: memory",
+    "config: display",
+    "config: sound",
+    "config: media"
+  };
+
+#ifdef EP128EMU_PERF_COUNTERS
+  // Returns the average time measured for an empty interval, which is
+  // subtracted from each sampled call. It is significant compared to the
+  // duration of the per-cycle functions.
+  static double getPerfTimerOverhead()
+  {
+    static double overhead = -1.0;
+    if (overhead < 0.0) {
+      uint64_t  t = 0UL;
+      for (int i = 0; i < 1000; i++) {
+        uint64_t  t0 = perfTimerGet();
+        t += (perfTimerGet() - t0);
+      }
+      overhead = double(int64_t(t)) * 1.0e-12;
+    }
+    return overhead;
+  }
+#endif
+
+  bool havePerfCounters()
+  {
+#ifdef EP128EMU_PERF_COUNTERS
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void getPerfCounterStats(PerfCounterStats *buf)
+  {
+    for (int i = 0; i < int(PERF_COUNTER_CNT); i++) {
+      const PerfCounter&  c = perfCounters[i];
+      buf[i].name = perfCounterNames[i];
+      buf[i].calls = c.calls;
+      buf[i].totalTime = 0.0;
+#ifdef EP128EMU_PERF_COUNTERS
+      if (c.sampledCalls > 0UL) {
+        double  t = double(int64_t(c.sampledTime)) * 1.0e-9
+                    - (double(int64_t(c.sampledCalls))
+                       * getPerfTimerOverhead());
+        t = (t > 0.0 ? t : 0.0);
+        buf[i].totalTime = t * (double(int64_t(c.calls))
+                                / double(int64_t(c.sampledCalls)));
+      }
+#endif
+    }
+  }
+
+  void resetPerfCounters()
+  {
+    for (int i = 0; i < int(PERF_COUNTER_CNT); i++) {
+      perfCounters[i].calls = 0UL;
+      perfCounters[i].sampledCalls = 0UL;
+      perfCounters[i].sampledTime = 0UL;
+    }
+  }
+
+}       // namespace Ep128Emu
+
@@ -0,0 +1,145 @@
+// ep128emu -- portable Enterprise 128 emulator
+// Copyright (C) 2003-2016 Istvan Varga <istvanv@users.sourceforge.net>
+// https://github.com/istvan-v/ep128emu/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#ifndef EP128EMU_PERFCNT_HPP
+#define EP128EMU_PERFCNT_HPP
+
+#include "ep128emu.hpp"
+
+#ifdef EP128EMU_PERF_COUNTERS
+#  include <chrono>
+#endif
+
+namespace Ep128Emu {
+
+  // Hot path instrumentation, only compiled in if EP128EMU_PERF_COUNTERS is
+  // defined ('make PERF_COUNTERS=1'). Every call of an instrumented function
+  // is counted, but only one in (sampleMask + 1) calls is timed, and the
+  // total time is extrapolated from the sampled calls; this keeps the
+  // overhead of the per-cycle functions low. The counters are global to
+  // the process and not synchronized, so the results are only approximate
+  // if several emulator instances run at the same time. Times are inclusive
+  // (e.g. the Z80 time includes the memory and I/O callbacks).
+
+  enum PerfCounterID {
+    PERF_Z80_INSTRUCTION = 0,   // Z80::executeInstruction()
+    PERF_NICK_SLOT,             // Nick::runOneSlot()
+    PERF_DAVE_CYCLE,            // Dave::runOneCycle_()
+    PERF_AUDIO_CONVERT,         // AudioConverter*::sendInputSignal()
+    PERF_DISPLAY_DRAW,          // LibretroDisplay::draw()
+    PERF_DISPLAY_DECODE,        // LibretroDisplay::decodeLine()
+    PERF_VMTHREAD_WAIT,         // VM thread waiting or idle
+    PERF_SERIALIZE,             // retro_serialize()
+    PERF_CONFIG_VM,             // EmulatorConfiguration::applySettings()
+    PERF_CONFIG_MEMORY,         //   groups, each call applies one group
+    PERF_CONFIG_DISPLAY,
+    PERF_CONFIG_SOUND,
+    PERF_CONFIG_MEDIA,          //   disk, SD card and tape image files
+    PERF_COUNTER_CNT
+  };
+
+  struct PerfCounter {
+    uint64_t  calls;
+    uint64_t  sampledCalls;
+    uint64_t  sampledTime;      // in nanoseconds
+  };
+
+  struct PerfCounterStats {
+    const char  *name;
+    uint64_t    calls;
+    double      totalTime;      // estimated total time in seconds
+  };
+
+  extern PerfCounter  perfCounters[PERF_COUNTER_CNT];
+
+  /*!
+   * Returns true if the instrumentation is compiled in.
+   */
+  bool havePerfCounters();
+
+  /*!
+   * Stores the current state of all counters in 'buf', which should have
+   * space for PERF_COUNTER_CNT entries. The counts and times are
+   * accumulated since the last call of resetPerfCounters().
+   */
+  void getPerfCounterStats(PerfCounterStats *buf);
+
+  /*!
+   * Clears all counters.
+   */
+  void resetPerfCounters();
+
+#ifdef EP128EMU_PERF_COUNTERS
+
+  static EP128EMU_INLINE uint64_t perfTimerGet()
+  {
+    return uint64_t(std::chrono::duration_cast< std::chrono::nanoseconds >(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                    .count());
+  }
+
+  // Counts a call of 'id', and returns the start time if the call is to be
+  // timed, or zero otherwise. The result should be passed to perfEnd().
+  static EP128EMU_INLINE uint64_t perfBegin(PerfCounterID id,
+                                            uint32_t sampleMask)
+  {
+    PerfCounter&  c = perfCounters[id];
+    if ((uint32_t(c.calls++) & sampleMask) != 0U)
+      return 0UL;
+    return perfTimerGet();
+  }
+
+  static EP128EMU_INLINE void perfEnd(PerfCounterID id, uint64_t t0)
+  {
+    if (t0) {
+      PerfCounter&  c = perfCounters[id];
+      c.sampledCalls++;
+      c.sampledTime += (perfTimerGet() - t0);
+    }
+  }
+
+  class PerfScope {
+   private:
+    PerfCounterID id;
+    uint64_t      t0;
+   public:
+    EP128EMU_INLINE PerfScope(PerfCounterID id_, uint32_t sampleMask)
+      : id(id_),
+        t0(perfBegin(id_, sampleMask))
+    {
+    }
+    EP128EMU_INLINE ~PerfScope()
+    {
+      perfEnd(id, t0);
+    }
+  };
+
+  // time the rest of the enclosing block, sampling one in 2^N calls
+#  define EP128EMU_PERF_SCOPE(id, sampleShift)                            \
+  Ep128Emu::PerfScope perfScope_(Ep128Emu::id, (1U << (sampleShift)) - 1U)
+
+#else
+
+#  define EP128EMU_PERF_SCOPE(id, sampleShift)
+
+#endif  // EP128EMU_PERF_COUNTERS
+
+}       // namespace Ep128Emu
+
+#endif  // EP128EMU_PERFCNT_HPP
+
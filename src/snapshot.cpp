@@ -46,8 +46,12 @@ namespace Ep128 {
     sdext.saveState(f);
 #endif
 #ifdef ENABLE_RESID
-    if (sidModel)
+    if (sidModel) {
+      // in fast mode, run the SID up to the current time first
+      if (sidEnabled && !sidHighQuality)
+        sidClockPendingCycles();
       sid->saveState(f);
+    }
 #endif
     {
       Ep128Emu::File::Buffer  buf;
@@ -316,6 +320,15 @@ namespace Ep128 {
         (void) buf.readByte();
 #endif
       }
+#ifdef ENABLE_RESID
+      // the fast mode does not interpolate from the output before loading
+      // the snapshot
+      sidCyclesPending = 0;
+      sidOutput = 0;
+      sidOutputTarget = 0;
+      sidOutputStep = 0;
+      sidOutputStepsLeft = 0;
+#endif
       if (buf.getPosition() != buf.getDataSize()) {
         throw Ep128Emu::Exception("trailing garbage at end of "
                                   "ep128 snapshot data");
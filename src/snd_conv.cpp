@@ -19,6 +19,7 @@
 
 #include "ep128emu.hpp"
 #include "snd_conv.hpp"
+#include "perfcnt.hpp"
 #include <cmath>
 
 namespace Ep128Emu {
@@ -226,6 +227,7 @@ namespace Ep128Emu {
 
   void AudioConverterLowQuality::sendInputSignal(uint32_t audioInput)
   {
+    EP128EMU_PERF_SCOPE(PERF_AUDIO_CONVERT, 8);
     float   left = float(int(audioInput & 0xFFFF));
     float   right = float(int(audioInput >> 16));
     phs += 1.0f;
@@ -373,6 +375,7 @@ namespace Ep128Emu {
 
   void AudioConverterHighQuality::sendInputSignal(uint32_t audioInput)
   {
+    EP128EMU_PERF_SCOPE(PERF_AUDIO_CONVERT, 8);
     float   left = float(int(audioInput & 0xFFFF));
     float   right = float(int(audioInput >> 16));
     window.processSample(left, right, bufL, bufR, bufSize, bufPos);
@@ -527,6 +527,19 @@ namespace Ep128Emu {
 #endif
   }
 
+  int getProcessorCount()
+  {
+    int     n = 1;
+#if defined(WIN32)
+    SYSTEM_INFO sysInfo;
+    GetSystemInfo(&sysInfo);
+    n = int(sysInfo.dwNumberOfProcessors);
+#elif defined(_SC_NPROCESSORS_ONLN) && !defined(SF2000)
+    n = int(sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+    return (n > 1 ? n : 1);
+  }
+
   bool does_file_exist(const char *fileName)
   {
     std::ifstream infile(fileName);
@@ -204,6 +204,12 @@ namespace Ep128Emu {
    */
   void setProcessPriority(int n);
 
+  /*!
+   * Returns the number of processors available to the process, or 1 if
+   * this cannot be determined.
+   */
+  int getProcessorCount();
+
   bool does_file_exist(const char *fileName);
 
   /*!
@@ -262,9 +262,7 @@ namespace Ep128Emu {
 
   class Tape_WAV : public Tape {
    private:
-    std::FILE *f;               // wave file
-    uint8_t   *buf;             // 4096 bytes
-    uint32_t  *fileHeader;      // 44 byte long header:
+    uint8_t   *fileData;        // the whole file, with a 44 byte long header:
 /*
 0         4   ChunkID          Contains the letters "RIFF" in ASCII form
 4         4   ChunkSize        ignored here
@@ -281,10 +279,15 @@ namespace Ep128Emu {
 40        4   Subchunk2Size    ignored here
 44        *   Data             The actual sound data.
 */
-    bool      usingNewFormat;
+    size_t    fileSize;
+    bool      isFileMapped;     // true if 'fileData' is mapped with mmap()
+    int       sampleIndexShift; // log2(samples per byte)
+    size_t    sampleIndexMask;  // samples per byte - 1
+    int       sampleMask;       // (1 << fileBitsPerSample) - 1
+    int       sampleLShift;     // conversion to the requested bits per sample
+    int       sampleRShift;
     // ----------------
-    bool readBuffer_();
-    void unpackSamples_();
+    EP128EMU_INLINE int readSample_(size_t pos) const;
    public:
     /*!
      * Open tape file 'fileName'.
@@ -310,7 +313,8 @@ namespace Ep128Emu {
      */
     virtual void seek(double t);
     /*!
-     * Not supported for this format.
+     * Seek forward (if isForward = true) or backward (if isForward = false)
+     * by 't' seconds, cue points are not supported for this format.
      */
     virtual void seekToCuePoint(bool isForward = true, double t = 10.0);
     /*!
@@ -29,7 +29,7 @@
 #include "tvc64vm.hpp"
 #include "debuglib.hpp"
 #include "videorec.hpp"
-#include "roms/roms.hpp"
+#include "builtinrom.hpp"
 #ifdef ENABLE_SDEXT
 #  include "sdext.hpp"
 #endif
@@ -231,13 +231,15 @@ namespace TVC64 {
   {
     uint16_t  addr = uint16_t(R.PC.W.l);
     vm.memoryWaitM1(addr);
-    if (!vm.singleStepMode) {
-      uint8_t   retval = vm.memory.readOpcode(addr);
+#ifndef EP128EMU_NO_BREAKPOINTS
+    if (vm.singleStepMode) {
+      // single step mode
+      uint8_t   retval = vm.checkSingleStepModeBreak();
       vm.updateCPUHalfCycles(4);
       return retval;
     }
-    // single step mode
-    uint8_t   retval = vm.checkSingleStepModeBreak();
+#endif
+    uint8_t   retval = vm.memory.readOpcode(addr);
     vm.updateCPUHalfCycles(4);
     return retval;
   }
@@ -1417,6 +1419,7 @@ namespace TVC64 {
     z80.triggerInterrupt();
     while (EP128EMU_EXPECT(crtcCyclesRemainingH > 0)) {
       z80.executeInstruction();
+      z80ProfilerUpdate();
       if ((z80HalfCycleCnt - machineHalfCycleCnt) & 0xFE)
         runDevices();
     }
@@ -1486,15 +1489,16 @@ namespace TVC64 {
     // load file into memory
     std::vector<uint8_t>  buf;
     long dataSize;
-    std::map<std::string, const unsigned char*>::const_iterator  iter_builtin_rom;
-    iter_builtin_rom = Ep128Emu::builtin_rom.find(fileName);
-    if (iter_builtin_rom != Ep128Emu::builtin_rom.end()) {
-      dataSize = Ep128Emu::builtin_rom_length.at(fileName) - offs;
+    if (Ep128Emu::isBuiltinROM(fileName)) {
+      const std::vector<uint8_t>& romData = Ep128Emu::getBuiltinROM(fileName);
+      dataSize = long(romData.size()) - long(offs);
+      if (dataSize < 0x0400L)
+        throw Ep128Emu::Exception("ROM file is shorter than expected");
       if (n == 0x02 || n == 0x04)
         dataSize = (dataSize < 0x2000L ? dataSize : 0x2000L);
       else
         dataSize = (dataSize < 0x4000L ? dataSize : 0x4000L);
-      buf.insert(buf.begin(), (*iter_builtin_rom).second+offs, (*iter_builtin_rom).second + offs + dataSize);
+      buf.insert(buf.begin(), romData.begin() + offs, romData.begin() + offs + dataSize);
     } else {
       buf.resize(0x4000, 0xFF);
       std::FILE *f = Ep128Emu::fileOpen(fileName, "rb");
@@ -28,8 +28,11 @@ namespace TVC64 {
       throw Ep128Emu::Exception("video memory cannot be ROM");
     if (n > 0x04 && n < 0xF8)
       throw Ep128Emu::Exception("invalid segment number");
-    if (segmentTable[n] == (uint8_t *) 0)
+    if (segmentTable[n] == (uint8_t *) 0) {
       segmentTable[n] = new uint8_t[16384];
+      // snapshots do not include the first 8K of segments 2 and 4
+      std::memset(segmentTable[n], 0xFF, 16384);
+    }
     segmentROMTable[n] = isROM;
     setPaging(currentPaging);
   }
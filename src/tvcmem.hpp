@@ -131,8 +131,10 @@ namespace TVC64 {
       value = extensionRead(addr);
     else
       value = pageAddressTableR[page][addr];
+#ifndef EP128EMU_NO_BREAKPOINTS
     if (haveBreakPoints)
       checkReadBreakPoint(addr, page, value);
+#endif
     return value;
   }
 
@@ -144,8 +146,10 @@ namespace TVC64 {
       value = extensionRead(addr);
     else
       value = pageAddressTableR[page][addr];
+#ifndef EP128EMU_NO_BREAKPOINTS
     if (haveBreakPoints)
       checkExecuteBreakPoint(addr, page, value);
+#endif
     return value;
   }
 
@@ -176,8 +180,10 @@ namespace TVC64 {
       extensionWrite(addr, value);
       return;
     }
+#ifndef EP128EMU_NO_BREAKPOINTS
     if (haveBreakPoints)
       checkWriteBreakPoint(addr, page, value);
+#endif
     pageAddressTableW[page][addr] = value;
   }
 
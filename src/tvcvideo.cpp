@@ -53,6 +53,8 @@ namespace TVC64 {
                      const uint8_t *videoMemory_)
     : crtc(crtc_),
       lineBufPtr((uint8_t *) 0),
+      lineDataCnt(0),
+      lineDataDone(0),
       hSyncCnt(-1),
       crtcHSyncCnt(0),
       crtcHSyncState(0),
@@ -94,10 +96,13 @@ namespace TVC64 {
 
   void TVCVideo::setColor(uint8_t penNum, uint8_t c)
   {
-    if (penNum & 0x04)
-      borderColor = c & 0xAA;
-    else
-      palette[penNum & 0x03] = c & 0x55;
+    uint8_t&  color = ((penNum & 0x04) ? borderColor : palette[penNum & 0x03]);
+    c = c & ((penNum & 0x04) ? 0xAA : 0x55);
+    if (c != color) {
+      if (lineDataCnt > lineDataDone)
+        renderLineData();
+      color = c;
+    }
   }
 
   uint8_t TVCVideo::getColor(uint8_t penNum) const
@@ -107,34 +112,16 @@ namespace TVC64 {
     return palette[penNum & 0x03];
   }
 
-  EP128EMU_REGPARM1 void TVCVideo::runOneCycle()
+  EP128EMU_REGPARM1 void TVCVideo::renderLineData()
   {
-    hSyncCnt++;
-    if (EP128EMU_UNLIKELY(crtcHSyncCnt)) {      // horizontal sync
-      if (crtcHSyncCnt == hSyncPos) {
-        if (hSyncCnt >= 96) {
-          drawLine(lineBuf, size_t(lineBufPtr - lineBuf));
-          lineBufPtr = lineBuf;
-          hSyncCnt = -2;
-        }
-      }
-      else if (crtcHSyncCnt == 17) {
-        hSyncLen = 8;
-        hSyncPos = (hSyncLen >> 1) + 6;
-        if (vSyncCnt) {
-          if (--vSyncCnt == 19)         // VSync start (delayed by 5 lines)
-            vsyncStateChange(true, (crtc.getVSyncInterlace() ? 34U : 6U));
-          else if (vSyncCnt == 16)      // VSync end
-            vsyncStateChange(false, 6U);
-        }
-        crtcHSyncCnt = uint8_t(-1);     // will overflow to 0
-      }
-      crtcHSyncCnt++;
-    }
-    if (EP128EMU_EXPECT((unsigned int) hSyncCnt < 96U)) {
+    // encode the buffered video data using the current palette and border
+    // color; this is done once per line, or before any change to the colors
+    size_t  i = lineDataDone;
+    lineDataDone = lineDataCnt;
+    for ( ; i < lineDataCnt; i++) {
       const unsigned char *delayPtr =
-          reinterpret_cast< unsigned char * >(&(videoDelayBuf[0]));
-      if (!(hSyncCnt & 1U)) {
+          reinterpret_cast< const unsigned char * >(&(lineDataBuf[i]));
+      if (!(i & 1U)) {
         if (delayPtr[1] > delayPtr[0]) {
           uint8_t videoByte = delayPtr[3];
           switch (delayPtr[2]) {
@@ -280,9 +267,45 @@ namespace TVC64 {
         lineBufPtr = lineBufPtr + (lineBufPtr[0] + 1);
       }
     }
+  }
+
+  EP128EMU_REGPARM1 void TVCVideo::drawLine_()
+  {
+    renderLineData();
+    drawLine(lineBuf, size_t(lineBufPtr - lineBuf));
+    lineBufPtr = lineBuf;
+    lineDataCnt = 0;
+    lineDataDone = 0;
+  }
+
+  EP128EMU_REGPARM1 void TVCVideo::runOneCycle()
+  {
+    hSyncCnt++;
+    if (EP128EMU_UNLIKELY(crtcHSyncCnt)) {      // horizontal sync
+      if (crtcHSyncCnt == hSyncPos) {
+        if (hSyncCnt >= 96) {
+          drawLine_();
+          hSyncCnt = -2;
+        }
+      }
+      else if (crtcHSyncCnt == 17) {
+        hSyncLen = 8;
+        hSyncPos = (hSyncLen >> 1) + 6;
+        if (vSyncCnt) {
+          if (--vSyncCnt == 19)         // VSync start (delayed by 5 lines)
+            vsyncStateChange(true, (crtc.getVSyncInterlace() ? 34U : 6U));
+          else if (vSyncCnt == 16)      // VSync end
+            vsyncStateChange(false, 6U);
+        }
+        crtcHSyncCnt = uint8_t(-1);     // will overflow to 0
+      }
+      crtcHSyncCnt++;
+    }
+    if (EP128EMU_EXPECT((unsigned int) hSyncCnt < 96U)) {
+      lineDataBuf[lineDataCnt++] = videoDelayBuf[0];
+    }
     else if (EP128EMU_UNLIKELY(hSyncCnt >= 101)) {
-      drawLine(lineBuf, size_t(lineBufPtr - lineBuf));
-      lineBufPtr = lineBuf;
+      drawLine_();
       hSyncCnt = -2;
     }
     videoDelayBuf[0] = videoDelayBuf[1];
@@ -305,6 +328,8 @@ namespace TVC64 {
 
   void TVCVideo::reset()
   {
+    if (lineDataCnt > lineDataDone)
+      renderLineData();
     videoDelayBuf[0] = 0U;
     videoDelayBuf[1] = 0U;
     for (size_t i = 0; i < 4; i++)
@@ -29,6 +29,12 @@ namespace TVC64 {
    protected:
     const CPC464::CRTC6845& crtc;
     uint8_t   *lineBufPtr;
+    // video data (videoDelayBuf[0]) of the half characters displayed in the
+    // current line; the first lineDataDone have already been written to
+    // lineBuf
+    uint32_t  lineDataBuf[96];
+    size_t    lineDataCnt;
+    size_t    lineDataDone;
     int       hSyncCnt;
     uint8_t   crtcHSyncCnt;
     uint8_t   crtcHSyncState;
@@ -88,6 +94,10 @@ namespace TVC64 {
     void setColor(uint8_t penNum, uint8_t c);   // penNum >= 4 is border
     uint8_t getColor(uint8_t penNum) const;
     EP128EMU_REGPARM1 void runOneCycle();
+   private:
+    EP128EMU_REGPARM1 void renderLineData();
+    EP128EMU_REGPARM1 void drawLine_();
+   public:
     EP128EMU_INLINE void crtcHSyncStateChange(bool newState)
     {
       if (newState)
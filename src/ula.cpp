@@ -29,188 +29,111 @@ namespace ZX128 {
     45590, 55590, 45590, 55590, 45590, 55590, 45590, 55590
   };
 
-  void EP128EMU_REGPARM1 ULA::videoFunc_TBorder(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.lineBufPtr[0] = 0x01;
-    ula.lineBufPtr[1] = ula.borderColor;
-    ula.lineBufPtr = ula.lineBufPtr + 2;
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == 40)) {
-      ula.runOneSlot_ = &ULA::videoFunc_TBorderHBlank;
-      ula.drawLine(ula.lineBuf, size_t(ula.lineBufPtr - ula.lineBuf));
-    }
-    else if (EP128EMU_UNLIKELY(ula.currentSlot == ula.slotsPerLine)) {
-      ula.currentSlot = 0;
-    }
-  }
-
-  void EP128EMU_REGPARM1 ULA::videoFunc_TBorderHBlank(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == ula.hSyncEndSlot)) {
-      ula.currentLine++;
-      if (EP128EMU_UNLIKELY(ula.currentLine == ula.linesPerFrame)) {
-        ula.currentLine = 0;
-        ula.ld1Ptr = &(ula.videoRAMPtr[0x1800]);
-        ula.ld2Ptr = ula.videoRAMPtr;
-        ula.runOneSlot_ = &ULA::videoFunc_DisplayLBorder;
+  EP128EMU_REGPARM1 void ULA::runSlotEvent_()
+  {
+    if (currentSlot == slotsPerLine) {
+      currentSlot = 0;
+      nextEventSlot = 40;
+      return;
+    }
+    if (currentSlot == 40) {
+      // end of the visible part of the line
+      renderSlots_(48);
+      drawLine(lineBuf, (lineType == LINE_DISPLAY ? 160 : 96));
+      nextEventSlot = hSyncEndSlot;
+      return;
+    }
+    // end of horizontal sync: start new line
+    nextEventSlot = slotsPerLine;
+    renderPos = 0;
+    currentLine++;
+    if (currentLine < 192) {
+      if (EP128EMU_EXPECT((currentLine & 7) != 0)) {
+        ld2Ptr = ld2Ptr + 0x0100;
+      }
+      else if (EP128EMU_EXPECT((currentLine & 63) != 0)) {
+        ld1Ptr = ld1Ptr + 0x0020;
+        ld2Ptr = ld2Ptr - 0x06E0;
       }
       else {
-        ula.runOneSlot_ = &ULA::videoFunc_TBorder;
+        ld1Ptr = ld1Ptr + 0x0020;
+        ld2Ptr = ld2Ptr + 0x0020;
       }
-      ula.lineBufPtr = ula.lineBuf;
+      return;
     }
-  }
-
-  void EP128EMU_REGPARM1 ULA::videoFunc_DisplayLBorder(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.lineBufPtr[0] = 0x01;
-    ula.lineBufPtr[1] = ula.borderColor;
-    ula.lineBufPtr = ula.lineBufPtr + 2;
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == ula.slotsPerLine)) {
-      ula.currentSlot = 0;
-      ula.runOneSlot_ = &ULA::videoFunc_Display;
+    if (currentLine == 192) {
+      lineType = LINE_BORDER;
     }
-  }
-
-  void EP128EMU_REGPARM1 ULA::videoFunc_Display(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    uint8_t a = ula.ld1Ptr[ula.currentSlot];
-    uint8_t b = ula.ld2Ptr[ula.currentSlot];
-    uint8_t c0 = (a & 0x78) >> 3;
-    uint8_t c1 = (a & 0x07) | ((a & 0x40) >> 3);
-    if (EP128EMU_UNLIKELY((a & ula.flashCnt) & 0x80)) {
-      uint8_t tmp = c0;
-      c0 = c1;
-      c1 = tmp;
-    }
-    ula.lineBufPtr[0] = 0x03;
-    ula.lineBufPtr[1] = c0;
-    ula.lineBufPtr[2] = c1;
-    ula.lineBufPtr[3] = b;
-    ula.lineBufPtr = ula.lineBufPtr + 4;
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == 32))
-      ula.runOneSlot_ = &ULA::videoFunc_DisplayRBorder;
-  }
-
-  void EP128EMU_REGPARM1 ULA::videoFunc_DisplayRBorder(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.lineBufPtr[0] = 0x01;
-    ula.lineBufPtr[1] = ula.borderColor;
-    ula.lineBufPtr = ula.lineBufPtr + 2;
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == 40)) {
-      ula.runOneSlot_ = &ULA::videoFunc_DisplayHBlank;
-      ula.drawLine(ula.lineBuf, size_t(ula.lineBufPtr - ula.lineBuf));
+    else if (currentLine == 241) {
+      lineType = LINE_BLANK;
     }
-  }
-
-  void EP128EMU_REGPARM1 ULA::videoFunc_DisplayHBlank(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == ula.hSyncEndSlot)) {
-      ula.currentLine++;
-      if (EP128EMU_UNLIKELY(ula.currentLine == 192)) {
-        ula.runOneSlot_ = &ULA::videoFunc_BBorder;
+    else if (currentLine < 258) {
+      if (currentLine == 243 && !vsyncFlag) {
+        vsyncFlag = true;
+        vsyncStateChange(true, 7);
       }
-      else {
-        if (EP128EMU_EXPECT((ula.currentLine & 7) != 0)) {
-          ula.ld2Ptr = ula.ld2Ptr + 0x0100;
-        }
-        else if (EP128EMU_EXPECT((ula.currentLine & 63) != 0)) {
-          ula.ld1Ptr = ula.ld1Ptr + 0x0020;
-          ula.ld2Ptr = ula.ld2Ptr - 0x06E0;
-        }
-        else {
-          ula.ld1Ptr = ula.ld1Ptr + 0x0020;
-          ula.ld2Ptr = ula.ld2Ptr + 0x0020;
-        }
-        ula.runOneSlot_ = &ULA::videoFunc_DisplayLBorder;
+      else if (currentLine == 246 && vsyncFlag) {
+        vsyncFlag = false;
+        vsyncStateChange(false, 7);
+        flashCnt = (flashCnt + 8) & 0xF8;
+      }
+      else if (currentLine == 247) {
+        irqPollEnableCallback(true);
+      }
+      else if (currentLine == 249) {
+        irqPollEnableCallback(false);
       }
-      ula.lineBufPtr = ula.lineBuf;
-    }
-  }
-
-  void EP128EMU_REGPARM1 ULA::videoFunc_BBorder(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.lineBufPtr[0] = 0x01;
-    ula.lineBufPtr[1] = ula.borderColor;
-    ula.lineBufPtr = ula.lineBufPtr + 2;
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == 40)) {
-      ula.runOneSlot_ = &ULA::videoFunc_BBorderHBlank;
-      ula.drawLine(ula.lineBuf, size_t(ula.lineBufPtr - ula.lineBuf));
-    }
-    else if (EP128EMU_UNLIKELY(ula.currentSlot == ula.slotsPerLine)) {
-      ula.currentSlot = 0;
     }
-  }
-
-  void EP128EMU_REGPARM1 ULA::videoFunc_BBorderHBlank(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == ula.hSyncEndSlot)) {
-      ula.currentLine++;
-      if (EP128EMU_UNLIKELY(ula.currentLine == 241))
-        ula.runOneSlot_ = &ULA::videoFunc_VBlank;
-      else
-        ula.runOneSlot_ = &ULA::videoFunc_BBorder;
-      ula.lineBufPtr = ula.lineBuf;
+    else if (currentLine == 258) {
+      lineType = LINE_BORDER;
     }
-  }
-
-  void EP128EMU_REGPARM1 ULA::videoFunc_VBlank(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.lineBufPtr[0] = 0x01;
-    ula.lineBufPtr[1] = 0x00;
-    ula.lineBufPtr = ula.lineBufPtr + 2;
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == 40)) {
-      ula.runOneSlot_ = &ULA::videoFunc_VBlankHBlank;
-      ula.drawLine(ula.lineBuf, size_t(ula.lineBufPtr - ula.lineBuf));
-    }
-    else if (EP128EMU_UNLIKELY(ula.currentSlot == ula.slotsPerLine)) {
-      ula.currentSlot = 0;
+    else if (currentLine == linesPerFrame) {
+      currentLine = 0;
+      lineType = LINE_DISPLAY;
+      ld1Ptr = &(videoRAMPtr[0x1800]);
+      ld2Ptr = videoRAMPtr;
     }
   }
 
-  void EP128EMU_REGPARM1 ULA::videoFunc_VBlankHBlank(void *userData)
+  EP128EMU_REGPARM2 void ULA::renderSlots_(uint8_t endPos)
   {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == ula.hSyncEndSlot)) {
-      ula.currentLine++;
-      if (EP128EMU_UNLIKELY(ula.currentLine == 258))
-        ula.runOneSlot_ = &ULA::videoFunc_TBorder;
-      else
-        ula.runOneSlot_ = &ULA::videoFunc_VBlank;
-      if (ula.currentLine == 243 && !ula.vsyncFlag) {
-        ula.vsyncFlag = true;
-        ula.vsyncStateChange(true, 7);
-      }
-      else if (ula.currentLine == 246 && ula.vsyncFlag) {
-        ula.vsyncFlag = false;
-        ula.vsyncStateChange(false, 7);
-        ula.flashCnt = (ula.flashCnt + 8) & 0xF8;
+    int     i = renderPos;
+    int     n = endPos;
+    renderPos = endPos;
+    if (lineType != LINE_DISPLAY) {
+      uint8_t c = (lineType == LINE_BORDER ? borderColor : uint8_t(0x00));
+      for ( ; i < n; i++) {
+        lineBuf[i << 1] = 0x01;
+        lineBuf[(i << 1) + 1] = c;
       }
-      else if (ula.currentLine == 247) {
-        ula.irqPollEnableCallback(true);
+      return;
+    }
+    // left border
+    for ( ; i < n && i < 8; i++) {
+      lineBuf[i << 1] = 0x01;
+      lineBuf[(i << 1) + 1] = borderColor;
+    }
+    // display area
+    for ( ; i < n && i < 40; i++) {
+      uint8_t a = ld1Ptr[i - 8];
+      uint8_t b = ld2Ptr[i - 8];
+      uint8_t c0 = (a & 0x78) >> 3;
+      uint8_t c1 = (a & 0x07) | ((a & 0x40) >> 3);
+      if (EP128EMU_UNLIKELY((a & flashCnt) & 0x80)) {
+        uint8_t tmp = c0;
+        c0 = c1;
+        c1 = tmp;
       }
-      else if (ula.currentLine == 249) {
-        ula.irqPollEnableCallback(false);
-      }
-      ula.lineBufPtr = ula.lineBuf;
+      uint8_t *p = &(lineBuf[(i << 2) - 16]);
+      p[0] = 0x03;
+      p[1] = c0;
+      p[2] = c1;
+      p[3] = b;
+    }
+    // right border
+    for ( ; i < n; i++) {
+      lineBuf[(i << 1) + 64] = 0x01;
+      lineBuf[(i << 1) + 65] = borderColor;
     }
   }
 
@@ -223,7 +146,18 @@ namespace ZX128 {
       lineBuf[i] = 0x01;
       lineBuf[i + 1] = borderColor;
     }
-    lineBufPtr = lineBuf;
+  }
+
+  void ULA::initWaitTable()
+  {
+    for (int i = 0; i < (int(slotsPerLine) << 3); i++) {
+      int     x = ((i >> 3) + int(hSyncEndSlot)) % int(slotsPerLine);
+      x = (x << 3) | (i & 7);
+      if (x >= 256 || (x & 14) >= 12)
+        waitTable[i] = 0;
+      else
+        waitTable[i] = uint8_t(12 - (x & 14));
+    }
   }
 
   EP128EMU_REGPARM2 bool ULA::getInterruptFlag_(int timeOffs) const
@@ -236,14 +170,21 @@ namespace ZX128 {
 
   EP128EMU_REGPARM2 int ULA::getWaitHalfCycles_(int timeOffs) const
   {
-    int     x = 0;
-    int     y = 0;
-    getVideoPosition(x, y, timeOffs + 6);
-    if (EP128EMU_UNLIKELY(y < 0 || y >= 192))
-      return 0;         // this was already checked in getWaitHalfCycles()
-    if (x >= 256)
+    int     lineLength = int(slotsPerLine) << 3;
+    int     n = int(currentSlot) - int(hSyncEndSlot);
+    n = ((n >= 0 ? n : (n + int(slotsPerLine))) << 3) + timeOffs + 6;
+    int     y = currentLine;
+    if (n < 0) {
+      n = n + lineLength;
+      y = (y > 0 ? y : linesPerFrame) - 1;
+    }
+    else if (n >= lineLength) {
+      n = n - lineLength;
+      y = (y < (linesPerFrame - 1) ? (y + 1) : 0);
+    }
+    if (y >= 192)
       return 0;
-    return ((x & 14) < 12 ? (12 - (x & 14)) : 0);
+    return int(waitTable[n]);
   }
 
   EP128EMU_REGPARM2 uint8_t ULA::idleDataBusRead_(int timeOffs) const
@@ -267,42 +208,19 @@ namespace ZX128 {
   {
     irqPollEnableCallback(currentLine >= 247 && currentLine < 249);
     clearLineBuffer();
-    if (currentLine >= 258) {
-      if (currentSlot < 40 || currentSlot >= hSyncEndSlot)
-        runOneSlot_ = &videoFunc_TBorder;
-      else
-        runOneSlot_ = &videoFunc_TBorderHBlank;
-    }
-    else if (currentLine < 192) {
-      if (currentSlot >= hSyncEndSlot)
-        runOneSlot_ = &videoFunc_DisplayLBorder;
-      else if (currentSlot < 32)
-        runOneSlot_ = &videoFunc_Display;
-      else if (currentSlot < 40)
-        runOneSlot_ = &videoFunc_DisplayRBorder;
-      else
-        runOneSlot_ = &videoFunc_DisplayHBlank;
-    }
-    else if (currentLine < 241) {
-      if (currentSlot < 40 || currentSlot >= hSyncEndSlot)
-        runOneSlot_ = &videoFunc_BBorder;
-      else
-        runOneSlot_ = &videoFunc_BBorderHBlank;
-    }
-    else {
-      if (currentSlot < 40 || currentSlot >= hSyncEndSlot)
-        runOneSlot_ = &videoFunc_VBlank;
-      else
-        runOneSlot_ = &videoFunc_VBlankHBlank;
-    }
+    if (currentLine < 192)
+      lineType = LINE_DISPLAY;
+    else if (currentLine >= 241 && currentLine < 258)
+      lineType = LINE_BLANK;
+    else
+      lineType = LINE_BORDER;
     if (currentSlot >= hSyncEndSlot)
-      lineBufPtr = &(lineBuf[(currentSlot - hSyncEndSlot) << 1]);
-    else if (currentSlot < 32)
-      lineBufPtr = &(lineBuf[(currentSlot << 2) + 16]);
+      nextEventSlot = slotsPerLine;
     else if (currentSlot < 40)
-      lineBufPtr = &(lineBuf[(currentSlot << 1) + 80]);
+      nextEventSlot = 40;
     else
-      lineBufPtr = &(lineBuf[160]);
+      nextEventSlot = hSyncEndSlot;
+    renderPos = getRenderPos();
     ld1Ptr = videoRAMPtr + 0x1800;
     ld2Ptr = videoRAMPtr;
     if (currentLine < 192) {
@@ -321,8 +239,10 @@ namespace ZX128 {
   // --------------------------------------------------------------------------
 
   ULA::ULA(const uint8_t *videoRAMPtr_)
-    : runOneSlot_(&videoFunc_TBorder),
-      currentSlot(48),
+    : currentSlot(48),
+      nextEventSlot(56),
+      lineType(LINE_BORDER),
+      renderPos(0),
       hSyncEndSlot(48),
       slotsPerLine(56),
       ioPortValue(0x00),
@@ -335,7 +255,6 @@ namespace ZX128 {
       ld1Ptr(videoRAMPtr_ + 0x1800),
       ld2Ptr(videoRAMPtr_),
       lineBuf((uint8_t *) 0),
-      lineBufPtr((uint8_t *) 0),
       videoRAMPtr(videoRAMPtr_),
       audioOutput(0),
       tapeInput(0),
@@ -346,6 +265,7 @@ namespace ZX128 {
     uint32_t  *p = new uint32_t[48];    // for 192 bytes (48 * 4)
     lineBuf = reinterpret_cast<uint8_t *>(p);
     clearLineBuffer();
+    initWaitTable();
   }
 
   ULA::~ULA()
@@ -358,7 +278,6 @@ namespace ZX128 {
 
   void ULA::reset()
   {
-    runOneSlot_ = &videoFunc_TBorder;
     currentSlot = hSyncEndSlot;
     flashCnt = 0x00;
     currentLine = 258;
@@ -411,7 +330,10 @@ namespace ZX128 {
     if (tmp != 0)
       tapeOutput = uint8_t(tmp >= 0);
     ioPortValue = value;
-    borderColor = value & 0x07;
+    if ((value & 0x07) != borderColor) {
+      updateLineBuffer();
+      borderColor = value & 0x07;
+    }
     updateAudioOutput();
   }
 
@@ -430,6 +352,7 @@ namespace ZX128 {
 
   void ULA::setSpectrum128Mode(bool isSpectrum128)
   {
+    updateLineBuffer();
     if (currentSlot >= (hSyncEndSlot - 1)) {
       currentSlot = (currentSlot - uint8_t(spectrum128Mode))
                     + uint8_t(isSpectrum128);
@@ -442,6 +365,14 @@ namespace ZX128 {
     linesPerFrame = 312 - int(isSpectrum128);
     if (currentLine >= linesPerFrame)
       currentLine = linesPerFrame - 1;
+    if (currentSlot >= hSyncEndSlot)
+      nextEventSlot = slotsPerLine;
+    else if (currentSlot < 40)
+      nextEventSlot = 40;
+    else
+      nextEventSlot = hSyncEndSlot;
+    renderPos = getRenderPos();
+    initWaitTable();
   }
 
   void ULA::drawLine(const uint8_t *buf, size_t nBytes)
@@ -27,8 +27,10 @@ namespace ZX128 {
   class ULA {
    private:
     static const uint16_t audioOutputLevelTable[32];
-    EP128EMU_REGPARM1 void (*runOneSlot_)(void *userData);
     uint8_t   currentSlot;
+    uint8_t   nextEventSlot;            // slot at which runSlotEvent_() runs
+    uint8_t   lineType;                 // LINE_BORDER, LINE_DISPLAY, LINE_BLANK
+    uint8_t   renderPos;                // first visible slot not yet rendered
     uint8_t   hSyncEndSlot;             // 48K: 48, 128K: 49
     uint8_t   slotsPerLine;             // 48K: 56, 128K: 57
     uint8_t   ioPortValue;              // last value written to I/O port 0xFE
@@ -41,24 +43,39 @@ namespace ZX128 {
     const uint8_t *ld1Ptr;              // attribute data pointer
     const uint8_t *ld2Ptr;              // bitmap data pointer
     uint8_t   *lineBuf;                 // 48 slots = 384 pixels
-    uint8_t   *lineBufPtr;
     const uint8_t *videoRAMPtr;         // pointer to video RAM segment
     uint16_t  audioOutput;
     uint8_t   tapeInput;
     uint8_t   tapeOutput;
     uint8_t   keyboardState[8];
+    // wait states (in half cycles) for a memory access at each half cycle
+    // of a display line, starting from the end of horizontal sync
+    uint8_t   waitTable[57 * 8];
     // --------
-    static EP128EMU_REGPARM1 void videoFunc_TBorder(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_TBorderHBlank(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_DisplayLBorder(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_Display(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_DisplayRBorder(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_DisplayHBlank(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_BBorder(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_BBorderHBlank(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_VBlank(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_VBlankHBlank(void *userData);
+    static const uint8_t  LINE_BORDER = 0;
+    static const uint8_t  LINE_DISPLAY = 1;
+    static const uint8_t  LINE_BLANK = 2;
+    EP128EMU_REGPARM1 void runSlotEvent_();
+    EP128EMU_REGPARM2 void renderSlots_(uint8_t endPos);
     void clearLineBuffer();
+    void initWaitTable();
+    // returns the visible slot index (0 to 48) of the current slot,
+    // 0 being the first slot of the line buffer
+    EP128EMU_INLINE uint8_t getRenderPos() const
+    {
+      if (currentSlot >= hSyncEndSlot)
+        return (currentSlot - hSyncEndSlot);
+      return (currentSlot < 40 ? (currentSlot + 8) : 48);
+    }
+    // render the slots that have already been run, but not written to
+    // the line buffer yet; this is needed before any change that affects
+    // the display (border color or video memory write)
+    EP128EMU_INLINE void updateLineBuffer()
+    {
+      uint8_t endPos = getRenderPos();
+      if (endPos > renderPos)
+        renderSlots_(endPos);
+    }
     EP128EMU_REGPARM2 bool getInterruptFlag_(int timeOffs) const;
     EP128EMU_REGPARM2 int getWaitHalfCycles_(int timeOffs) const;
     EP128EMU_REGPARM2 uint8_t idleDataBusRead_(int timeOffs) const;
@@ -75,9 +92,19 @@ namespace ZX128 {
     {
       videoRAMPtr = videoRAMPtr_;
     }
-    inline void runOneSlot()
+    // the line buffer is only written at the end of the visible part of
+    // the line, or when updateLineBuffer() is called
+    EP128EMU_INLINE void runOneSlot()
+    {
+      currentSlot++;
+      if (EP128EMU_UNLIKELY(currentSlot == nextEventSlot))
+        runSlotEvent_();
+    }
+    // should be called before writing video memory at Z80 address 'addr'
+    EP128EMU_INLINE void videoMemoryWrite(uint16_t addr)
     {
-      runOneSlot_((void *) this);
+      if (uint16_t((addr & 0x7FFF) - 0x4000) < 0x1B00)
+        updateLineBuffer();
     }
     inline uint16_t getSoundOutput() const
     {
@@ -66,6 +66,29 @@ namespace Ep128Emu {
 
   // --------------------------------------------------------------------------
 
+  VideoCapture::FrameData::FrameData()
+    : outputFrames(0),
+      audioBufSamples(0),
+      timeElapsed(0L)
+  {
+  }
+
+  VideoCapture::EncoderThread::EncoderThread(VideoCapture& videoCapture_)
+    : videoCapture(videoCapture_)
+  {
+  }
+
+  VideoCapture::EncoderThread::~EncoderThread()
+  {
+  }
+
+  void VideoCapture::EncoderThread::run()
+  {
+    videoCapture.encoderThreadLoop();
+  }
+
+  // --------------------------------------------------------------------------
+
   void VideoCapture::aviHeader_writeFourCC(uint8_t*& bufp, const char *s)
   {
     bufp[0] = uint8_t(s[0]);
@@ -127,7 +150,14 @@ namespace Ep128Emu {
       errorCallback(&defaultErrorCallback),
       errorCallbackUserData((void *) this),
       fileNameCallback(&defaultFileNameCallback),
-      fileNameCallbackUserData((void *) this)
+      fileNameCallbackUserData((void *) this),
+      frameQueue((FrameData *) 0),
+      frameQueueReadPos(0),
+      frameQueueWritePos(0),
+      framesQueued(0),
+      fileSplitPending(false),
+      encoderQuitFlag(false),
+      encoderThread((EncoderThread *) 0)
   {
     try {
       frameRate = (frameRate > 24 ? (frameRate < 60 ? frameRate : 60) : 24);
@@ -139,18 +169,31 @@ namespace Ep128Emu {
         audioBuf[i] = int16_t(0);
       audioConverter =
           new AudioConverter_(*this, 222656.25f, float(sampleRate));
+      frameQueue = new FrameData[frameQueueSize];
+      encoderThread = new EncoderThread(*this);
+      encoderThread->start();
     }
     catch (...) {
       if (audioBuf)
         delete[] audioBuf;
       if (audioConverter)
         delete audioConverter;
+      if (frameQueue)
+        delete[] frameQueue;
       throw;
     }
   }
 
   VideoCapture::~VideoCapture()
   {
+    // the derived class has already closed the file, so the queue is empty
+    frameQueueMutex.lock();
+    encoderQuitFlag = true;
+    frameQueueMutex.unlock();
+    frameQueuedEvent.notify();
+    encoderThread->join();
+    delete encoderThread;
+    delete[] frameQueue;
     delete[] audioBuf;
     delete audioConverter;
   }
@@ -165,9 +208,176 @@ namespace Ep128Emu {
     }
   }
 
+  void VideoCapture::queueFrame()
+  {
+    // move the complete output frames from the audio buffer
+    int     blockSize = audioBufSize * 2;
+    int     nSamples = (audioBufSamples / blockSize) * blockSize;
+    nextFrame.outputFrames = audioBufSamples / blockSize;
+    nextFrame.audioData.resize(size_t(nSamples));
+    for (int i = 0; i < nSamples; i++) {
+      nextFrame.audioData[i] = audioBuf[audioBufReadPos];
+      if (++audioBufReadPos >= (blockSize * audioBuffers))
+        audioBufReadPos = 0;
+    }
+    audioBufSamples -= nSamples;
+    nextFrame.audioBufSamples = audioBufSamples;
+    // wait for space in the queue
+    while (true) {
+      frameQueueMutex.lock();
+      bool    splitFlag = fileSplitPending;
+      bool    queueFull = (framesQueued >= frameQueueSize);
+      frameQueueMutex.unlock();
+      if (splitFlag)
+        splitFile();
+      else if (!queueFull)
+        break;
+      else
+        frameDoneEvent.wait();
+    }
+    // the buffers of the slot are reused for the next frame
+    FrameData&  frame = frameQueue[frameQueueWritePos];
+    frame.videoData.swap(nextFrame.videoData);
+    frame.audioData.swap(nextFrame.audioData);
+    frame.outputFrames = nextFrame.outputFrames;
+    frame.audioBufSamples = nextFrame.audioBufSamples;
+    frame.timeElapsed = nextFrame.timeElapsed;
+    nextFrame.videoData.clear();
+    nextFrame.audioData.clear();
+    frameQueueMutex.lock();
+    if (++frameQueueWritePos >= frameQueueSize)
+      frameQueueWritePos = 0;
+    framesQueued++;
+    frameQueueMutex.unlock();
+    frameQueuedEvent.notify();
+    reportEncoderErrors();
+  }
+
+  void VideoCapture::flushFrameQueue()
+  {
+    while (true) {
+      frameQueueMutex.lock();
+      bool    splitFlag = fileSplitPending;
+      int     n = framesQueued;
+      frameQueueMutex.unlock();
+      if (splitFlag)
+        splitFile();
+      else if (n < 1)
+        break;
+      else
+        frameDoneEvent.wait();
+    }
+  }
+
+  void VideoCapture::encoderThreadLoop()
+  {
+    while (true) {
+      frameQueueMutex.lock();
+      bool    haveFrame = (framesQueued > 0 && !fileSplitPending);
+      bool    quitFlag = encoderQuitFlag;
+      frameQueueMutex.unlock();
+      if (!haveFrame) {
+        if (quitFlag)
+          break;
+        frameQueuedEvent.wait();
+        continue;
+      }
+      if (aviFile && fileSize >= 0x7F800000) {
+        // the new file name is requested on the emulation thread, the frame
+        // is written when the file is opened
+        frameQueueMutex.lock();
+        fileSplitPending = true;
+        frameQueueMutex.unlock();
+        frameDoneEvent.notify();
+        continue;
+      }
+      try {
+        encodeFrame(frameQueue[frameQueueReadPos]);
+      }
+      catch (std::exception& e) {
+        encoderError(e.what());
+      }
+      frameQueueMutex.lock();
+      if (++frameQueueReadPos >= frameQueueSize)
+        frameQueueReadPos = 0;
+      framesQueued--;
+      frameQueueMutex.unlock();
+      frameDoneEvent.notify();
+    }
+  }
+
+  void VideoCapture::appendLine(std::vector< uint8_t >& buf, int lineNum,
+                                const uint8_t *lineData, size_t nBytes)
+  {
+    size_t  pos = buf.size();
+    buf.resize(pos + nBytes + 4);
+    uint8_t *bufp = &(buf.front()) + pos;
+    bufp[0] = uint8_t(lineNum & 0xFF);
+    bufp[1] = uint8_t(lineNum >> 8);
+    bufp[2] = uint8_t(nBytes & 0xFF);
+    bufp[3] = uint8_t(nBytes >> 8);
+    if (nBytes > 0)
+      std::memcpy(bufp + 4, lineData, nBytes);
+  }
+
+  void VideoCapture::encoderError(const char *msg)
+  {
+    if (msg == (char *) 0 || msg[0] == '\0')
+      msg = "unknown video capture error";
+    frameQueueMutex.lock();
+    try {
+      encoderErrors.push_back(std::string(msg));
+    }
+    catch (...) {
+    }
+    frameQueueMutex.unlock();
+  }
+
+  void VideoCapture::reportEncoderErrors()
+  {
+    std::vector< std::string >  msgs;
+    frameQueueMutex.lock();
+    msgs.swap(encoderErrors);
+    frameQueueMutex.unlock();
+    for (size_t i = 0; i < msgs.size(); i++)
+      errorMessage(msgs[i].c_str());
+  }
+
+  void VideoCapture::splitFile()
+  {
+    // the encoder thread does not access the file until fileSplitPending
+    // is cleared
+    closeFile_();
+    try {
+      errorMessage("AVI file is too large, starting new output file");
+    }
+    catch (...) {
+    }
+    try {
+      std::string fileName = "";
+      fileNameCallback(fileNameCallbackUserData, fileName);
+      if (fileName.length() > 0)
+        openFile_(fileName.c_str());
+    }
+    catch (std::exception& e) {
+      closeFile_();
+      encoderError(e.what());
+    }
+    frameQueueMutex.lock();
+    fileSplitPending = false;
+    frameQueueMutex.unlock();
+    frameQueuedEvent.notify();
+  }
+
   void VideoCapture::openFile(const char *fileName)
   {
-    closeFile();
+    flushFrameQueue();
+    openFile_(fileName);
+  }
+
+  void VideoCapture::openFile_(const char *fileName)
+  {
+    closeFile_();
     if (fileName == (char *) 0 || fileName[0] == '\0')
       return;
     aviFile = fileOpen(fileName, "wb");
@@ -180,6 +390,12 @@ namespace Ep128Emu {
   }
 
   void VideoCapture::closeFile()
+  {
+    flushFrameQueue();
+    closeFile_();
+  }
+
+  void VideoCapture::closeFile_()
   {
     if (aviFile) {
       // FIXME: file I/O errors are ignored here
@@ -317,6 +533,7 @@ namespace Ep128Emu {
     : VideoCapture(frameRate_),
       tmpFrameBuf(videoWidth, videoHeight),
       outputFrameBuf(videoWidth, videoHeight),
+      encoderFrameBuf(videoWidth, videoHeight),
       frameSizes((uint32_t *) 0),
       cycleCnt(2),
       prvOddFrame(false),
@@ -422,21 +639,35 @@ namespace Ep128Emu {
   void VideoCapture_RLE8::frameDone()
   {
     if (audioBufSamples >= (audioBufSize * 2)) {
-      bool    frameChanged = false;
+      // only the changed lines are passed to the encoder thread
       for (int i = 0; i < videoHeight; i++) {
         if (!tmpFrameBuf.compareLine(i, outputFrameBuf, i)) {
-          frameChanged = true;
           outputFrameBuf.copyLine(i, tmpFrameBuf, i);
+          appendLine(nextFrame.videoData, i,
+                     outputFrameBuf[i], outputFrameBuf.lineBytes(i));
         }
       }
-      do {
-        audioBufSamples -= (audioBufSize * 2);
-        writeFrame(frameChanged);
-        frameChanged = false;
-        audioBufReadPos += (audioBufSize * 2);
-        while (audioBufReadPos >= (audioBufSize * audioBuffers * 2))
-          audioBufReadPos -= (audioBufSize * audioBuffers * 2);
-      } while (audioBufSamples >= (audioBufSize * 2));
+      queueFrame();
+    }
+  }
+
+  void VideoCapture_RLE8::encodeFrame(FrameData& frame)
+  {
+    size_t  pos = 0;
+    while (pos < frame.videoData.size()) {
+      const uint8_t *bufp = &(frame.videoData.front()) + pos;
+      long    lineNum = long(bufp[0]) | (long(bufp[1]) << 8);
+      size_t  nBytes = size_t(bufp[2]) | (size_t(bufp[3]) << 8);
+      if (nBytes > 0)
+        std::memcpy(encoderFrameBuf[lineNum], bufp + 4, nBytes);
+      encoderFrameBuf.lineBytes(lineNum) = uint32_t(nBytes);
+      pos = pos + nBytes + 4;
+    }
+    bool    frameChanged = (pos > 0);
+    for (int i = 0; i < frame.outputFrames; i++) {
+      writeFrame(frameChanged,
+                 &(frame.audioData.front()) + (i * audioBufSize * 2));
+      frameChanged = false;
     }
   }
 
@@ -610,7 +841,8 @@ namespace Ep128Emu {
     return nBytes;
   }
 
-  void VideoCapture_RLE8::writeFrame(bool frameChanged)
+  void VideoCapture_RLE8::writeFrame(bool frameChanged,
+                                     const int16_t *audioData)
   {
     if (!aviFile)
       return;
@@ -623,19 +855,6 @@ namespace Ep128Emu {
     if (frameChanged)
       duplicateFrames = 0;
     try {
-      if (fileSize >= 0x7F800000) {
-        closeFile();
-        try {
-          errorMessage("AVI file is too large, starting new output file");
-        }
-        catch (...) {
-        }
-        std::string fileName = "";
-        fileNameCallback(fileNameCallbackUserData, fileName);
-        if (fileName.length() < 1)
-          return;
-        openFile(fileName.c_str());
-      }
       if (std::fseek(aviFile, 0L, SEEK_END) < 0)
         throw Exception("error seeking AVI file");
       uint8_t headerBuf[8];
@@ -657,8 +876,8 @@ namespace Ep128Emu {
         size_t  n = 0;
         for (int i = (videoHeight - 1); i >= 0; i--) {
           if (i == (videoHeight - 1) ||
-              !outputFrameBuf.compareLine(i, outputFrameBuf, i + 1)) {
-            decodeLine(&(lineBuf[0]), outputFrameBuf[i]);
+              !encoderFrameBuf.compareLine(i, encoderFrameBuf, i + 1)) {
+            decodeLine(&(lineBuf[0]), encoderFrameBuf[i]);
             n = rleCompressLine(&(rleBuf[0]), &(lineBuf[0]));
           }
           nBytes += n;
@@ -683,11 +902,8 @@ namespace Ep128Emu {
       fileSize = fileSize + 8;
       if (std::fwrite(&(headerBuf[0]), 1, 8, aviFile) != 8)
         throw Exception("error writing AVI file");
-      int     bufPos = audioBufReadPos;
       for (int i = 0; i < (audioBufSize * 2); i++) {
-        if (bufPos >= (audioBufSize * audioBuffers * 2))
-          bufPos = 0;
-        int16_t tmp = audioBuf[bufPos++];
+        int16_t tmp = audioData[i];
         fileSize++;
         if (std::fputc(int(uint16_t(tmp) & 0xFF), aviFile) == EOF)
           throw Exception("error writing AVI file");
@@ -697,8 +913,8 @@ namespace Ep128Emu {
       }
     }
     catch (std::exception& e) {
-      closeFile();
-      errorMessage(e.what());
+      closeFile_();
+      encoderError(e.what());
       return;
     }
     framesWritten++;
@@ -707,7 +923,7 @@ namespace Ep128Emu {
         writeAVIHeader();
       }
       catch (std::exception& e) {
-        errorMessage(e.what());
+        encoderError(e.what());
       }
     }
   }
@@ -973,12 +1189,12 @@ namespace Ep128Emu {
       outBufU((uint8_t *) 0),
       duplicateFrameBitmap((uint8_t *) 0),
       timesliceLength(0L),
+      timeElapsed(0L),
       curTime(0L),
       frame0Time(-1L),
       frame1Time(0L),
       cycleCnt(2),
       interpTime(0),
-      lineBufBytes(0),
       colormap((uint32_t *) 0)
   {
     try {
@@ -1092,7 +1308,7 @@ namespace Ep128Emu {
       soundOutputAccumulatorR = 0U;
       audioConverter->sendInputSignal(tmpL | (tmpR << 16));
     }
-    curTime += timesliceLength;
+    timeElapsed += timesliceLength;
   }
 
   void VideoCapture_YV12::setClockFrequency(size_t freq_)
@@ -1106,14 +1322,8 @@ namespace Ep128Emu {
 
   void VideoCapture_YV12::horizontalSync(const uint8_t *buf, size_t nBytes)
   {
-    if (curLine >= 0 && curLine < (videoHeight * 2)) {
-      uint8_t *p = lineBuf;
-      for (size_t i = 0; i < nBytes; i++)
-        p[i] = buf[i];
-      lineBufBytes = nBytes;
-      decodeLine();
-    }
-    lineBufBytes = 0;
+    if (curLine >= 0 && curLine < (videoHeight * 2))
+      appendLine(nextFrame.videoData, curLine >> 1, buf, nBytes);
     if (vsyncCnt != 0) {
       curLine += 2;
       if (vsyncCnt >= (EP128EMU_VSYNC_MIN_LINES - EP128EMU_VSYNC_OFFSET) &&
@@ -1127,511 +1337,308 @@ namespace Ep128Emu {
       curLine = (oddFrame ? -1 : 0);
       vsyncCnt++;
       oddFrame = false;
-      frameDone();
+      nextFrame.timeElapsed = timeElapsed;
+      timeElapsed = 0L;
+      queueFrame();
     }
   }
 
-  void VideoCapture_YV12::decodeLine()
+  void VideoCapture_YV12::encodeFrame(FrameData& frame)
+  {
+    size_t  pos = 0;
+    while (pos < frame.videoData.size()) {
+      const uint8_t *bufp = &(frame.videoData.front()) + pos;
+      int     lineNum = int(bufp[0]) | (int(bufp[1]) << 8);
+      size_t  nBytes = size_t(bufp[2]) | (size_t(bufp[3]) << 8);
+      if (nBytes > 0)
+        std::memcpy(lineBuf, bufp + 4, nBytes);
+      decodeLine(lineNum);
+      pos = pos + nBytes + 4;
+    }
+    curTime += frame.timeElapsed;
+    frameDone(frame);
+  }
+
+  // The loops of the functions below are simple enough for the compiler to
+  // vectorize them with the default instruction set of x86-64 (SSE2) and
+  // AArch64 (NEON), so no intrinsics are needed.
+
+  // average the chroma of two lines (vertical part of the 2x2 subsampling)
+  static void averageChromaLine(uint8_t *buf, const uint8_t *lineData, int n)
+  {
+    for (int i = 0; i < n; i++)
+      buf[i] = uint8_t((uint32_t(buf[i]) + uint32_t(lineData[i]) + 1U) >> 1);
+  }
+
+  void VideoCapture_YV12::decodeLine(int lineNum)
   {
-    int       lineNum = curLine >> 1;
     int       offs = lineNum * videoWidth;
     uint8_t   *yPtr = &(frameBuf1Y[offs]);
     offs = (lineNum >> 1) * (videoWidth >> 1);
     uint8_t   *vPtr = &(frameBuf1V[offs]);
     uint8_t   *uPtr = &(frameBuf1U[offs]);
     const uint8_t   *bufp = lineBuf;
+    // the chroma of odd lines is decoded to a temporary buffer first, and
+    // then averaged with the previous line
+    uint8_t   chromaBuf[videoWidth];
+    if (lineNum & 1) {
+      vPtr = &(chromaBuf[0]);
+      uPtr = &(chromaBuf[videoWidth >> 1]);
+    }
 
-    if (!(lineNum & 1)) {
-      for (size_t i = 0; i < 48; i++) {
-        uint8_t c = *(bufp++);
-        switch (c) {
-        case 0x01:
-          {
-            uint32_t  tmp = colormap[*(bufp++)];
-            yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] =
-            yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
-            vPtr[3] = vPtr[2] = vPtr[1] = vPtr[0] =
-                uint8_t((tmp >> 20) & 0xFFU);
-            uPtr[3] = uPtr[2] = uPtr[1] = uPtr[0] =
-                uint8_t((tmp >> 10) & 0xFFU);
-          }
-          break;
-        case 0x02:
-          {
-            uint32_t  tmp = colormap[*(bufp++)];
-            yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
-            vPtr[1] = vPtr[0] = uint8_t((tmp >> 20) & 0xFFU);
-            uPtr[1] = uPtr[0] = uint8_t((tmp >> 10) & 0xFFU);
-            tmp = colormap[*(bufp++)];
-            yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] = uint8_t(tmp & 0xFFU);
-            vPtr[3] = vPtr[2] = uint8_t((tmp >> 20) & 0xFFU);
-            uPtr[3] = uPtr[2] = uint8_t((tmp >> 10) & 0xFFU);
-          }
-          break;
-        case 0x03:
-          {
-            unsigned char c0 = *(bufp++);
-            unsigned char c1 = *(bufp++);
-            unsigned char b = *(bufp++);
-            uint32_t  p0 = colormap[((b & 128) ? c1 : c0)];
-            uint32_t  p1 = colormap[((b &  64) ? c1 : c0)];
-            yPtr[0] = uint8_t(p0 & 0xFFU);
-            yPtr[1] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[0] = uint8_t((p0 >> 21) & 0xFFU);
-            uPtr[0] = uint8_t((p0 >> 11) & 0xFFU);
-            p0 = colormap[((b &  32) ? c1 : c0)];
-            p1 = colormap[((b &  16) ? c1 : c0)];
-            yPtr[2] = uint8_t(p0 & 0xFFU);
-            yPtr[3] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[1] = uint8_t((p0 >> 21) & 0xFFU);
-            uPtr[1] = uint8_t((p0 >> 11) & 0xFFU);
-            p0 = colormap[((b &   8) ? c1 : c0)];
-            p1 = colormap[((b &   4) ? c1 : c0)];
-            yPtr[4] = uint8_t(p0 & 0xFFU);
-            yPtr[5] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[2] = uint8_t((p0 >> 21) & 0xFFU);
-            uPtr[2] = uint8_t((p0 >> 11) & 0xFFU);
-            p0 = colormap[((b &   2) ? c1 : c0)];
-            p1 = colormap[((b &   1) ? c1 : c0)];
-            yPtr[6] = uint8_t(p0 & 0xFFU);
-            yPtr[7] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[3] = uint8_t((p0 >> 21) & 0xFFU);
-            uPtr[3] = uint8_t((p0 >> 11) & 0xFFU);
-          }
-          break;
-        case 0x04:
-          {
-            uint32_t  tmp = colormap[*(bufp++)];
-            yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
-            vPtr[0] = uint8_t((tmp >> 20) & 0xFFU);
-            uPtr[0] = uint8_t((tmp >> 10) & 0xFFU);
-            tmp = colormap[*(bufp++)];
-            yPtr[3] = yPtr[2] = uint8_t(tmp & 0xFFU);
-            vPtr[1] = uint8_t((tmp >> 20) & 0xFFU);
-            uPtr[1] = uint8_t((tmp >> 10) & 0xFFU);
-            tmp = colormap[*(bufp++)];
-            yPtr[5] = yPtr[4] = uint8_t(tmp & 0xFFU);
-            vPtr[2] = uint8_t((tmp >> 20) & 0xFFU);
-            uPtr[2] = uint8_t((tmp >> 10) & 0xFFU);
-            tmp = colormap[*(bufp++)];
-            yPtr[7] = yPtr[6] = uint8_t(tmp & 0xFFU);
-            vPtr[3] = uint8_t((tmp >> 20) & 0xFFU);
-            uPtr[3] = uint8_t((tmp >> 10) & 0xFFU);
-          }
-          break;
-        case 0x06:
-          {
-            unsigned char c0 = *(bufp++);
-            unsigned char c1 = *(bufp++);
-            unsigned char b = *(bufp++);
-            uint32_t  p0 = colormap[((b & 128) ? c1 : c0)];
-            uint32_t  p1 = colormap[((b &  64) ? c1 : c0)];
-            uint32_t  p2 = colormap[((b &  32) ? c1 : c0)];
-            uint32_t  p3 = colormap[((b &  16) ? c1 : c0)];
-            yPtr[0] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[1] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[0] = uint8_t((p0 >> 22) & 0xFFU);
-            uPtr[0] = uint8_t((p0 >> 12) & 0xFFU);
-            p0 = colormap[((b &   8) ? c1 : c0)];
-            p1 = colormap[((b &   4) ? c1 : c0)];
-            p2 = colormap[((b &   2) ? c1 : c0)];
-            p3 = colormap[((b &   1) ? c1 : c0)];
-            yPtr[2] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[3] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[1] = uint8_t((p0 >> 22) & 0xFFU);
-            uPtr[1] = uint8_t((p0 >> 12) & 0xFFU);
-            c0 = *(bufp++);
-            c1 = *(bufp++);
-            b = *(bufp++);
-            p0 = colormap[((b & 128) ? c1 : c0)];
-            p1 = colormap[((b &  64) ? c1 : c0)];
-            p2 = colormap[((b &  32) ? c1 : c0)];
-            p3 = colormap[((b &  16) ? c1 : c0)];
-            yPtr[4] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[5] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[2] = uint8_t((p0 >> 22) & 0xFFU);
-            uPtr[2] = uint8_t((p0 >> 12) & 0xFFU);
-            p0 = colormap[((b &   8) ? c1 : c0)];
-            p1 = colormap[((b &   4) ? c1 : c0)];
-            p2 = colormap[((b &   2) ? c1 : c0)];
-            p3 = colormap[((b &   1) ? c1 : c0)];
-            yPtr[6] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[7] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[3] = uint8_t((p0 >> 22) & 0xFFU);
-            uPtr[3] = uint8_t((p0 >> 12) & 0xFFU);
-          }
-          break;
-        case 0x08:
-          {
-            uint32_t  p0 = colormap[*(bufp++)];
-            uint32_t  p1 = colormap[*(bufp++)];
-            yPtr[0] = uint8_t(p0 & 0xFFU);
-            yPtr[1] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[0] = uint8_t((p0 >> 21) & 0xFFU);
-            uPtr[0] = uint8_t((p0 >> 11) & 0xFFU);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            yPtr[2] = uint8_t(p0 & 0xFFU);
-            yPtr[3] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[1] = uint8_t((p0 >> 21) & 0xFFU);
-            uPtr[1] = uint8_t((p0 >> 11) & 0xFFU);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            yPtr[4] = uint8_t(p0 & 0xFFU);
-            yPtr[5] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[2] = uint8_t((p0 >> 21) & 0xFFU);
-            uPtr[2] = uint8_t((p0 >> 11) & 0xFFU);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            yPtr[6] = uint8_t(p0 & 0xFFU);
-            yPtr[7] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[3] = uint8_t((p0 >> 21) & 0xFFU);
-            uPtr[3] = uint8_t((p0 >> 11) & 0xFFU);
-          }
-          break;
-        case 0x10:
-          {
-            uint32_t  p0 = colormap[*(bufp++)];
-            uint32_t  p1 = colormap[*(bufp++)];
-            uint32_t  p2 = colormap[*(bufp++)];
-            uint32_t  p3 = colormap[*(bufp++)];
-            yPtr[0] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[1] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[0] = uint8_t((p0 >> 22) & 0xFFU);
-            uPtr[0] = uint8_t((p0 >> 12) & 0xFFU);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            p2 = colormap[*(bufp++)];
-            p3 = colormap[*(bufp++)];
-            yPtr[2] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[3] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[1] = uint8_t((p0 >> 22) & 0xFFU);
-            uPtr[1] = uint8_t((p0 >> 12) & 0xFFU);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            p2 = colormap[*(bufp++)];
-            p3 = colormap[*(bufp++)];
-            yPtr[4] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[5] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[2] = uint8_t((p0 >> 22) & 0xFFU);
-            uPtr[2] = uint8_t((p0 >> 12) & 0xFFU);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            p2 = colormap[*(bufp++)];
-            p3 = colormap[*(bufp++)];
-            yPtr[6] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[7] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[3] = uint8_t((p0 >> 22) & 0xFFU);
-            uPtr[3] = uint8_t((p0 >> 12) & 0xFFU);
-          }
-          break;
-        default:
+    for (size_t i = 0; i < 48; i++) {
+      uint8_t c = *(bufp++);
+      switch (c) {
+      case 0x01:
+        {
+          uint32_t  tmp = colormap[*(bufp++)];
           yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] =
-          yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = 0x00;
-          vPtr[3] = vPtr[2] = vPtr[1] = vPtr[0] = 0x00;
-          uPtr[3] = uPtr[2] = uPtr[1] = uPtr[0] = 0x00;
-          break;
+          yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
+          vPtr[3] = vPtr[2] = vPtr[1] = vPtr[0] =
+              uint8_t((tmp >> 20) & 0xFFU);
+          uPtr[3] = uPtr[2] = uPtr[1] = uPtr[0] =
+              uint8_t((tmp >> 10) & 0xFFU);
         }
-        yPtr = yPtr + 8;
-        vPtr = vPtr + 4;
-        uPtr = uPtr + 4;
-      }
-    }
-    else {
-      for (size_t i = 0; i < 48; i++) {
-        uint8_t c = *(bufp++);
-        switch (c) {
-        case 0x01:
-          {
-            uint32_t  tmp = colormap[*(bufp++)];
-            yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] =
-            yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
-            uint32_t  v = (tmp >> 20) & 0xFFU;
-            uint32_t  u = (tmp >> 10) & 0xFFU;
-            vPtr[0] = uint8_t((uint32_t(vPtr[0]) + v + 1U) >> 1);
-            vPtr[1] = uint8_t((uint32_t(vPtr[1]) + v + 1U) >> 1);
-            vPtr[2] = uint8_t((uint32_t(vPtr[2]) + v + 1U) >> 1);
-            vPtr[3] = uint8_t((uint32_t(vPtr[3]) + v + 1U) >> 1);
-            uPtr[0] = uint8_t((uint32_t(uPtr[0]) + u + 1U) >> 1);
-            uPtr[1] = uint8_t((uint32_t(uPtr[1]) + u + 1U) >> 1);
-            uPtr[2] = uint8_t((uint32_t(uPtr[2]) + u + 1U) >> 1);
-            uPtr[3] = uint8_t((uint32_t(uPtr[3]) + u + 1U) >> 1);
-          }
-          break;
-        case 0x02:
-          {
-            uint32_t  tmp = colormap[*(bufp++)];
-            yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
-            uint32_t  v = (tmp >> 20) & 0xFFU;
-            uint32_t  u = (tmp >> 10) & 0xFFU;
-            vPtr[0] = uint8_t((uint32_t(vPtr[0]) + v + 1U) >> 1);
-            vPtr[1] = uint8_t((uint32_t(vPtr[1]) + v + 1U) >> 1);
-            uPtr[0] = uint8_t((uint32_t(uPtr[0]) + u + 1U) >> 1);
-            uPtr[1] = uint8_t((uint32_t(uPtr[1]) + u + 1U) >> 1);
-            tmp = colormap[*(bufp++)];
-            yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] = uint8_t(tmp & 0xFFU);
-            v = (tmp >> 20) & 0xFFU;
-            u = (tmp >> 10) & 0xFFU;
-            vPtr[2] = uint8_t((uint32_t(vPtr[2]) + v + 1U) >> 1);
-            vPtr[3] = uint8_t((uint32_t(vPtr[3]) + v + 1U) >> 1);
-            uPtr[2] = uint8_t((uint32_t(uPtr[2]) + u + 1U) >> 1);
-            uPtr[3] = uint8_t((uint32_t(uPtr[3]) + u + 1U) >> 1);
-          }
-          break;
-        case 0x03:
-          {
-            unsigned char c0 = *(bufp++);
-            unsigned char c1 = *(bufp++);
-            unsigned char b = *(bufp++);
-            uint32_t  p0 = colormap[((b & 128) ? c1 : c0)];
-            uint32_t  p1 = colormap[((b &  64) ? c1 : c0)];
-            yPtr[0] = uint8_t(p0 & 0xFFU);
-            yPtr[1] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[0] =
-                uint8_t((uint32_t(vPtr[0]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
-            uPtr[0] =
-                uint8_t((uint32_t(uPtr[0]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[((b &  32) ? c1 : c0)];
-            p1 = colormap[((b &  16) ? c1 : c0)];
-            yPtr[2] = uint8_t(p0 & 0xFFU);
-            yPtr[3] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[1] =
-                uint8_t((uint32_t(vPtr[1]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
-            uPtr[1] =
-                uint8_t((uint32_t(uPtr[1]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[((b &   8) ? c1 : c0)];
-            p1 = colormap[((b &   4) ? c1 : c0)];
-            yPtr[4] = uint8_t(p0 & 0xFFU);
-            yPtr[5] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[2] =
-                uint8_t((uint32_t(vPtr[2]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
-            uPtr[2] =
-                uint8_t((uint32_t(uPtr[2]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[((b &   2) ? c1 : c0)];
-            p1 = colormap[((b &   1) ? c1 : c0)];
-            yPtr[6] = uint8_t(p0 & 0xFFU);
-            yPtr[7] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[3] =
-                uint8_t((uint32_t(vPtr[3]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
-            uPtr[3] =
-                uint8_t((uint32_t(uPtr[3]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
-          }
-          break;
-        case 0x04:
-          {
-            uint32_t  tmp = colormap[*(bufp++)];
-            yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
-            uint32_t  v = (tmp >> 20) & 0xFFU;
-            uint32_t  u = (tmp >> 10) & 0xFFU;
-            vPtr[0] = uint8_t((uint32_t(vPtr[0]) + v + 1U) >> 1);
-            uPtr[0] = uint8_t((uint32_t(uPtr[0]) + u + 1U) >> 1);
-            tmp = colormap[*(bufp++)];
-            yPtr[3] = yPtr[2] = uint8_t(tmp & 0xFFU);
-            v = (tmp >> 20) & 0xFFU;
-            u = (tmp >> 10) & 0xFFU;
-            vPtr[1] = uint8_t((uint32_t(vPtr[1]) + v + 1U) >> 1);
-            uPtr[1] = uint8_t((uint32_t(uPtr[1]) + u + 1U) >> 1);
-            tmp = colormap[*(bufp++)];
-            yPtr[5] = yPtr[4] = uint8_t(tmp & 0xFFU);
-            v = (tmp >> 20) & 0xFFU;
-            u = (tmp >> 10) & 0xFFU;
-            vPtr[2] = uint8_t((uint32_t(vPtr[2]) + v + 1U) >> 1);
-            uPtr[2] = uint8_t((uint32_t(uPtr[2]) + u + 1U) >> 1);
-            tmp = colormap[*(bufp++)];
-            yPtr[7] = yPtr[6] = uint8_t(tmp & 0xFFU);
-            v = (tmp >> 20) & 0xFFU;
-            u = (tmp >> 10) & 0xFFU;
-            vPtr[3] = uint8_t((uint32_t(vPtr[3]) + v + 1U) >> 1);
-            uPtr[3] = uint8_t((uint32_t(uPtr[3]) + u + 1U) >> 1);
-          }
-          break;
-        case 0x06:
-          {
-            unsigned char c0 = *(bufp++);
-            unsigned char c1 = *(bufp++);
-            unsigned char b = *(bufp++);
-            uint32_t  p0 = colormap[((b & 128) ? c1 : c0)];
-            uint32_t  p1 = colormap[((b &  64) ? c1 : c0)];
-            uint32_t  p2 = colormap[((b &  32) ? c1 : c0)];
-            uint32_t  p3 = colormap[((b &  16) ? c1 : c0)];
-            yPtr[0] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[1] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[0] =
-                uint8_t((uint32_t(vPtr[0]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
-            uPtr[0] =
-                uint8_t((uint32_t(uPtr[0]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[((b &   8) ? c1 : c0)];
-            p1 = colormap[((b &   4) ? c1 : c0)];
-            p2 = colormap[((b &   2) ? c1 : c0)];
-            p3 = colormap[((b &   1) ? c1 : c0)];
-            yPtr[2] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[3] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[1] =
-                uint8_t((uint32_t(vPtr[1]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
-            uPtr[1] =
-                uint8_t((uint32_t(uPtr[1]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
-            c0 = *(bufp++);
-            c1 = *(bufp++);
-            b = *(bufp++);
-            p0 = colormap[((b & 128) ? c1 : c0)];
-            p1 = colormap[((b &  64) ? c1 : c0)];
-            p2 = colormap[((b &  32) ? c1 : c0)];
-            p3 = colormap[((b &  16) ? c1 : c0)];
-            yPtr[4] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[5] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[2] =
-                uint8_t((uint32_t(vPtr[2]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
-            uPtr[2] =
-                uint8_t((uint32_t(uPtr[2]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[((b &   8) ? c1 : c0)];
-            p1 = colormap[((b &   4) ? c1 : c0)];
-            p2 = colormap[((b &   2) ? c1 : c0)];
-            p3 = colormap[((b &   1) ? c1 : c0)];
-            yPtr[6] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[7] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[3] =
-                uint8_t((uint32_t(vPtr[3]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
-            uPtr[3] =
-                uint8_t((uint32_t(uPtr[3]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
-          }
-          break;
-        case 0x08:
-          {
-            uint32_t  p0 = colormap[*(bufp++)];
-            uint32_t  p1 = colormap[*(bufp++)];
-            yPtr[0] = uint8_t(p0 & 0xFFU);
-            yPtr[1] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[0] =
-                uint8_t((uint32_t(vPtr[0]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
-            uPtr[0] =
-                uint8_t((uint32_t(uPtr[0]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            yPtr[2] = uint8_t(p0 & 0xFFU);
-            yPtr[3] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[1] =
-                uint8_t((uint32_t(vPtr[1]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
-            uPtr[1] =
-                uint8_t((uint32_t(uPtr[1]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            yPtr[4] = uint8_t(p0 & 0xFFU);
-            yPtr[5] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[2] =
-                uint8_t((uint32_t(vPtr[2]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
-            uPtr[2] =
-                uint8_t((uint32_t(uPtr[2]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            yPtr[6] = uint8_t(p0 & 0xFFU);
-            yPtr[7] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[3] =
-                uint8_t((uint32_t(vPtr[3]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
-            uPtr[3] =
-                uint8_t((uint32_t(uPtr[3]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
-          }
-          break;
-        case 0x10:
-          {
-            uint32_t  p0 = colormap[*(bufp++)];
-            uint32_t  p1 = colormap[*(bufp++)];
-            uint32_t  p2 = colormap[*(bufp++)];
-            uint32_t  p3 = colormap[*(bufp++)];
-            yPtr[0] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[1] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[0] =
-                uint8_t((uint32_t(vPtr[0]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
-            uPtr[0] =
-                uint8_t((uint32_t(uPtr[0]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            p2 = colormap[*(bufp++)];
-            p3 = colormap[*(bufp++)];
-            yPtr[2] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[3] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[1] =
-                uint8_t((uint32_t(vPtr[1]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
-            uPtr[1] =
-                uint8_t((uint32_t(uPtr[1]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            p2 = colormap[*(bufp++)];
-            p3 = colormap[*(bufp++)];
-            yPtr[4] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[5] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[2] =
-                uint8_t((uint32_t(vPtr[2]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
-            uPtr[2] =
-                uint8_t((uint32_t(uPtr[2]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            p2 = colormap[*(bufp++)];
-            p3 = colormap[*(bufp++)];
-            yPtr[6] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[7] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[3] =
-                uint8_t((uint32_t(vPtr[3]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
-            uPtr[3] =
-                uint8_t((uint32_t(uPtr[3]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
-          }
-          break;
-        default:
-          yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] =
-          yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = 0x00;
-          vPtr[0] = uint8_t((uint32_t(vPtr[0]) + 1U) >> 1);
-          vPtr[1] = uint8_t((uint32_t(vPtr[1]) + 1U) >> 1);
-          vPtr[2] = uint8_t((uint32_t(vPtr[2]) + 1U) >> 1);
-          vPtr[3] = uint8_t((uint32_t(vPtr[3]) + 1U) >> 1);
-          uPtr[0] = uint8_t((uint32_t(uPtr[0]) + 1U) >> 1);
-          uPtr[1] = uint8_t((uint32_t(uPtr[1]) + 1U) >> 1);
-          uPtr[2] = uint8_t((uint32_t(uPtr[2]) + 1U) >> 1);
-          uPtr[3] = uint8_t((uint32_t(uPtr[3]) + 1U) >> 1);
-          break;
+        break;
+      case 0x02:
+        {
+          uint32_t  tmp = colormap[*(bufp++)];
+          yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
+          vPtr[1] = vPtr[0] = uint8_t((tmp >> 20) & 0xFFU);
+          uPtr[1] = uPtr[0] = uint8_t((tmp >> 10) & 0xFFU);
+          tmp = colormap[*(bufp++)];
+          yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] = uint8_t(tmp & 0xFFU);
+          vPtr[3] = vPtr[2] = uint8_t((tmp >> 20) & 0xFFU);
+          uPtr[3] = uPtr[2] = uint8_t((tmp >> 10) & 0xFFU);
+        }
+        break;
+      case 0x03:
+        {
+          unsigned char c0 = *(bufp++);
+          unsigned char c1 = *(bufp++);
+          unsigned char b = *(bufp++);
+          uint32_t  p0 = colormap[((b & 128) ? c1 : c0)];
+          uint32_t  p1 = colormap[((b &  64) ? c1 : c0)];
+          yPtr[0] = uint8_t(p0 & 0xFFU);
+          yPtr[1] = uint8_t(p1 & 0xFFU);
+          p0 = (p0 + p1) + 0x00100400U;
+          vPtr[0] = uint8_t((p0 >> 21) & 0xFFU);
+          uPtr[0] = uint8_t((p0 >> 11) & 0xFFU);
+          p0 = colormap[((b &  32) ? c1 : c0)];
+          p1 = colormap[((b &  16) ? c1 : c0)];
+          yPtr[2] = uint8_t(p0 & 0xFFU);
+          yPtr[3] = uint8_t(p1 & 0xFFU);
+          p0 = (p0 + p1) + 0x00100400U;
+          vPtr[1] = uint8_t((p0 >> 21) & 0xFFU);
+          uPtr[1] = uint8_t((p0 >> 11) & 0xFFU);
+          p0 = colormap[((b &   8) ? c1 : c0)];
+          p1 = colormap[((b &   4) ? c1 : c0)];
+          yPtr[4] = uint8_t(p0 & 0xFFU);
+          yPtr[5] = uint8_t(p1 & 0xFFU);
+          p0 = (p0 + p1) + 0x00100400U;
+          vPtr[2] = uint8_t((p0 >> 21) & 0xFFU);
+          uPtr[2] = uint8_t((p0 >> 11) & 0xFFU);
+          p0 = colormap[((b &   2) ? c1 : c0)];
+          p1 = colormap[((b &   1) ? c1 : c0)];
+          yPtr[6] = uint8_t(p0 & 0xFFU);
+          yPtr[7] = uint8_t(p1 & 0xFFU);
+          p0 = (p0 + p1) + 0x00100400U;
+          vPtr[3] = uint8_t((p0 >> 21) & 0xFFU);
+          uPtr[3] = uint8_t((p0 >> 11) & 0xFFU);
+        }
+        break;
+      case 0x04:
+        {
+          uint32_t  tmp = colormap[*(bufp++)];
+          yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
+          vPtr[0] = uint8_t((tmp >> 20) & 0xFFU);
+          uPtr[0] = uint8_t((tmp >> 10) & 0xFFU);
+          tmp = colormap[*(bufp++)];
+          yPtr[3] = yPtr[2] = uint8_t(tmp & 0xFFU);
+          vPtr[1] = uint8_t((tmp >> 20) & 0xFFU);
+          uPtr[1] = uint8_t((tmp >> 10) & 0xFFU);
+          tmp = colormap[*(bufp++)];
+          yPtr[5] = yPtr[4] = uint8_t(tmp & 0xFFU);
+          vPtr[2] = uint8_t((tmp >> 20) & 0xFFU);
+          uPtr[2] = uint8_t((tmp >> 10) & 0xFFU);
+          tmp = colormap[*(bufp++)];
+          yPtr[7] = yPtr[6] = uint8_t(tmp & 0xFFU);
+          vPtr[3] = uint8_t((tmp >> 20) & 0xFFU);
+          uPtr[3] = uint8_t((tmp >> 10) & 0xFFU);
+        }
+        break;
+      case 0x06:
+        {
+          unsigned char c0 = *(bufp++);
+          unsigned char c1 = *(bufp++);
+          unsigned char b = *(bufp++);
+          uint32_t  p0 = colormap[((b & 128) ? c1 : c0)];
+          uint32_t  p1 = colormap[((b &  64) ? c1 : c0)];
+          uint32_t  p2 = colormap[((b &  32) ? c1 : c0)];
+          uint32_t  p3 = colormap[((b &  16) ? c1 : c0)];
+          yPtr[0] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+          yPtr[1] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+          p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+          vPtr[0] = uint8_t((p0 >> 22) & 0xFFU);
+          uPtr[0] = uint8_t((p0 >> 12) & 0xFFU);
+          p0 = colormap[((b &   8) ? c1 : c0)];
+          p1 = colormap[((b &   4) ? c1 : c0)];
+          p2 = colormap[((b &   2) ? c1 : c0)];
+          p3 = colormap[((b &   1) ? c1 : c0)];
+          yPtr[2] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+          yPtr[3] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+          p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+          vPtr[1] = uint8_t((p0 >> 22) & 0xFFU);
+          uPtr[1] = uint8_t((p0 >> 12) & 0xFFU);
+          c0 = *(bufp++);
+          c1 = *(bufp++);
+          b = *(bufp++);
+          p0 = colormap[((b & 128) ? c1 : c0)];
+          p1 = colormap[((b &  64) ? c1 : c0)];
+          p2 = colormap[((b &  32) ? c1 : c0)];
+          p3 = colormap[((b &  16) ? c1 : c0)];
+          yPtr[4] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+          yPtr[5] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+          p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+          vPtr[2] = uint8_t((p0 >> 22) & 0xFFU);
+          uPtr[2] = uint8_t((p0 >> 12) & 0xFFU);
+          p0 = colormap[((b &   8) ? c1 : c0)];
+          p1 = colormap[((b &   4) ? c1 : c0)];
+          p2 = colormap[((b &   2) ? c1 : c0)];
+          p3 = colormap[((b &   1) ? c1 : c0)];
+          yPtr[6] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+          yPtr[7] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+          p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+          vPtr[3] = uint8_t((p0 >> 22) & 0xFFU);
+          uPtr[3] = uint8_t((p0 >> 12) & 0xFFU);
+        }
+        break;
+      case 0x08:
+        {
+          uint32_t  p0 = colormap[*(bufp++)];
+          uint32_t  p1 = colormap[*(bufp++)];
+          yPtr[0] = uint8_t(p0 & 0xFFU);
+          yPtr[1] = uint8_t(p1 & 0xFFU);
+          p0 = (p0 + p1) + 0x00100400U;
+          vPtr[0] = uint8_t((p0 >> 21) & 0xFFU);
+          uPtr[0] = uint8_t((p0 >> 11) & 0xFFU);
+          p0 = colormap[*(bufp++)];
+          p1 = colormap[*(bufp++)];
+          yPtr[2] = uint8_t(p0 & 0xFFU);
+          yPtr[3] = uint8_t(p1 & 0xFFU);
+          p0 = (p0 + p1) + 0x00100400U;
+          vPtr[1] = uint8_t((p0 >> 21) & 0xFFU);
+          uPtr[1] = uint8_t((p0 >> 11) & 0xFFU);
+          p0 = colormap[*(bufp++)];
+          p1 = colormap[*(bufp++)];
+          yPtr[4] = uint8_t(p0 & 0xFFU);
+          yPtr[5] = uint8_t(p1 & 0xFFU);
+          p0 = (p0 + p1) + 0x00100400U;
+          vPtr[2] = uint8_t((p0 >> 21) & 0xFFU);
+          uPtr[2] = uint8_t((p0 >> 11) & 0xFFU);
+          p0 = colormap[*(bufp++)];
+          p1 = colormap[*(bufp++)];
+          yPtr[6] = uint8_t(p0 & 0xFFU);
+          yPtr[7] = uint8_t(p1 & 0xFFU);
+          p0 = (p0 + p1) + 0x00100400U;
+          vPtr[3] = uint8_t((p0 >> 21) & 0xFFU);
+          uPtr[3] = uint8_t((p0 >> 11) & 0xFFU);
+        }
+        break;
+      case 0x10:
+        {
+          uint32_t  p0 = colormap[*(bufp++)];
+          uint32_t  p1 = colormap[*(bufp++)];
+          uint32_t  p2 = colormap[*(bufp++)];
+          uint32_t  p3 = colormap[*(bufp++)];
+          yPtr[0] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+          yPtr[1] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+          p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+          vPtr[0] = uint8_t((p0 >> 22) & 0xFFU);
+          uPtr[0] = uint8_t((p0 >> 12) & 0xFFU);
+          p0 = colormap[*(bufp++)];
+          p1 = colormap[*(bufp++)];
+          p2 = colormap[*(bufp++)];
+          p3 = colormap[*(bufp++)];
+          yPtr[2] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+          yPtr[3] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+          p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+          vPtr[1] = uint8_t((p0 >> 22) & 0xFFU);
+          uPtr[1] = uint8_t((p0 >> 12) & 0xFFU);
+          p0 = colormap[*(bufp++)];
+          p1 = colormap[*(bufp++)];
+          p2 = colormap[*(bufp++)];
+          p3 = colormap[*(bufp++)];
+          yPtr[4] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+          yPtr[5] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+          p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+          vPtr[2] = uint8_t((p0 >> 22) & 0xFFU);
+          uPtr[2] = uint8_t((p0 >> 12) & 0xFFU);
+          p0 = colormap[*(bufp++)];
+          p1 = colormap[*(bufp++)];
+          p2 = colormap[*(bufp++)];
+          p3 = colormap[*(bufp++)];
+          yPtr[6] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+          yPtr[7] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+          p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+          vPtr[3] = uint8_t((p0 >> 22) & 0xFFU);
+          uPtr[3] = uint8_t((p0 >> 12) & 0xFFU);
         }
-        yPtr = yPtr + 8;
-        vPtr = vPtr + 4;
-        uPtr = uPtr + 4;
+        break;
+      default:
+        yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] =
+        yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = 0x00;
+        vPtr[3] = vPtr[2] = vPtr[1] = vPtr[0] = 0x00;
+        uPtr[3] = uPtr[2] = uPtr[1] = uPtr[0] = 0x00;
+        break;
       }
+      yPtr = yPtr + 8;
+      vPtr = vPtr + 4;
+      uPtr = uPtr + 4;
+    }
+    if (lineNum & 1) {
+      averageChromaLine(&(frameBuf1V[offs]), &(chromaBuf[0]), videoWidth >> 1);
+      averageChromaLine(&(frameBuf1U[offs]), &(chromaBuf[videoWidth >> 1]),
+                        videoWidth >> 1);
     }
   }
 
-  void VideoCapture_YV12::frameDone()
+  // Output the frame at the current position between the two input frames
+  // from the difference of the integrated image, and start integrating from
+  // here. Returns true if the output frame is not the same as the previous
+  // one. The Y, V and U planes are processed as a single buffer.
+  static bool interpolateFrame(uint8_t *outBuf, int32_t *interpBuf,
+                               const uint8_t *frameBuf0,
+                               const uint8_t *frameBuf1,
+                               int32_t scaleFac0, int32_t scaleFac1,
+                               int32_t outScale, int n)
+  {
+    uint8_t frameChanged = 0x00;
+    for (int i = 0; i < n; i++) {
+      int32_t tmp = (int32_t(frameBuf0[i]) * scaleFac0)
+                    + (int32_t(frameBuf1[i]) * scaleFac1);
+      uint8_t tmp2 = uint8_t(((((interpBuf[i] - tmp) >> 8) * outScale)
+                              + 0x00200000) >> 22);
+      interpBuf[i] = tmp;
+      frameChanged |= (tmp2 ^ outBuf[i]);
+      outBuf[i] = tmp2;
+    }
+    return bool(frameChanged);
+  }
+
+  // integrate the image between the two input frames
+  static void resampleFrame_(int32_t *interpBuf, const uint8_t *frameBuf0,
+                             const uint8_t *frameBuf1, int32_t scaleFac, int n)
+  {
+    for (int i = 0; i < n; i++)
+      interpBuf[i] += ((int32_t(frameBuf0[i]) + int32_t(frameBuf1[i]))
+                       * scaleFac);
+  }
+
+  void VideoCapture_YV12::frameDone(const FrameData& frame)
   {
     resampleFrame();
-    while (audioBufSamples >= (audioBufSize * 2)) {
-      audioBufSamples -= (audioBufSize * 2);
+    for (int j = 0; j < frame.outputFrames; j++) {
       int64_t   frameTime =
           int64_t((4294967296000000.0 / double(frameRate)) + 0.5);
       if (frameTime > frame1Time)
@@ -1646,38 +1653,19 @@ namespace Ep128Emu {
       int32_t   scaleFac1 = int32_t(double(t1) * (2.0 - tt) + 0.5);
       int32_t   outScale = int32_t(0x20000000) / (interpTime - t1);
       interpTime = t1;
-      int       n = (videoWidth * videoHeight * 3) / 2;
-      int       i = 0;
-      uint8_t   frameChanged = 0x00;
-      do {
-        int32_t   tmp;
-        uint8_t   tmp2;
-        tmp = (int32_t(frameBuf0Y[i]) * scaleFac0)
-              + (int32_t(frameBuf1Y[i]) * scaleFac1);
-        tmp2 = uint8_t(((((interpBufY[i] - tmp) >> 8) * outScale)
-                        + 0x00200000) >> 22);
-        interpBufY[i] = tmp;
-        frameChanged |= (tmp2 ^ outBufY[i]);
-        outBufY[i] = tmp2;
-        i++;
-        tmp = (int32_t(frameBuf0Y[i]) * scaleFac0)
-              + (int32_t(frameBuf1Y[i]) * scaleFac1);
-        tmp2 = uint8_t(((((interpBufY[i] - tmp) >> 8) * outScale)
-                        + 0x00200000) >> 22);
-        interpBufY[i] = tmp;
-        frameChanged |= (tmp2 ^ outBufY[i]);
-        outBufY[i] = tmp2;
-      } while (++i < n);
-      writeFrame(bool(frameChanged));
-      audioBufReadPos += (audioBufSize * 2);
-      while (audioBufReadPos >= (audioBufSize * audioBuffers * 2))
-        audioBufReadPos -= (audioBufSize * audioBuffers * 2);
+      bool      frameChanged =
+          interpolateFrame(outBufY, interpBufY, frameBuf0Y, frameBuf1Y,
+                           scaleFac0, scaleFac1, outScale,
+                           (videoWidth * videoHeight * 3) / 2);
+      writeFrame(frameChanged,
+                 &(frame.audioData.front()) + (j * audioBufSize * 2));
       frame0Time -= frameTime;
       frame1Time -= frameTime;
       curTime -= frameTime;
     }
     int64_t   frameTime =
-        ((int64_t(audioBufSamples * 5000) << 32) + int64_t(sampleRate / 200))
+        ((int64_t(frame.audioBufSamples * 5000) << 32)
+         + int64_t(sampleRate / 200))
         / int64_t(sampleRate / 100);
     curTime += (frameTime - frame1Time);
     frame0Time += (frameTime - frame1Time);
@@ -1705,18 +1693,12 @@ namespace Ep128Emu {
     int32_t   scaleFac =
         int32_t(((frame1Time - frame0Time) + int64_t(0x80000000UL)) >> 32);
     interpTime += scaleFac;
-    int       n = (videoWidth * videoHeight * 3) / 2;
-    int       i = 0;
-    do {
-      interpBufY[i] +=
-          ((int32_t(frameBuf0Y[i]) + int32_t(frameBuf1Y[i])) * scaleFac);
-      i++;
-      interpBufY[i] +=
-          ((int32_t(frameBuf0Y[i]) + int32_t(frameBuf1Y[i])) * scaleFac);
-    } while (++i < n);
+    resampleFrame_(interpBufY, frameBuf0Y, frameBuf1Y, scaleFac,
+                   (videoWidth * videoHeight * 3) / 2);
   }
 
-  void VideoCapture_YV12::writeFrame(bool frameChanged)
+  void VideoCapture_YV12::writeFrame(bool frameChanged,
+                                     const int16_t *audioData)
   {
     if (!aviFile)
       return;
@@ -1736,19 +1718,6 @@ namespace Ep128Emu {
           uint8_t(1 << (framesWritten & 7));
     }
     try {
-      if (fileSize >= 0x7F800000) {
-        closeFile();
-        try {
-          errorMessage("AVI file is too large, starting new output file");
-        }
-        catch (...) {
-        }
-        std::string fileName = "";
-        fileNameCallback(fileNameCallbackUserData, fileName);
-        if (fileName.length() < 1)
-          return;
-        openFile(fileName.c_str());
-      }
       if (std::fseek(aviFile, 0L, SEEK_END) < 0)
         throw Exception("error seeking AVI file");
       uint8_t headerBuf[8];
@@ -1773,11 +1742,8 @@ namespace Ep128Emu {
       fileSize = fileSize + 8;
       if (std::fwrite(&(headerBuf[0]), 1, 8, aviFile) != 8)
         throw Exception("error writing AVI file");
-      int     bufPos = audioBufReadPos;
       for (int i = 0; i < (audioBufSize * 2); i++) {
-        if (bufPos >= (audioBufSize * audioBuffers * 2))
-          bufPos = 0;
-        int16_t tmp = audioBuf[bufPos++];
+        int16_t tmp = audioData[i];
         fileSize++;
         if (std::fputc(int(uint16_t(tmp) & 0xFF), aviFile) == EOF)
           throw Exception("error writing AVI file");
@@ -1787,8 +1753,8 @@ namespace Ep128Emu {
       }
     }
     catch (std::exception& e) {
-      closeFile();
-      errorMessage(e.what());
+      closeFile_();
+      encoderError(e.what());
       return;
     }
     framesWritten++;
@@ -1797,7 +1763,7 @@ namespace Ep128Emu {
         writeAVIHeader();
       }
       catch (std::exception& e) {
-        errorMessage(e.what());
+        encoderError(e.what());
       }
     }
   }
@@ -23,6 +23,9 @@
 #include "ep128emu.hpp"
 #include "display.hpp"
 #include "snd_conv.hpp"
+#include "system.hpp"
+
+#include <vector>
 
 namespace Ep128Emu {
 
@@ -30,6 +33,8 @@ namespace Ep128Emu {
    public:
     static const int  sampleRate = 48000;
     static const int  audioBuffers = 8;
+    // maximum number of frames waiting to be encoded and written to the file
+    static const int  frameQueueSize = 16;
    protected:
     class AudioConverter_ : public AudioConverterHighQuality {
      private:
@@ -43,6 +48,30 @@ namespace Ep128Emu {
      protected:
       virtual void audioOutput(int16_t left, int16_t right);
     };
+    // Data passed from the emulation thread to the encoder thread at the end
+    // of each emulated frame.
+    struct FrameData {
+      // video data, in a format defined by the derived class
+      std::vector< uint8_t >  videoData;
+      // (sampleRate / frameRate) stereo samples for each output frame
+      std::vector< int16_t >  audioData;
+      // number of output frames to be written, can be zero
+      int         outputFrames;
+      // samples left in the audio buffer after the output frames
+      int         audioBufSamples;
+      // time elapsed since the previous frame (used by the YV12 format)
+      int64_t     timeElapsed;
+      FrameData();
+    };
+    class EncoderThread : public Thread {
+     private:
+      VideoCapture& videoCapture;
+     public:
+      EncoderThread(VideoCapture& videoCapture_);
+      virtual ~EncoderThread();
+     protected:
+      virtual void run();
+    };
     // --------
     std::FILE   *aviFile;
     int16_t     *audioBuf;              // 8 * (sampleRate / frameRate) frames
@@ -67,6 +96,25 @@ namespace Ep128Emu {
     void        *errorCallbackUserData;
     void        (*fileNameCallback)(void *userData, std::string& fileName);
     void        *fileNameCallbackUserData;
+    // The members below are used for passing the frames to the encoder
+    // thread. While a file is open, aviFile, framesWritten, duplicateFrames
+    // and fileSize are only accessed by the encoder thread, or by the
+    // emulation thread while the frame queue is empty.
+    FrameData   nextFrame;              // the frame being emulated
+    FrameData   *frameQueue;            // frameQueueSize entries
+    int         frameQueueReadPos;
+    int         frameQueueWritePos;
+    int         framesQueued;
+    // set by the encoder thread if a new file needs to be opened by the
+    // emulation thread, and the queue is not processed until then
+    bool        fileSplitPending;
+    bool        encoderQuitFlag;
+    // to be reported by the emulation thread
+    std::vector< std::string >  encoderErrors;
+    Mutex       frameQueueMutex;
+    ThreadLock  frameQueuedEvent;       // signaled when a frame is queued
+    ThreadLock  frameDoneEvent;         // signaled by the encoder thread
+    EncoderThread *encoderThread;
     // ----------------
     static void aviHeader_writeFourCC(uint8_t*& bufp, const char *s);
     static void aviHeader_writeUInt16(uint8_t*& bufp, uint16_t n);
@@ -75,6 +123,32 @@ namespace Ep128Emu {
     static void defaultFileNameCallback(void *userData, std::string& fileName);
     virtual void writeAVIHeader() = 0;
     virtual void writeAVIIndex() = 0;
+    /*!
+     * Encode and write 'frame.outputFrames' frames, called on the encoder
+     * thread. Errors should be reported with encoderError().
+     */
+    virtual void encodeFrame(FrameData& frame) = 0;
+    /*!
+     * Move the complete output frames of audio samples from the audio buffer
+     * to nextFrame, and add it to the encoder queue, waiting if the queue is
+     * full. Called on the emulation thread at the end of each frame.
+     */
+    void queueFrame();
+    /*!
+     * Wait until all queued frames are written.
+     */
+    void flushFrameQueue();
+    void encoderThreadLoop();
+    // store a line of 'nBytes' bytes as a record of line number, length and
+    // data, which the encoder thread uses to rebuild the frame
+    static void appendLine(std::vector< uint8_t >& buf, int lineNum,
+                           const uint8_t *lineData, size_t nBytes);
+    void encoderError(const char *msg);
+    void reportEncoderErrors();
+    // close the file on reaching the size limit, and open a new one
+    void splitFile();
+    void openFile_(const char *fileName);
+    void closeFile_();
     void closeFile();
     void errorMessage(const char *msg);
    public:
@@ -158,6 +232,7 @@ namespace Ep128Emu {
     // --------
     VideoCaptureFrameBuffer tmpFrameBuf;    // 768x576
     VideoCaptureFrameBuffer outputFrameBuf; // 768x576
+    VideoCaptureFrameBuffer encoderFrameBuf;    // copy on encoder thread
     uint32_t    *frameSizes;
     int         cycleCnt;
     bool        prvOddFrame;
@@ -166,9 +241,10 @@ namespace Ep128Emu {
     void frameDone();
     void decodeLine(uint8_t *outBuf, const uint8_t *inBuf);
     size_t rleCompressLine(uint8_t *outBuf, const uint8_t *inBuf);
-    void writeFrame(bool frameChanged);
+    void writeFrame(bool frameChanged, const int16_t *audioData);
     virtual void writeAVIHeader();
     virtual void writeAVIIndex();
+    virtual void encodeFrame(FrameData& frame);
    public:
     VideoCapture_RLE8(void indexToRGBFunc(uint8_t color,
                                           float& r, float& g, float& b) =
@@ -186,7 +262,9 @@ namespace Ep128Emu {
    public:
     static const int  videoWidth = 384;
     static const int  videoHeight = 288;
-   private:
+   protected:
+    // the frame buffers are only used by the encoder thread
+    // (protected for the reference implementation in test/vrectest.cpp)
     uint8_t     *lineBuf;               // 1024 bytes
     uint8_t     *frameBuf0Y;            // 384x288
     uint8_t     *frameBuf0V;            // 192x144
@@ -202,20 +280,21 @@ namespace Ep128Emu {
     uint8_t     *outBufU;               // 192x144
     uint8_t     *duplicateFrameBitmap;
     int64_t     timesliceLength;
+    int64_t     timeElapsed;            // since the last frame was queued
     int64_t     curTime;
     int64_t     frame0Time;
     int64_t     frame1Time;
     int         cycleCnt;
     int32_t     interpTime;
-    size_t      lineBufBytes;
     uint32_t    *colormap;
     // ----------------
-    void decodeLine();
-    void frameDone();
+    void decodeLine(int lineNum);
+    void frameDone(const FrameData& frame);
     void resampleFrame();
-    void writeFrame(bool frameChanged);
+    void writeFrame(bool frameChanged, const int16_t *audioData);
     virtual void writeAVIHeader();
     virtual void writeAVIIndex();
+    virtual void encodeFrame(FrameData& frame);
    public:
     VideoCapture_YV12(void indexToRGBFunc(uint8_t color,
                                           float& r, float& g, float& b) =
@@ -28,6 +28,7 @@
 #include "debuglib.hpp"
 
 #include <typeinfo>
+#include <algorithm>
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -157,7 +158,10 @@ namespace Ep128Emu {
       fileIOWorkingDirectory(".\\"),
 #endif
       fileNameCallback(&defaultFileNameCallback),
-      fileNameCallbackUserData((void *) 0)
+      fileNameCallbackUserData((void *) 0),
+      z80ProfilerCnt(0U),
+      z80ProfilerInterval(0U),
+      z80ProfilerSeed(1U)
   {
   }
 
@@ -228,6 +232,10 @@ namespace Ep128Emu {
     (void) offs;
   }
 
+  void VirtualMachine::clearRAM()
+  {
+  }
+
   void VirtualMachine::loadMemoryConfiguration(const std::string& fileName_)
   {
     (void) fileName_;
@@ -244,12 +252,14 @@ namespace Ep128Emu {
 
 #ifdef ENABLE_RESID
   void VirtualMachine::setSIDConfiguration(int n, int model,
-                                           double volumeL, double volumeR)
+                                           double volumeL, double volumeR,
+                                           bool highQuality)
   {
     (void) n;
     (void) model;
     (void) volumeL;
     (void) volumeR;
+    (void) highQuality;
   }
 #endif
 
@@ -775,6 +785,77 @@ namespace Ep128Emu {
     return addr;
   }
 
+  void VirtualMachine::z80ProfilerSample_()
+  {
+    uint16_t  pc = getProgramCounter();
+    uint32_t  addr = (uint32_t(getMemoryPage(pc >> 14)) << 14)
+                     | uint32_t(pc & 0x3FFF);
+    z80ProfileData[addr]++;
+    // randomize the interval (keeping the average) to avoid aliasing with
+    // loops that have a length that divides it
+    z80ProfilerSeed = (z80ProfilerSeed * 1103515245U + 12345U) & 0x7FFFFFFFU;
+    z80ProfilerCnt = (z80ProfilerInterval >> 1) + 1U
+                     + ((z80ProfilerSeed >> 8) % z80ProfilerInterval);
+  }
+
+  void VirtualMachine::setZ80ProfilerInterval(uint32_t interval)
+  {
+    z80ProfilerInterval = interval;
+    z80ProfilerCnt = interval;
+  }
+
+  void VirtualMachine::clearZ80Profile()
+  {
+    z80ProfileData.clear();
+  }
+
+  static bool compareZ80ProfileEntries(
+      const std::pair< uint32_t, uint32_t >& a,
+      const std::pair< uint32_t, uint32_t >& b)
+  {
+    return (a.second > b.second || (a.second == b.second && a.first < b.first));
+  }
+
+  size_t VirtualMachine::getZ80Profile(
+      std::vector< std::pair< uint32_t, uint32_t > >& buf) const
+  {
+    size_t  totalSamples = 0;
+    buf.clear();
+    buf.reserve(z80ProfileData.size());
+    std::map< uint32_t, uint32_t >::const_iterator  i;
+    for (i = z80ProfileData.begin(); i != z80ProfileData.end(); i++) {
+      buf.push_back(*i);
+      totalSamples += (*i).second;
+    }
+    std::sort(buf.begin(), buf.end(), &compareZ80ProfileEntries);
+    return totalSamples;
+  }
+
+  void VirtualMachine::listZ80Profile(std::string& buf, size_t maxLines) const
+  {
+    std::vector< std::pair< uint32_t, uint32_t > >  tmp;
+    size_t  totalSamples = getZ80Profile(tmp);
+    buf = "";
+    std::string disasmBuf;
+    char    tmpBuf[40];
+    for (size_t i = 0; i < tmp.size() && i < maxLines; i++) {
+      uint32_t  addr = tmp[i].first;
+      std::sprintf(&(tmpBuf[0]), "%8u %6.2f%%  %02X:%04X  ",
+                   (unsigned int) tmp[i].second,
+                   double(tmp[i].second) * 100.0 / double(totalSamples),
+                   (unsigned int) (addr >> 14),
+                   (unsigned int) (addr & 0x3FFFU));
+      // the disassembly starts with the 22-bit physical address
+      disassembleInstruction(disasmBuf, addr);
+      if (disasmBuf.length() > 8)
+        disasmBuf.erase(0, 8);
+      if (i > 0)
+        buf += '\n';
+      buf += &(tmpBuf[0]);
+      buf += disasmBuf;
+    }
+  }
+
   Ep128::Z80_REGISTERS& VirtualMachine::getZ80Registers()
   {
     return *((Ep128::Z80_REGISTERS *) 0);
@@ -28,6 +28,9 @@
 #include "soundio.hpp"
 #include "tape.hpp"
 
+#include <map>
+#include <vector>
+
 namespace Ep128 {
   struct Z80_REGISTERS;
 }
@@ -76,6 +79,25 @@ namespace Ep128Emu {
     std::string     fileIOWorkingDirectory;
     void            (*fileNameCallback)(void *userData, std::string& fileName);
     void            *fileNameCallbackUserData;
+    // Z80 program counter profiler: instructions until the next sample
+    // (0 if the profiler is not running), sample interval, and number of
+    // samples per physical address (8 bit segment + 14 bit offset)
+    uint32_t        z80ProfilerCnt;
+    uint32_t        z80ProfilerInterval;
+    uint32_t        z80ProfilerSeed;
+    std::map< uint32_t, uint32_t >  z80ProfileData;
+    void z80ProfilerSample_();
+   protected:
+    /*!
+     * Should be called by derived classes after each Z80 instruction.
+     */
+    EP128EMU_INLINE void z80ProfilerUpdate()
+    {
+      if (EP128EMU_UNLIKELY(z80ProfilerCnt != 0U)) {
+        if (--z80ProfilerCnt == 0U)
+          z80ProfilerSample_();
+      }
+    }
    public:
     struct VMStatus {
       bool      isRecordingDemo;
@@ -140,6 +162,13 @@ namespace Ep128Emu {
      * Load ROM segment 'n' from the specified file, skipping 'offs' bytes.
      */
     virtual void loadROMSegment(uint8_t n, const char *fileName, size_t offs);
+    /*!
+     * Set the contents of all RAM segments to the same initial state as
+     * resetMemoryConfiguration() does, without changing the memory layout.
+     * The default implementation does nothing, for machines where
+     * resetMemoryConfiguration() keeps the contents of RAM.
+     */
+    virtual void clearRAM();
     /*!
      * Load epmemcfg format memory configuration file.
      */
@@ -156,9 +185,12 @@ namespace Ep128Emu {
     /*!
      * Configure SID 'n' (0 to 3, currently only 3 is supported),
      * 'model' can be 0 to disable the emulation, 1 for MOS 6581 or 2 for 8580.
+     * If 'highQuality' is false, the SID is clocked in blocks of several
+     * cycles, and its output is interpolated between the blocks.
      */
     virtual void setSIDConfiguration(int n, int model,
-                                     double volumeL, double volumeR);
+                                     double volumeL, double volumeR,
+                                     bool highQuality);
 #endif
     /*!
      * Set audio output quality.
@@ -419,6 +451,9 @@ namespace Ep128Emu {
      */
     virtual void setForceTapeMotorOn(bool isEnabled);
     // ------------------------------ DEBUGGING -------------------------------
+    // NOTE: if EP128EMU_NO_BREAKPOINTS is defined (the default libretro
+    // build profile), breakpoints and single step mode can still be set,
+    // but they never trigger a break
     /*!
      * Add breakpoints from the specified breakpoint list (see also
      * bplist.hpp).
@@ -551,6 +586,39 @@ namespace Ep128Emu {
     virtual uint32_t disassembleInstruction(std::string& buf, uint32_t addr,
                                             bool isCPUAddress = false,
                                             int32_t offs = 0) const;
+    /*!
+     * Start sampling the Z80 program counter after every 'interval'
+     * instructions, or stop the profiler if 'interval' is zero. The samples
+     * are counted per physical address (the segment is looked up with
+     * getMemoryPage()), and are kept until clearZ80Profile() is called.
+     */
+    void setZ80ProfilerInterval(uint32_t interval);
+    /*!
+     * Returns the Z80 profiler sample interval (0: not running).
+     */
+    inline uint32_t getZ80ProfilerInterval() const
+    {
+      return z80ProfilerInterval;
+    }
+    /*!
+     * Delete all Z80 profiler samples.
+     */
+    void clearZ80Profile();
+    /*!
+     * Store the Z80 profiler results in 'buf' as (physical address, number
+     * of samples) pairs, sorted by decreasing number of samples.
+     * Returns the total number of samples.
+     */
+    size_t getZ80Profile(std::vector< std::pair< uint32_t, uint32_t > >& buf)
+        const;
+    /*!
+     * Write the 'maxLines' most frequently sampled addresses to 'buf' in
+     * ASCII format, one line per address with the number and percentage of
+     * samples, the address as segment:offset, and the disassembled
+     * instruction. Lines are separated by '\n' characters, there is no
+     * newline character at the end of the buffer.
+     */
+    void listZ80Profile(std::string& buf, size_t maxLines) const;
     /*!
      * Returns a reference to a structure containing all Z80 registers;
      * see z80/z80.hpp for more information.
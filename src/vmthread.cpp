@@ -18,6 +18,7 @@
 // Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "ep128emu.hpp"
+#include "perfcnt.hpp"
 #include "system.hpp"
 #include "vm.hpp"
 #include "vmthread.hpp"
@@ -120,6 +121,10 @@ namespace Ep128Emu {
 
   bool VMThread::process()
   {
+#ifdef EP128EMU_PERF_COUNTERS
+    // iterations that do not run the emulation are counted as wait time
+    uint64_t  perfIdleStart = perfTimerGet();
+#endif
     // check and process any pending messages
     mutex_.lock();
     while (true) {
@@ -173,8 +178,10 @@ namespace Ep128Emu {
 #endif // EP128EMU_LIBRETRO_CORE
         vm.run(2000);
         curTime = speedTimer.getRealTime();
-        if (curTime < nxtTime)
+        if (curTime < nxtTime) {
+          EP128EMU_PERF_SCOPE(PERF_VMTHREAD_WAIT, 0);
           Timer::wait(nxtTime - curTime);
+        }
         else if (curTime > (nxtTime + 0.25))
           nxtTime = curTime;
       }
@@ -184,6 +191,10 @@ namespace Ep128Emu {
 #endif // EP128EMU_LIBRETRO_CORE
         curTime = speedTimer.getRealTime();
         nxtTime = curTime;
+#ifdef EP128EMU_PERF_COUNTERS
+        perfCounters[PERF_VMTHREAD_WAIT].calls++;
+        perfEnd(PERF_VMTHREAD_WAIT, perfIdleStart);
+#endif
       }
     }
     catch (Exception& e) {
@@ -225,13 +236,19 @@ namespace Ep128Emu {
   void VMThread::run()
   {
     while (true) {
-      mutex_.lock();
-      bool  lockFlag = (lockCnt != 0UL);
-      if (lockFlag)
-        threadLock2.notify();
-      mutex_.unlock();
-      if (lockFlag)
+      // wait until unlocked; the notification from unlock() may be left
+      // over from an earlier lock, so the lock count is always rechecked
+      while (true) {
+        mutex_.lock();
+        bool  lockFlag = (lockCnt != 0UL);
+        if (lockFlag)
+          threadLock2.notify();
+        mutex_.unlock();
+        if (!lockFlag)
+          break;
+        EP128EMU_PERF_SCOPE(PERF_VMTHREAD_WAIT, 0);
         threadLock1.wait();
+      }
       if (!this->process())
         break;
     }
@@ -274,7 +291,6 @@ namespace Ep128Emu {
       mutex_.unlock();
       return 0;
     }
-    threadLock1.wait(0);
     threadLock2.wait(0);
     mutex_.unlock();
     bool  tmp = threadLock2.wait(t);
@@ -425,9 +441,13 @@ namespace Ep128Emu {
 
   bool VMThread::isReady(void)
   {
-    if (allowedRuntime > 2000)
-      return false;
-    else return true;
+    // allowedRuntime is only decremented after a time slice has completed,
+    // so if it is less than one slice, the VM is not running and will not
+    // start again until the next allowRunFor()
+    mutex_.lock();
+    bool  retval = (allowedRuntime < 2000);
+    mutex_.unlock();
+    return retval;
   }
 
 
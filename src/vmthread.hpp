@@ -93,6 +93,9 @@ namespace Ep128Emu {
     void allowRunFor(size_t microseconds);
     /*!
      * True if VM has already consumed the execution time set up in allowRunFor.
+     * The VM thread is idle at this point, so the state of the emulated
+     * machine (and any input queued before the next allowRunFor) is
+     * deterministic.
      */
     bool isReady(void);
     /*!
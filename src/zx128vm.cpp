@@ -29,7 +29,7 @@
 #include "zx128vm.hpp"
 #include "debuglib.hpp"
 #include "videorec.hpp"
-#include "roms/roms.hpp"
+#include "builtinrom.hpp"
 #include <vector>
 
 static const uint8_t  keyboardConvTable[256] = {
@@ -215,13 +215,15 @@ namespace ZX128 {
       readTapeFile();
       addr = uint16_t(R.PC.W.l);
     }
-    if (!vm.singleStepMode) {
-      uint8_t   retval = vm.memory.readOpcode(addr);
+#ifndef EP128EMU_NO_BREAKPOINTS
+    if (vm.singleStepMode) {
+      // single step mode
+      uint8_t   retval = vm.checkSingleStepModeBreak();
       vm.updateCPUHalfCycles(4);
       return retval;
     }
-    // single step mode
-    uint8_t   retval = vm.checkSingleStepModeBreak();
+#endif
+    uint8_t   retval = vm.memory.readOpcode(addr);
     vm.updateCPUHalfCycles(4);
     return retval;
   }
@@ -273,6 +275,7 @@ namespace ZX128 {
     vm.memoryWait(addr);
     while (vm.z80OpcodeHalfCycles >= 8)
       vm.runOneCycle();
+    vm.ula.videoMemoryWrite(addr);
     vm.memory.write(addr, value);
     vm.updateCPUHalfCycles(1);
   }
@@ -283,6 +286,7 @@ namespace ZX128 {
     vm.memoryWait(addr);
     while (vm.z80OpcodeHalfCycles >= 8)
       vm.runOneCycle();
+    vm.ula.videoMemoryWrite(addr);
     vm.memory.write(addr, uint8_t(value) & 0xFF);
     vm.updateCPUHalfCycles(1);
     addr = (addr + 1) & 0xFFFF;
@@ -290,6 +294,7 @@ namespace ZX128 {
     vm.memoryWait(addr);
     while (vm.z80OpcodeHalfCycles >= 8)
       vm.runOneCycle();
+    vm.ula.videoMemoryWrite(addr);
     vm.memory.write(addr, uint8_t(value >> 8));
     vm.updateCPUHalfCycles(1);
   }
@@ -306,11 +311,13 @@ namespace ZX128 {
     vm.memoryWait((addr + 1) & 0xFFFF);
     while (vm.z80OpcodeHalfCycles >= 8)
       vm.runOneCycle();
+    vm.ula.videoMemoryWrite((addr + 1) & 0xFFFF);
     vm.memory.write((addr + 1) & 0xFFFF, uint8_t(value >> 8));
     vm.updateCPUHalfCycles(1);
     vm.memoryWait(addr);
     while (vm.z80OpcodeHalfCycles >= 8)
       vm.runOneCycle();
+    vm.ula.videoMemoryWrite(addr);
     vm.memory.write(addr, uint8_t(value) & 0xFF);
     vm.updateCPUHalfCycles(1);
   }
@@ -986,6 +993,7 @@ namespace ZX128 {
     ulaCyclesRemainingH = int32_t(ulaCyclesRemaining >> 32);
     while (EP128EMU_EXPECT(ulaCyclesRemainingH > 0)) {
       z80.executeInstruction();
+      z80ProfilerUpdate();
       if (EP128EMU_EXPECT(z80OpcodeHalfCycles >= 8)) {
         do {
           runOneCycle();
@@ -1040,6 +1048,15 @@ namespace ZX128 {
     this->reset(true);
   }
 
+  void ZX128VM::clearRAM()
+  {
+    stopDemo();
+    for (int i = 0; i < 256; i++) {
+      if (memory.isSegmentRAM(uint8_t(i)))
+        memory.loadSegment(uint8_t(i), false, (uint8_t *) 0, 0);
+    }
+  }
+
   void ZX128VM::loadROMSegment(uint8_t n, const char *fileName, size_t offs)
   {
     stopDemo();
@@ -1052,10 +1069,11 @@ namespace ZX128 {
     }
     // load file into memory
     std::vector<uint8_t>  buf;
-    std::map<std::string, const unsigned char*>::const_iterator  iter_builtin_rom;
-    iter_builtin_rom = Ep128Emu::builtin_rom.find(fileName);
-    if (iter_builtin_rom != Ep128Emu::builtin_rom.end()) {
-      buf.insert(buf.begin(), (*iter_builtin_rom).second+offs, (*iter_builtin_rom).second + offs + 0x4000);
+    if (Ep128Emu::isBuiltinROM(fileName)) {
+      const std::vector<uint8_t>& romData = Ep128Emu::getBuiltinROM(fileName);
+      if (romData.size() < offs + 0x4000)
+        throw Ep128Emu::Exception("ROM file is shorter than expected");
+      buf.insert(buf.begin(), romData.begin() + offs, romData.begin() + offs + 0x4000);
     } else {
       buf.resize(0x4000);
       std::FILE   *f = Ep128Emu::fileOpen(fileName, "rb");
@@ -210,6 +210,11 @@ namespace ZX128 {
      * Load ROM segment 'n' from the specified file, skipping 'offs' bytes.
      */
     virtual void loadROMSegment(uint8_t n, const char *fileName, size_t offs);
+    /*!
+     * Set the contents of all RAM segments to the same initial state as
+     * resetMemoryConfiguration() does, without changing the memory layout.
+     */
+    virtual void clearRAM();
     /*!
      * Set the number of video 'slots' per second (defaults to 886724 Hz).
      */
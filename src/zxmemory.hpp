@@ -88,8 +88,10 @@ namespace ZX128 {
   {
     uint8_t page = uint8_t(addr >> 14);
     uint8_t value = pageAddressTableR[page][addr];
+#ifndef EP128EMU_NO_BREAKPOINTS
     if (haveBreakPoints)
       checkReadBreakPoint(addr, page, value);
+#endif
     return value;
   }
 
@@ -97,8 +99,10 @@ namespace ZX128 {
   {
     uint8_t page = uint8_t(addr >> 14);
     uint8_t value = pageAddressTableR[page][addr];
+#ifndef EP128EMU_NO_BREAKPOINTS
     if (haveBreakPoints)
       checkExecuteBreakPoint(addr, page, value);
+#endif
     return value;
   }
 
@@ -122,8 +126,10 @@ namespace ZX128 {
   inline void Memory::write(uint16_t addr, uint8_t value)
   {
     uint8_t page = uint8_t(addr >> 14);
+#ifndef EP128EMU_NO_BREAKPOINTS
     if (haveBreakPoints)
       checkWriteBreakPoint(addr, page, value);
+#endif
     pageAddressTableW[page][addr] = value;
   }
 
@@ -0,0 +1,220 @@
+// ep128emu-core -- libretro core version of the ep128emu emulator
+// Copyright (C) 2022 Zoltan Balogh
+// https://github.com/zoltanvb/ep128emu-core
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// reSID regression test: drives the SID with a fixed sequence of random
+// register writes for both chip models, and checks the filter output of
+// each cycle of SID::clockCallback() and SID::clock_block() against hashes
+// of the output of the reSID code before clock_block() was added (stored
+// in sidtest_ref.h, one hash per 65536 cycles). The fast mode used by
+// Ep128VM (SID::clock_fast() over 16 cycles) only approximates the per
+// cycle output, its error at the end of each period is checked against
+// fixed limits instead.
+//
+// Usage: sidtest [-generate]
+// With -generate, the hashes of the clockCallback() output are written to
+// stdout in the format of sidtest_ref.h. The exit status is zero if all
+// checks pass.
+
+#include "ep128emu.hpp"
+#include "resid/sid.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static const unsigned int sidTestCycles = 2097152U;
+static const unsigned int sidTestChunkSize = 65536U;
+static const unsigned int sidTestChunks = sidTestCycles / sidTestChunkSize;
+
+#include "sidtest_ref.h"
+
+// limits for the fast mode error, 25% above the measured values
+static const int    fastModeMaxError[2] = { 10660, 11746 };
+static const double fastModeRMSError[2] = { 230.0, 390.0 };
+
+static const unsigned int fastModeBlockSize = 16U;
+
+class SIDTestWriter {
+ private:
+  uint32_t  seed;
+ public:
+  SIDTestWriter()
+    : seed(12345U)
+  {
+  }
+  // returns the number of cycles to run after the write (1 to 64)
+  unsigned int nextWrite(unsigned int& addr, unsigned int& value)
+  {
+    uint32_t  r[5];
+    for (int i = 0; i < 5; i++) {
+      seed = seed * 1103515245U + 12345U;
+      r[i] = seed >> 8;
+    }
+    addr = r[1] % 25U;
+    value = r[2] & 0xFFU;
+    if (addr == 4U || addr == 11U || addr == 18U) {
+      // control registers: keep the test and ring/sync bits rare, so
+      // that the oscillators are not held in reset most of the time
+      value = (value & 0xF1U) | ((r[3] & 7U) == 0U ? 2U : 0U)
+              | ((r[4] & 15U) == 0U ? 4U : 0U);
+    }
+    else if (addr == 24U) {
+      value = value | 0x0FU;            // master volume
+    }
+    return (1U + (r[0] & 63U));
+  }
+};
+
+static inline uint32_t updateHash(uint32_t h, int value)
+{
+  return ((h ^ uint32_t(value)) * 0x01000193U);
+}
+
+static bool runSIDTest(int model, bool generateFlag)
+{
+  const char  *modelName = (model == 0 ? "6581" : "8580");
+  int32_t accA = 0;
+  int32_t accB = 0;
+  int32_t accC = 0;
+  Ep128::SID  sidA(accA);
+  Ep128::SID  sidB(accB);
+  Ep128::SID  sidC(accC);
+  Ep128::SID  *sids[3] = { &sidA, &sidB, &sidC };
+  for (int i = 0; i < 3; i++) {
+    sids[i]->set_chip_model(model == 0 ? Ep128::MOS6581 : Ep128::MOS8580);
+    sids[i]->adjust_filter_bias(0.0);
+    sids[i]->reset();
+  }
+  SIDTestWriter writer;
+  std::vector< int >  bufA(64);
+  std::vector< int >  bufB(64);
+  uint32_t  hashA = 0x811C9DC5U;
+  uint32_t  hashB = 0x811C9DC5U;
+  std::vector< uint32_t > chunkHashesA;
+  std::vector< uint32_t > chunkHashesB;
+  int     maxError = 0;
+  double  errorSum = 0.0;
+  double  signalSum = 0.0;
+  unsigned int  nSamples = 0U;
+  for (unsigned int n = 0U; n < sidTestCycles; ) {
+    unsigned int  addr = 0U;
+    unsigned int  value = 0U;
+    unsigned int  k = writer.nextWrite(addr, value);
+    if (k > (sidTestCycles - n))
+      k = sidTestCycles - n;
+    for (int i = 0; i < 3; i++)
+      sids[i]->write(Ep128::reg8(addr), Ep128::reg8(value));
+    for (unsigned int i = 0U; i < k; i++) {
+      accA = 0;
+      Ep128::SID::clockCallback(&sidA);
+      bufA[i] = int(accA >> 3);
+    }
+    if (!generateFlag) {
+      sidB.clock_block(Ep128::cycle_count(k), &(bufB.front()));
+      for (unsigned int i = 0U; i < k; ) {
+        unsigned int  j = k - i;
+        j = (j < fastModeBlockSize ? j : fastModeBlockSize);
+        accC = 0;
+        sidC.clock_fast(Ep128::cycle_count(j));
+        i += j;
+        int     err = int(accC >> 3) - bufA[i - 1];
+        err = (err >= 0 ? err : -err);
+        maxError = (err > maxError ? err : maxError);
+        errorSum += (double(err) * double(err));
+        signalSum += (double(bufA[i - 1]) * double(bufA[i - 1]));
+        nSamples++;
+      }
+    }
+    for (unsigned int i = 0U; i < k; i++) {
+      hashA = updateHash(hashA, bufA[i]);
+      hashB = updateHash(hashB, bufB[i]);
+      if (((n + i + 1U) % sidTestChunkSize) == 0U) {
+        chunkHashesA.push_back(hashA);
+        chunkHashesB.push_back(hashB);
+      }
+    }
+    n += k;
+  }
+  if (generateFlag) {
+    std::printf("  // %s\n  {", modelName);
+    for (unsigned int i = 0U; i < sidTestChunks; i++) {
+      std::printf("%s0x%08XU%s", ((i & 3U) == 0U ? "\n    " : " "),
+                  (unsigned int) chunkHashesA[i],
+                  (i < (sidTestChunks - 1U) ? "," : ""));
+    }
+    std::printf("\n  }%s\n", (model == 0 ? "," : ""));
+    return true;
+  }
+  bool    retval = true;
+  unsigned int  firstMismatchA = sidTestChunks;
+  unsigned int  firstMismatchB = sidTestChunks;
+  for (unsigned int i = sidTestChunks; i-- > 0U; ) {
+    if (chunkHashesA[i] != sidTestRefHashes[model][i])
+      firstMismatchA = i;
+    if (chunkHashesB[i] != sidTestRefHashes[model][i])
+      firstMismatchB = i;
+  }
+  double  rmsError = std::sqrt(errorSum / double(nSamples));
+  std::printf("%s %u cycles: clockCallback() %s, clock_block() %s, "
+              "clock_fast() max error %d, RMS error %.1f "
+              "(signal RMS %.1f)\n",
+              modelName, sidTestCycles,
+              (firstMismatchA < sidTestChunks ? "FAILED" : "ok"),
+              (firstMismatchB < sidTestChunks ? "FAILED" : "ok"),
+              maxError, rmsError, std::sqrt(signalSum / double(nSamples)));
+  if (firstMismatchA < sidTestChunks || firstMismatchB < sidTestChunks) {
+    unsigned int  i = (firstMismatchA < firstMismatchB ?
+                       firstMismatchA : firstMismatchB);
+    std::printf("%s: output differs from the reference from cycle %u\n",
+                modelName, i * sidTestChunkSize);
+    retval = false;
+  }
+  if (maxError > fastModeMaxError[model] ||
+      rmsError > fastModeRMSError[model]) {
+    std::printf("%s: clock_fast() error is over the limit (%d, %.1f)\n",
+                modelName, fastModeMaxError[model], fastModeRMSError[model]);
+    retval = false;
+  }
+  return retval;
+}
+
+int main(int argc, char **argv)
+{
+  bool    generateFlag = false;
+  if (argc > 1) {
+    if (argc > 2 || std::strcmp(argv[1], "-generate") != 0) {
+      std::fprintf(stderr, "Usage: %s [-generate]\n", argv[0]);
+      return -1;
+    }
+    generateFlag = true;
+  }
+  try {
+    bool    retval = true;
+    for (int model = 0; model < 2; model++) {
+      if (!runSIDTest(model, generateFlag))
+        retval = false;
+    }
+    return (retval ? 0 : 1);
+  }
+  catch (std::exception& e) {
+    std::fprintf(stderr, " *** error: %s\n", e.what());
+  }
+  return -1;
+}
+
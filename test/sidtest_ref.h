@@ -0,0 +1,30 @@
+// Reference hashes for test/sidtest.cpp: the filter output of each cycle of
+// SID::clockCallback(), hashed in chunks of 65536 cycles, with the reSID
+// code before SID::clock_block() was added. Generated with sidtest
+// -generate (built without the clock_block() and clock_fast() checks).
+
+static const uint32_t sidTestRefHashes[2][sidTestChunks] = {
+  // 6581
+  {
+    0xAD4474C7U, 0x0EB0EB99U, 0x322B69DAU, 0x30B6A841U,
+    0x01F0BE54U, 0x90649F1EU, 0x475513BCU, 0x2D92E763U,
+    0xEDFE9B7FU, 0x620AD853U, 0x0AADD2C2U, 0x4EFC6778U,
+    0x04C9A4A4U, 0x1AE3DA5BU, 0xDE1D8702U, 0x4B4802F2U,
+    0x498499EBU, 0x10EB9F80U, 0x0CA9A95FU, 0x1E163569U,
+    0xBA3A6FD9U, 0xD16B4E28U, 0x8561FA37U, 0xD916F2E7U,
+    0xFB814F0DU, 0xAB72E728U, 0x51E2A923U, 0x14920680U,
+    0xC730196BU, 0xECD7598CU, 0xC085C2CEU, 0x526F2D3BU
+  },
+  // 8580
+  {
+    0x7811DB5DU, 0xA9FC63A4U, 0x645174AFU, 0x635BDF09U,
+    0x1E396DB6U, 0x72B8FC18U, 0xEFC243ACU, 0x151E87D8U,
+    0x848DF845U, 0xFB82499CU, 0xAD139B78U, 0xE038AC6AU,
+    0xD6284F13U, 0xDA87E197U, 0x2F0837DEU, 0x481C5920U,
+    0x59B0A118U, 0xE3C07DDEU, 0x45DAB0BBU, 0xECF1A5C0U,
+    0x55CDE795U, 0x18B0F4D5U, 0x42BACDE3U, 0x6AD961B5U,
+    0xCD51730BU, 0xFA21D42AU, 0x63A73158U, 0xA78C505FU,
+    0x4471F0B1U, 0x7785E51CU, 0x56EEC141U, 0xE47B9B99U
+  }
+};
+
@@ -0,0 +1,793 @@
+// ep128emu-core -- libretro core version of the ep128emu emulator
+// Copyright (C) 2022 Zoltan Balogh
+// https://github.com/zoltanvb/ep128emu-core
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// Checksum test for the YV12 video capture: VideoCapture_YV12 and a
+// reference class that replaces the line decoding, frame interpolation and
+// resampling with the original scalar code (copied unchanged from the
+// version before the encoder loops were rewritten) are fed the same
+// synthetic input through the public interface, and the AVI files written
+// must be identical. The input covers all line formats (including invalid
+// ones), even and odd fields, and varying frame lengths, so that the frame
+// interpolation and duplicate frame detection are also used.
+//
+// Usage: vrectest [FRAMES]
+// The exit status is zero if the files match.
+
+#include "ep128emu.hpp"
+#include "fileio.hpp"
+#include "videorec.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace Ep128Emu {
+
+  class VideoCapture_YV12_Ref : public VideoCapture_YV12 {
+   private:
+    void decodeLineRef(int lineNum);
+    void frameDoneRef(const FrameData& frame);
+    void resampleFrameRef();
+    virtual void encodeFrame(FrameData& frame);
+   public:
+    VideoCapture_YV12_Ref(void indexToRGBFunc(uint8_t color,
+                                              float& r, float& g, float& b))
+      : VideoCapture_YV12(indexToRGBFunc)
+    {
+    }
+    virtual ~VideoCapture_YV12_Ref()
+    {
+      // the encoder thread must not call encodeFrame() after this
+      // destructor returns
+      openFile((char *) 0);
+    }
+  };
+
+  // --------------------------------------------------------------------------
+
+  void VideoCapture_YV12_Ref::encodeFrame(FrameData& frame)
+  {
+    size_t  pos = 0;
+    while (pos < frame.videoData.size()) {
+      const uint8_t *bufp = &(frame.videoData.front()) + pos;
+      int     lineNum = int(bufp[0]) | (int(bufp[1]) << 8);
+      size_t  nBytes = size_t(bufp[2]) | (size_t(bufp[3]) << 8);
+      if (nBytes > 0)
+        std::memcpy(lineBuf, bufp + 4, nBytes);
+      decodeLineRef(lineNum);
+      pos = pos + nBytes + 4;
+    }
+    curTime += frame.timeElapsed;
+    frameDoneRef(frame);
+  }
+
+  void VideoCapture_YV12_Ref::decodeLineRef(int lineNum)
+  {
+    int       offs = lineNum * videoWidth;
+    uint8_t   *yPtr = &(frameBuf1Y[offs]);
+    offs = (lineNum >> 1) * (videoWidth >> 1);
+    uint8_t   *vPtr = &(frameBuf1V[offs]);
+    uint8_t   *uPtr = &(frameBuf1U[offs]);
+    const uint8_t   *bufp = lineBuf;
+
+    if (!(lineNum & 1)) {
+      for (size_t i = 0; i < 48; i++) {
+        uint8_t c = *(bufp++);
+        switch (c) {
+        case 0x01:
+          {
+            uint32_t  tmp = colormap[*(bufp++)];
+            yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] =
+            yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
+            vPtr[3] = vPtr[2] = vPtr[1] = vPtr[0] =
+                uint8_t((tmp >> 20) & 0xFFU);
+            uPtr[3] = uPtr[2] = uPtr[1] = uPtr[0] =
+                uint8_t((tmp >> 10) & 0xFFU);
+          }
+          break;
+        case 0x02:
+          {
+            uint32_t  tmp = colormap[*(bufp++)];
+            yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
+            vPtr[1] = vPtr[0] = uint8_t((tmp >> 20) & 0xFFU);
+            uPtr[1] = uPtr[0] = uint8_t((tmp >> 10) & 0xFFU);
+            tmp = colormap[*(bufp++)];
+            yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] = uint8_t(tmp & 0xFFU);
+            vPtr[3] = vPtr[2] = uint8_t((tmp >> 20) & 0xFFU);
+            uPtr[3] = uPtr[2] = uint8_t((tmp >> 10) & 0xFFU);
+          }
+          break;
+        case 0x03:
+          {
+            unsigned char c0 = *(bufp++);
+            unsigned char c1 = *(bufp++);
+            unsigned char b = *(bufp++);
+            uint32_t  p0 = colormap[((b & 128) ? c1 : c0)];
+            uint32_t  p1 = colormap[((b &  64) ? c1 : c0)];
+            yPtr[0] = uint8_t(p0 & 0xFFU);
+            yPtr[1] = uint8_t(p1 & 0xFFU);
+            p0 = (p0 + p1) + 0x00100400U;
+            vPtr[0] = uint8_t((p0 >> 21) & 0xFFU);
+            uPtr[0] = uint8_t((p0 >> 11) & 0xFFU);
+            p0 = colormap[((b &  32) ? c1 : c0)];
+            p1 = colormap[((b &  16) ? c1 : c0)];
+            yPtr[2] = uint8_t(p0 & 0xFFU);
+            yPtr[3] = uint8_t(p1 & 0xFFU);
+            p0 = (p0 + p1) + 0x00100400U;
+            vPtr[1] = uint8_t((p0 >> 21) & 0xFFU);
+            uPtr[1] = uint8_t((p0 >> 11) & 0xFFU);
+            p0 = colormap[((b &   8) ? c1 : c0)];
+            p1 = colormap[((b &   4) ? c1 : c0)];
+            yPtr[4] = uint8_t(p0 & 0xFFU);
+            yPtr[5] = uint8_t(p1 & 0xFFU);
+            p0 = (p0 + p1) + 0x00100400U;
+            vPtr[2] = uint8_t((p0 >> 21) & 0xFFU);
+            uPtr[2] = uint8_t((p0 >> 11) & 0xFFU);
+            p0 = colormap[((b &   2) ? c1 : c0)];
+            p1 = colormap[((b &   1) ? c1 : c0)];
+            yPtr[6] = uint8_t(p0 & 0xFFU);
+            yPtr[7] = uint8_t(p1 & 0xFFU);
+            p0 = (p0 + p1) + 0x00100400U;
+            vPtr[3] = uint8_t((p0 >> 21) & 0xFFU);
+            uPtr[3] = uint8_t((p0 >> 11) & 0xFFU);
+          }
+          break;
+        case 0x04:
+          {
+            uint32_t  tmp = colormap[*(bufp++)];
+            yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
+            vPtr[0] = uint8_t((tmp >> 20) & 0xFFU);
+            uPtr[0] = uint8_t((tmp >> 10) & 0xFFU);
+            tmp = colormap[*(bufp++)];
+            yPtr[3] = yPtr[2] = uint8_t(tmp & 0xFFU);
+            vPtr[1] = uint8_t((tmp >> 20) & 0xFFU);
+            uPtr[1] = uint8_t((tmp >> 10) & 0xFFU);
+            tmp = colormap[*(bufp++)];
+            yPtr[5] = yPtr[4] = uint8_t(tmp & 0xFFU);
+            vPtr[2] = uint8_t((tmp >> 20) & 0xFFU);
+            uPtr[2] = uint8_t((tmp >> 10) & 0xFFU);
+            tmp = colormap[*(bufp++)];
+            yPtr[7] = yPtr[6] = uint8_t(tmp & 0xFFU);
+            vPtr[3] = uint8_t((tmp >> 20) & 0xFFU);
+            uPtr[3] = uint8_t((tmp >> 10) & 0xFFU);
+          }
+          break;
+        case 0x06:
+          {
+            unsigned char c0 = *(bufp++);
+            unsigned char c1 = *(bufp++);
+            unsigned char b = *(bufp++);
+            uint32_t  p0 = colormap[((b & 128) ? c1 : c0)];
+            uint32_t  p1 = colormap[((b &  64) ? c1 : c0)];
+            uint32_t  p2 = colormap[((b &  32) ? c1 : c0)];
+            uint32_t  p3 = colormap[((b &  16) ? c1 : c0)];
+            yPtr[0] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+            yPtr[1] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+            vPtr[0] = uint8_t((p0 >> 22) & 0xFFU);
+            uPtr[0] = uint8_t((p0 >> 12) & 0xFFU);
+            p0 = colormap[((b &   8) ? c1 : c0)];
+            p1 = colormap[((b &   4) ? c1 : c0)];
+            p2 = colormap[((b &   2) ? c1 : c0)];
+            p3 = colormap[((b &   1) ? c1 : c0)];
+            yPtr[2] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+            yPtr[3] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+            vPtr[1] = uint8_t((p0 >> 22) & 0xFFU);
+            uPtr[1] = uint8_t((p0 >> 12) & 0xFFU);
+            c0 = *(bufp++);
+            c1 = *(bufp++);
+            b = *(bufp++);
+            p0 = colormap[((b & 128) ? c1 : c0)];
+            p1 = colormap[((b &  64) ? c1 : c0)];
+            p2 = colormap[((b &  32) ? c1 : c0)];
+            p3 = colormap[((b &  16) ? c1 : c0)];
+            yPtr[4] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+            yPtr[5] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+            vPtr[2] = uint8_t((p0 >> 22) & 0xFFU);
+            uPtr[2] = uint8_t((p0 >> 12) & 0xFFU);
+            p0 = colormap[((b &   8) ? c1 : c0)];
+            p1 = colormap[((b &   4) ? c1 : c0)];
+            p2 = colormap[((b &   2) ? c1 : c0)];
+            p3 = colormap[((b &   1) ? c1 : c0)];
+            yPtr[6] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+            yPtr[7] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+            vPtr[3] = uint8_t((p0 >> 22) & 0xFFU);
+            uPtr[3] = uint8_t((p0 >> 12) & 0xFFU);
+          }
+          break;
+        case 0x08:
+          {
+            uint32_t  p0 = colormap[*(bufp++)];
+            uint32_t  p1 = colormap[*(bufp++)];
+            yPtr[0] = uint8_t(p0 & 0xFFU);
+            yPtr[1] = uint8_t(p1 & 0xFFU);
+            p0 = (p0 + p1) + 0x00100400U;
+            vPtr[0] = uint8_t((p0 >> 21) & 0xFFU);
+            uPtr[0] = uint8_t((p0 >> 11) & 0xFFU);
+            p0 = colormap[*(bufp++)];
+            p1 = colormap[*(bufp++)];
+            yPtr[2] = uint8_t(p0 & 0xFFU);
+            yPtr[3] = uint8_t(p1 & 0xFFU);
+            p0 = (p0 + p1) + 0x00100400U;
+            vPtr[1] = uint8_t((p0 >> 21) & 0xFFU);
+            uPtr[1] = uint8_t((p0 >> 11) & 0xFFU);
+            p0 = colormap[*(bufp++)];
+            p1 = colormap[*(bufp++)];
+            yPtr[4] = uint8_t(p0 & 0xFFU);
+            yPtr[5] = uint8_t(p1 & 0xFFU);
+            p0 = (p0 + p1) + 0x00100400U;
+            vPtr[2] = uint8_t((p0 >> 21) & 0xFFU);
+            uPtr[2] = uint8_t((p0 >> 11) & 0xFFU);
+            p0 = colormap[*(bufp++)];
+            p1 = colormap[*(bufp++)];
+            yPtr[6] = uint8_t(p0 & 0xFFU);
+            yPtr[7] = uint8_t(p1 & 0xFFU);
+            p0 = (p0 + p1) + 0x00100400U;
+            vPtr[3] = uint8_t((p0 >> 21) & 0xFFU);
+            uPtr[3] = uint8_t((p0 >> 11) & 0xFFU);
+          }
+          break;
+        case 0x10:
+          {
+            uint32_t  p0 = colormap[*(bufp++)];
+            uint32_t  p1 = colormap[*(bufp++)];
+            uint32_t  p2 = colormap[*(bufp++)];
+            uint32_t  p3 = colormap[*(bufp++)];
+            yPtr[0] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+            yPtr[1] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+            vPtr[0] = uint8_t((p0 >> 22) & 0xFFU);
+            uPtr[0] = uint8_t((p0 >> 12) & 0xFFU);
+            p0 = colormap[*(bufp++)];
+            p1 = colormap[*(bufp++)];
+            p2 = colormap[*(bufp++)];
+            p3 = colormap[*(bufp++)];
+            yPtr[2] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+            yPtr[3] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+            vPtr[1] = uint8_t((p0 >> 22) & 0xFFU);
+            uPtr[1] = uint8_t((p0 >> 12) & 0xFFU);
+            p0 = colormap[*(bufp++)];
+            p1 = colormap[*(bufp++)];
+            p2 = colormap[*(bufp++)];
+            p3 = colormap[*(bufp++)];
+            yPtr[4] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+            yPtr[5] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+            vPtr[2] = uint8_t((p0 >> 22) & 0xFFU);
+            uPtr[2] = uint8_t((p0 >> 12) & 0xFFU);
+            p0 = colormap[*(bufp++)];
+            p1 = colormap[*(bufp++)];
+            p2 = colormap[*(bufp++)];
+            p3 = colormap[*(bufp++)];
+            yPtr[6] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+            yPtr[7] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+            vPtr[3] = uint8_t((p0 >> 22) & 0xFFU);
+            uPtr[3] = uint8_t((p0 >> 12) & 0xFFU);
+          }
+          break;
+        default:
+          yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] =
+          yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = 0x00;
+          vPtr[3] = vPtr[2] = vPtr[1] = vPtr[0] = 0x00;
+          uPtr[3] = uPtr[2] = uPtr[1] = uPtr[0] = 0x00;
+          break;
+        }
+        yPtr = yPtr + 8;
+        vPtr = vPtr + 4;
+        uPtr = uPtr + 4;
+      }
+    }
+    else {
+      for (size_t i = 0; i < 48; i++) {
+        uint8_t c = *(bufp++);
+        switch (c) {
+        case 0x01:
+          {
+            uint32_t  tmp = colormap[*(bufp++)];
+            yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] =
+            yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
+            uint32_t  v = (tmp >> 20) & 0xFFU;
+            uint32_t  u = (tmp >> 10) & 0xFFU;
+            vPtr[0] = uint8_t((uint32_t(vPtr[0]) + v + 1U) >> 1);
+            vPtr[1] = uint8_t((uint32_t(vPtr[1]) + v + 1U) >> 1);
+            vPtr[2] = uint8_t((uint32_t(vPtr[2]) + v + 1U) >> 1);
+            vPtr[3] = uint8_t((uint32_t(vPtr[3]) + v + 1U) >> 1);
+            uPtr[0] = uint8_t((uint32_t(uPtr[0]) + u + 1U) >> 1);
+            uPtr[1] = uint8_t((uint32_t(uPtr[1]) + u + 1U) >> 1);
+            uPtr[2] = uint8_t((uint32_t(uPtr[2]) + u + 1U) >> 1);
+            uPtr[3] = uint8_t((uint32_t(uPtr[3]) + u + 1U) >> 1);
+          }
+          break;
+        case 0x02:
+          {
+            uint32_t  tmp = colormap[*(bufp++)];
+            yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
+            uint32_t  v = (tmp >> 20) & 0xFFU;
+            uint32_t  u = (tmp >> 10) & 0xFFU;
+            vPtr[0] = uint8_t((uint32_t(vPtr[0]) + v + 1U) >> 1);
+            vPtr[1] = uint8_t((uint32_t(vPtr[1]) + v + 1U) >> 1);
+            uPtr[0] = uint8_t((uint32_t(uPtr[0]) + u + 1U) >> 1);
+            uPtr[1] = uint8_t((uint32_t(uPtr[1]) + u + 1U) >> 1);
+            tmp = colormap[*(bufp++)];
+            yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] = uint8_t(tmp & 0xFFU);
+            v = (tmp >> 20) & 0xFFU;
+            u = (tmp >> 10) & 0xFFU;
+            vPtr[2] = uint8_t((uint32_t(vPtr[2]) + v + 1U) >> 1);
+            vPtr[3] = uint8_t((uint32_t(vPtr[3]) + v + 1U) >> 1);
+            uPtr[2] = uint8_t((uint32_t(uPtr[2]) + u + 1U) >> 1);
+            uPtr[3] = uint8_t((uint32_t(uPtr[3]) + u + 1U) >> 1);
+          }
+          break;
+        case 0x03:
+          {
+            unsigned char c0 = *(bufp++);
+            unsigned char c1 = *(bufp++);
+            unsigned char b = *(bufp++);
+            uint32_t  p0 = colormap[((b & 128) ? c1 : c0)];
+            uint32_t  p1 = colormap[((b &  64) ? c1 : c0)];
+            yPtr[0] = uint8_t(p0 & 0xFFU);
+            yPtr[1] = uint8_t(p1 & 0xFFU);
+            p0 = (p0 + p1) + 0x00100400U;
+            vPtr[0] =
+                uint8_t((uint32_t(vPtr[0]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
+            uPtr[0] =
+                uint8_t((uint32_t(uPtr[0]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
+            p0 = colormap[((b &  32) ? c1 : c0)];
+            p1 = colormap[((b &  16) ? c1 : c0)];
+            yPtr[2] = uint8_t(p0 & 0xFFU);
+            yPtr[3] = uint8_t(p1 & 0xFFU);
+            p0 = (p0 + p1) + 0x00100400U;
+            vPtr[1] =
+                uint8_t((uint32_t(vPtr[1]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
+            uPtr[1] =
+                uint8_t((uint32_t(uPtr[1]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
+            p0 = colormap[((b &   8) ? c1 : c0)];
+            p1 = colormap[((b &   4) ? c1 : c0)];
+            yPtr[4] = uint8_t(p0 & 0xFFU);
+            yPtr[5] = uint8_t(p1 & 0xFFU);
+            p0 = (p0 + p1) + 0x00100400U;
+            vPtr[2] =
+                uint8_t((uint32_t(vPtr[2]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
+            uPtr[2] =
+                uint8_t((uint32_t(uPtr[2]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
+            p0 = colormap[((b &   2) ? c1 : c0)];
+            p1 = colormap[((b &   1) ? c1 : c0)];
+            yPtr[6] = uint8_t(p0 & 0xFFU);
+            yPtr[7] = uint8_t(p1 & 0xFFU);
+            p0 = (p0 + p1) + 0x00100400U;
+            vPtr[3] =
+                uint8_t((uint32_t(vPtr[3]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
+            uPtr[3] =
+                uint8_t((uint32_t(uPtr[3]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
+          }
+          break;
+        case 0x04:
+          {
+            uint32_t  tmp = colormap[*(bufp++)];
+            yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
+            uint32_t  v = (tmp >> 20) & 0xFFU;
+            uint32_t  u = (tmp >> 10) & 0xFFU;
+            vPtr[0] = uint8_t((uint32_t(vPtr[0]) + v + 1U) >> 1);
+            uPtr[0] = uint8_t((uint32_t(uPtr[0]) + u + 1U) >> 1);
+            tmp = colormap[*(bufp++)];
+            yPtr[3] = yPtr[2] = uint8_t(tmp & 0xFFU);
+            v = (tmp >> 20) & 0xFFU;
+            u = (tmp >> 10) & 0xFFU;
+            vPtr[1] = uint8_t((uint32_t(vPtr[1]) + v + 1U) >> 1);
+            uPtr[1] = uint8_t((uint32_t(uPtr[1]) + u + 1U) >> 1);
+            tmp = colormap[*(bufp++)];
+            yPtr[5] = yPtr[4] = uint8_t(tmp & 0xFFU);
+            v = (tmp >> 20) & 0xFFU;
+            u = (tmp >> 10) & 0xFFU;
+            vPtr[2] = uint8_t((uint32_t(vPtr[2]) + v + 1U) >> 1);
+            uPtr[2] = uint8_t((uint32_t(uPtr[2]) + u + 1U) >> 1);
+            tmp = colormap[*(bufp++)];
+            yPtr[7] = yPtr[6] = uint8_t(tmp & 0xFFU);
+            v = (tmp >> 20) & 0xFFU;
+            u = (tmp >> 10) & 0xFFU;
+            vPtr[3] = uint8_t((uint32_t(vPtr[3]) + v + 1U) >> 1);
+            uPtr[3] = uint8_t((uint32_t(uPtr[3]) + u + 1U) >> 1);
+          }
+          break;
+        case 0x06:
+          {
+            unsigned char c0 = *(bufp++);
+            unsigned char c1 = *(bufp++);
+            unsigned char b = *(bufp++);
+            uint32_t  p0 = colormap[((b & 128) ? c1 : c0)];
+            uint32_t  p1 = colormap[((b &  64) ? c1 : c0)];
+            uint32_t  p2 = colormap[((b &  32) ? c1 : c0)];
+            uint32_t  p3 = colormap[((b &  16) ? c1 : c0)];
+            yPtr[0] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+            yPtr[1] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+            vPtr[0] =
+                uint8_t((uint32_t(vPtr[0]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
+            uPtr[0] =
+                uint8_t((uint32_t(uPtr[0]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
+            p0 = colormap[((b &   8) ? c1 : c0)];
+            p1 = colormap[((b &   4) ? c1 : c0)];
+            p2 = colormap[((b &   2) ? c1 : c0)];
+            p3 = colormap[((b &   1) ? c1 : c0)];
+            yPtr[2] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+            yPtr[3] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+            vPtr[1] =
+                uint8_t((uint32_t(vPtr[1]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
+            uPtr[1] =
+                uint8_t((uint32_t(uPtr[1]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
+            c0 = *(bufp++);
+            c1 = *(bufp++);
+            b = *(bufp++);
+            p0 = colormap[((b & 128) ? c1 : c0)];
+            p1 = colormap[((b &  64) ? c1 : c0)];
+            p2 = colormap[((b &  32) ? c1 : c0)];
+            p3 = colormap[((b &  16) ? c1 : c0)];
+            yPtr[4] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+            yPtr[5] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+            vPtr[2] =
+                uint8_t((uint32_t(vPtr[2]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
+            uPtr[2] =
+                uint8_t((uint32_t(uPtr[2]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
+            p0 = colormap[((b &   8) ? c1 : c0)];
+            p1 = colormap[((b &   4) ? c1 : c0)];
+            p2 = colormap[((b &   2) ? c1 : c0)];
+            p3 = colormap[((b &   1) ? c1 : c0)];
+            yPtr[6] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+            yPtr[7] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+            vPtr[3] =
+                uint8_t((uint32_t(vPtr[3]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
+            uPtr[3] =
+                uint8_t((uint32_t(uPtr[3]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
+          }
+          break;
+        case 0x08:
+          {
+            uint32_t  p0 = colormap[*(bufp++)];
+            uint32_t  p1 = colormap[*(bufp++)];
+            yPtr[0] = uint8_t(p0 & 0xFFU);
+            yPtr[1] = uint8_t(p1 & 0xFFU);
+            p0 = (p0 + p1) + 0x00100400U;
+            vPtr[0] =
+                uint8_t((uint32_t(vPtr[0]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
+            uPtr[0] =
+                uint8_t((uint32_t(uPtr[0]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
+            p0 = colormap[*(bufp++)];
+            p1 = colormap[*(bufp++)];
+            yPtr[2] = uint8_t(p0 & 0xFFU);
+            yPtr[3] = uint8_t(p1 & 0xFFU);
+            p0 = (p0 + p1) + 0x00100400U;
+            vPtr[1] =
+                uint8_t((uint32_t(vPtr[1]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
+            uPtr[1] =
+                uint8_t((uint32_t(uPtr[1]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
+            p0 = colormap[*(bufp++)];
+            p1 = colormap[*(bufp++)];
+            yPtr[4] = uint8_t(p0 & 0xFFU);
+            yPtr[5] = uint8_t(p1 & 0xFFU);
+            p0 = (p0 + p1) + 0x00100400U;
+            vPtr[2] =
+                uint8_t((uint32_t(vPtr[2]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
+            uPtr[2] =
+                uint8_t((uint32_t(uPtr[2]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
+            p0 = colormap[*(bufp++)];
+            p1 = colormap[*(bufp++)];
+            yPtr[6] = uint8_t(p0 & 0xFFU);
+            yPtr[7] = uint8_t(p1 & 0xFFU);
+            p0 = (p0 + p1) + 0x00100400U;
+            vPtr[3] =
+                uint8_t((uint32_t(vPtr[3]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
+            uPtr[3] =
+                uint8_t((uint32_t(uPtr[3]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
+          }
+          break;
+        case 0x10:
+          {
+            uint32_t  p0 = colormap[*(bufp++)];
+            uint32_t  p1 = colormap[*(bufp++)];
+            uint32_t  p2 = colormap[*(bufp++)];
+            uint32_t  p3 = colormap[*(bufp++)];
+            yPtr[0] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+            yPtr[1] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+            vPtr[0] =
+                uint8_t((uint32_t(vPtr[0]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
+            uPtr[0] =
+                uint8_t((uint32_t(uPtr[0]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
+            p0 = colormap[*(bufp++)];
+            p1 = colormap[*(bufp++)];
+            p2 = colormap[*(bufp++)];
+            p3 = colormap[*(bufp++)];
+            yPtr[2] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+            yPtr[3] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+            vPtr[1] =
+                uint8_t((uint32_t(vPtr[1]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
+            uPtr[1] =
+                uint8_t((uint32_t(uPtr[1]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
+            p0 = colormap[*(bufp++)];
+            p1 = colormap[*(bufp++)];
+            p2 = colormap[*(bufp++)];
+            p3 = colormap[*(bufp++)];
+            yPtr[4] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+            yPtr[5] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+            vPtr[2] =
+                uint8_t((uint32_t(vPtr[2]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
+            uPtr[2] =
+                uint8_t((uint32_t(uPtr[2]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
+            p0 = colormap[*(bufp++)];
+            p1 = colormap[*(bufp++)];
+            p2 = colormap[*(bufp++)];
+            p3 = colormap[*(bufp++)];
+            yPtr[6] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+            yPtr[7] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+            vPtr[3] =
+                uint8_t((uint32_t(vPtr[3]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
+            uPtr[3] =
+                uint8_t((uint32_t(uPtr[3]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
+          }
+          break;
+        default:
+          yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] =
+          yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = 0x00;
+          vPtr[0] = uint8_t((uint32_t(vPtr[0]) + 1U) >> 1);
+          vPtr[1] = uint8_t((uint32_t(vPtr[1]) + 1U) >> 1);
+          vPtr[2] = uint8_t((uint32_t(vPtr[2]) + 1U) >> 1);
+          vPtr[3] = uint8_t((uint32_t(vPtr[3]) + 1U) >> 1);
+          uPtr[0] = uint8_t((uint32_t(uPtr[0]) + 1U) >> 1);
+          uPtr[1] = uint8_t((uint32_t(uPtr[1]) + 1U) >> 1);
+          uPtr[2] = uint8_t((uint32_t(uPtr[2]) + 1U) >> 1);
+          uPtr[3] = uint8_t((uint32_t(uPtr[3]) + 1U) >> 1);
+          break;
+        }
+        yPtr = yPtr + 8;
+        vPtr = vPtr + 4;
+        uPtr = uPtr + 4;
+      }
+    }
+  }
+
+  void VideoCapture_YV12_Ref::frameDoneRef(const FrameData& frame)
+  {
+    resampleFrameRef();
+    for (int j = 0; j < frame.outputFrames; j++) {
+      int64_t   frameTime =
+          int64_t((4294967296000000.0 / double(frameRate)) + 0.5);
+      if (frameTime > frame1Time)
+        frameTime = frame1Time;
+      int32_t   t0 =
+          int32_t(((frameTime - frame0Time) + int64_t(0x80000000UL)) >> 32);
+      int32_t   t1 =
+          int32_t(((frame1Time - frameTime) + int64_t(0x80000000UL)) >> 32);
+      double    tt = 3.1415926535898 * (double(t1) / (double(t0) + double(t1)));
+      tt = 0.3183098861838 * (tt - std::sin(tt));
+      int32_t   scaleFac0 = int32_t(double(t1) * tt + 0.5);
+      int32_t   scaleFac1 = int32_t(double(t1) * (2.0 - tt) + 0.5);
+      int32_t   outScale = int32_t(0x20000000) / (interpTime - t1);
+      interpTime = t1;
+      int       n = (videoWidth * videoHeight * 3) / 2;
+      int       i = 0;
+      uint8_t   frameChanged = 0x00;
+      do {
+        int32_t   tmp;
+        uint8_t   tmp2;
+        tmp = (int32_t(frameBuf0Y[i]) * scaleFac0)
+              + (int32_t(frameBuf1Y[i]) * scaleFac1);
+        tmp2 = uint8_t(((((interpBufY[i] - tmp) >> 8) * outScale)
+                        + 0x00200000) >> 22);
+        interpBufY[i] = tmp;
+        frameChanged |= (tmp2 ^ outBufY[i]);
+        outBufY[i] = tmp2;
+        i++;
+        tmp = (int32_t(frameBuf0Y[i]) * scaleFac0)
+              + (int32_t(frameBuf1Y[i]) * scaleFac1);
+        tmp2 = uint8_t(((((interpBufY[i] - tmp) >> 8) * outScale)
+                        + 0x00200000) >> 22);
+        interpBufY[i] = tmp;
+        frameChanged |= (tmp2 ^ outBufY[i]);
+        outBufY[i] = tmp2;
+      } while (++i < n);
+      writeFrame(bool(frameChanged),
+                 &(frame.audioData.front()) + (j * audioBufSize * 2));
+      frame0Time -= frameTime;
+      frame1Time -= frameTime;
+      curTime -= frameTime;
+    }
+    int64_t   frameTime =
+        ((int64_t(frame.audioBufSamples * 5000) << 32)
+         + int64_t(sampleRate / 200))
+        / int64_t(sampleRate / 100);
+    curTime += (frameTime - frame1Time);
+    frame0Time += (frameTime - frame1Time);
+    frame1Time = frameTime;
+    uint8_t   *tmp = frameBuf0Y;
+    frameBuf0Y = frameBuf1Y;
+    frameBuf1Y = tmp;
+    tmp = frameBuf0V;
+    frameBuf0V = frameBuf1V;
+    frameBuf1V = tmp;
+    tmp = frameBuf0U;
+    frameBuf0U = frameBuf1U;
+    frameBuf1U = tmp;
+    std::memset(frameBuf1Y, 0x10, size_t(videoWidth * videoHeight));
+    std::memset(frameBuf1V, 0x80,
+                size_t((videoWidth >> 1) * (videoHeight >> 1)));
+    std::memset(frameBuf1U, 0x80,
+                size_t((videoWidth >> 1) * (videoHeight >> 1)));
+  }
+
+  void VideoCapture_YV12_Ref::resampleFrameRef()
+  {
+    frame0Time = frame1Time;
+    frame1Time = curTime;
+    int32_t   scaleFac =
+        int32_t(((frame1Time - frame0Time) + int64_t(0x80000000UL)) >> 32);
+    interpTime += scaleFac;
+    int       n = (videoWidth * videoHeight * 3) / 2;
+    int       i = 0;
+    do {
+      interpBufY[i] +=
+          ((int32_t(frameBuf0Y[i]) + int32_t(frameBuf1Y[i])) * scaleFac);
+      i++;
+      interpBufY[i] +=
+          ((int32_t(frameBuf0Y[i]) + int32_t(frameBuf1Y[i])) * scaleFac);
+    } while (++i < n);
+  }
+
+}       // namespace Ep128Emu
+
+// ----------------------------------------------------------------------------
+
+static uint32_t randomSeed = 12345U;
+
+static uint32_t randomValue()
+{
+  randomSeed = (randomSeed * 1103515245U) + 12345U;
+  return (randomSeed >> 8);
+}
+
+static void indexToRGB(uint8_t color, float& r, float& g, float& b)
+{
+  // 3-3-2 bit RGB, similar to the Enterprise palette
+  r = float(color & 0x07) / 7.0f;
+  g = float((color >> 3) & 0x07) / 7.0f;
+  b = float((color >> 6) & 0x03) / 3.0f;
+}
+
+// line formats, with the number of data bytes after the format byte,
+// 0x00 is invalid (decoded as black)
+static const unsigned char  lineFormats[8] = {
+  0x01, 0x02, 0x03, 0x04, 0x06, 0x08, 0x10, 0x00
+};
+
+static size_t generateLine(unsigned char *buf, int frameNum, int lineNum)
+{
+  size_t  nBytes = 0;
+  uint32_t  savedSeed = randomSeed;
+  randomSeed = uint32_t((frameNum * 1000) + lineNum) * 2654435761U;
+  for (int i = 0; i < 48; i++) {
+    unsigned char c = lineFormats[((randomValue() >> 4) + uint32_t(i)) & 7];
+    buf[nBytes++] = c;
+    for (unsigned char j = 0; j < c; j++)
+      buf[nBytes++] = (unsigned char) (randomValue() & 0xFFU);
+  }
+  randomSeed = savedSeed;
+  return nBytes;
+}
+
+static void errorCallback(void *userData, const char *msg)
+{
+  std::fprintf(stderr, "vrectest: %s\n", msg);
+  *(reinterpret_cast<bool *>(userData)) = true;
+}
+
+int main(int argc, char **argv)
+{
+  int     nFrames = 100;
+  if (argc > 1)
+    nFrames = std::atoi(argv[1]);
+  const char  *fileNames[2] = { "vrectest_new.avi", "vrectest_ref.avi" };
+  bool    errorFlag = false;
+  std::vector< unsigned char >  fileData[2];
+  try {
+    Ep128Emu::VideoCapture  *videoCapture[2];
+    videoCapture[0] = new Ep128Emu::VideoCapture_YV12(&indexToRGB);
+    videoCapture[1] = new Ep128Emu::VideoCapture_YV12_Ref(&indexToRGB);
+    for (int i = 0; i < 2; i++) {
+      videoCapture[i]->setErrorCallback(&errorCallback, &errorFlag);
+      videoCapture[i]->openFile(fileNames[i]);
+    }
+    unsigned char lineBuf[48 * 17];
+    for (int frameNum = 0; frameNum < nFrames; frameNum++) {
+      // 310 to 314 lines, odd fields on every third frame
+      int     n = frameNum;
+      int     nLines = 310 + (frameNum % 5);
+      unsigned int  vsyncSlot = ((frameNum % 3) == 2 ? 30U : 10U);
+      if ((frameNum % 50) >= 30) {
+        // still image, the encoder writes duplicate frames after the
+        // interpolation has settled
+        n = frameNum - (frameNum % 50);
+        nLines = 312;
+        vsyncSlot = 10U;
+      }
+      for (int lineNum = 0; lineNum < nLines; lineNum++) {
+        for (int i = 0; i < 57; i++) {
+          uint32_t  audioInput = randomValue();
+          for (int j = 0; j < 2; j++)
+            videoCapture[j]->runOneCycle(audioInput);
+        }
+        size_t  nBytes = generateLine(&(lineBuf[0]), n, lineNum);
+        for (int j = 0; j < 2; j++) {
+          if (lineNum == 0)
+            videoCapture[j]->vsyncStateChange(true, vsyncSlot);
+          else if (lineNum == 3)
+            videoCapture[j]->vsyncStateChange(false, 0U);
+          videoCapture[j]->horizontalSync(&(lineBuf[0]), nBytes);
+        }
+      }
+    }
+    for (int i = 0; i < 2; i++) {
+      videoCapture[i]->openFile((char *) 0);
+      delete videoCapture[i];
+    }
+    for (int i = 0; i < 2; i++) {
+      std::FILE *f = Ep128Emu::fileOpen(fileNames[i], "rb");
+      if (!f)
+        throw Ep128Emu::Exception("error opening AVI file");
+      int     c;
+      while ((c = std::fgetc(f)) != EOF)
+        fileData[i].push_back((unsigned char) c);
+      std::fclose(f);
+      std::remove(fileNames[i]);
+    }
+  }
+  catch (std::exception& e) {
+    std::fprintf(stderr, "vrectest: %s\n", e.what());
+    return 1;
+  }
+  if (errorFlag)
+    return 1;
+  uint32_t  h[2] = { 0U, 0U };
+  for (int i = 0; i < 2; i++) {
+    if (fileData[i].size() > 0)
+      h[i] = Ep128Emu::File::hash_32(&(fileData[i].front()),
+                                     fileData[i].size());
+  }
+  std::printf("vrectest: %d frames, %lu bytes, hash %08X (reference: "
+              "%lu bytes, hash %08X)\n",
+              nFrames, (unsigned long) fileData[0].size(), (unsigned int) h[0],
+              (unsigned long) fileData[1].size(), (unsigned int) h[1]);
+  if (fileData[0].size() <= 0x2000 || fileData[0] != fileData[1]) {
+    std::printf("vrectest: FAILED\n");
+    return 1;
+  }
+  std::printf("vrectest: ok\n");
+  return 0;
+}
+
@@ -21,6 +21,7 @@
 /* Istvan Varga, 2004, 2007, 2009: fixed opcode cycle counts */
 
 #include "z80.hpp"
+#include "perfcnt.hpp"
 
 #include "z80macros.hpp"
 #include "z80funcs.hpp"
@@ -5000,6 +5001,7 @@ namespace Ep128 {
   /***************************************************************************/
   void Z80::executeInstruction()
   {
+    EP128EMU_PERF_SCOPE(PERF_Z80_INSTRUCTION, 8);
     uint8_t Opcode;
     Opcode = readOpcodeFirstByte();
     switch (Opcode) {
@@ -311,6 +311,15 @@ namespace Ep128 {
      * Read a byte from an I/O port (4 cycles).
      */
     virtual EP128EMU_REGPARM2 uint8_t doIn(uint16_t addr);
+    // NOTE: opcode and operand bytes are always fetched through the
+    // following functions, and are not cached or predecoded: each fetch is
+    // a separate bus access, and the machines add wait states to it that
+    // depend on the exact video cycle (see for example
+    // Ep128VM::videoMemoryWait_M1()), or run the video emulation from it
+    // (TVC64VM::memoryWaitM1()). A decoded instruction would still need all
+    // of these calls, so caching would only save the byte read from the
+    // segment table, which costs less than a cache lookup plus invalidation
+    // on memory writes.
     /*!
      * Read the first byte of an opcode (4 cycles).
      */